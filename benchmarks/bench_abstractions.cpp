@@ -140,6 +140,54 @@ static void BM_Pool_Batch(benchmark::State &state) {
 }
 BENCHMARK(BM_Pool_Batch);
 
+// =============================================================================
+// Compile-time Size Dispatch: alloc_fixed<N> vs alloc_bytes
+// =============================================================================
+
+template <size_t N> static void BM_Fixed_AllocFree(benchmark::State &state) {
+    Cell::Context ctx;
+    const size_t batch_size = 16;
+    void *ptrs[batch_size];
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch_size; ++i) {
+            ptrs[i] = ctx.alloc_fixed<N>();
+        }
+        benchmark::DoNotOptimize(ptrs);
+        for (size_t i = 0; i < batch_size; ++i) {
+            ctx.free_fixed<N>(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK_TEMPLATE(BM_Fixed_AllocFree, 16);
+BENCHMARK_TEMPLATE(BM_Fixed_AllocFree, 64);
+BENCHMARK_TEMPLATE(BM_Fixed_AllocFree, 256);
+BENCHMARK_TEMPLATE(BM_Fixed_AllocFree, 1024);
+BENCHMARK_TEMPLATE(BM_Fixed_AllocFree, 4096);
+
+template <size_t N> static void BM_Bytes_AllocFree(benchmark::State &state) {
+    Cell::Context ctx;
+    const size_t batch_size = 16;
+    void *ptrs[batch_size];
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch_size; ++i) {
+            ptrs[i] = ctx.alloc_bytes(N);
+        }
+        benchmark::DoNotOptimize(ptrs);
+        for (size_t i = 0; i < batch_size; ++i) {
+            ctx.free_bytes(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK_TEMPLATE(BM_Bytes_AllocFree, 16);
+BENCHMARK_TEMPLATE(BM_Bytes_AllocFree, 64);
+BENCHMARK_TEMPLATE(BM_Bytes_AllocFree, 256);
+BENCHMARK_TEMPLATE(BM_Bytes_AllocFree, 1024);
+BENCHMARK_TEMPLATE(BM_Bytes_AllocFree, 4096);
+
 // =============================================================================
 // Comparison: new/delete
 // =============================================================================
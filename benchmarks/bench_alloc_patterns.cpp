@@ -2,9 +2,14 @@
 #include <cell/context.h>
 
 #include <cstdlib>
+#include <memory>
 #include <random>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
 // =============================================================================
 // Small Allocations (TLS Cache Hot Path: 16B - 128B)
 // =============================================================================
@@ -270,3 +275,191 @@ static void BM_Cell_Realloc_Growth(benchmark::State &state) {
     state.SetItemsProcessed(state.iterations() * 8); // 8 reallocs per iteration
 }
 BENCHMARK(BM_Cell_Realloc_Growth);
+
+// =============================================================================
+// Decommit + Immediate Reuse (Release Policy Comparison)
+// Arg 0: ReleasePolicy::kDecommit, Arg 1: ReleasePolicy::kLazyFree.
+// Each iteration touches every page of 4 superblocks of cells, frees them,
+// decommits, and reallocates on the next iteration. "faults" reports minor
+// page faults per iteration (0 where getrusage is unavailable).
+// =============================================================================
+
+static long minor_faults() {
+#if !defined(_WIN32)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+#else
+    return 0;
+#endif
+}
+
+static void BM_Cell_DecommitThenRealloc(benchmark::State &state) {
+    Cell::Config config;
+    config.release_policy =
+        state.range(0) ? Cell::ReleasePolicy::kLazyFree : Cell::ReleasePolicy::kDecommit;
+    Cell::Context ctx(config);
+
+    constexpr size_t kPageSize = 4096;
+    const size_t count = Cell::kCellsPerSuperblock * 4;
+    std::vector<Cell::CellData *> cells(count);
+
+    long faults_before = minor_faults();
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            cells[i] = ctx.alloc_cell();
+            auto *bytes = reinterpret_cast<char *>(cells[i]);
+            for (size_t off = kPageSize; off < Cell::kCellSize; off += kPageSize) {
+                bytes[off] = static_cast<char>(i);
+            }
+        }
+        benchmark::DoNotOptimize(cells.data());
+
+        for (size_t i = 0; i < count; ++i) {
+            ctx.free_cell(cells[i]);
+        }
+        ctx.decommit_unused();
+    }
+    long faults = minor_faults() - faults_before;
+
+    state.SetLabel(state.range(0) ? "lazy_free" : "decommit");
+    state.counters["faults"] =
+        benchmark::Counter(static_cast<double>(faults), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Cell_DecommitThenRealloc)->Arg(0)->Arg(1);
+
+// =============================================================================
+// Cache Policy Sweeps
+// Each benchmark builds its Context from a Config whose cache policy comes
+// from the benchmark arguments, so policies can be compared without
+// rebuilding the library.
+// =============================================================================
+
+// Args: tls_bin_cache_capacity, tls_bin_batch_refill.
+// Bursts of 64B allocations overflow and refill the TLS bin cache.
+static void BM_Cell_Policy_TlsBinCache(benchmark::State &state) {
+    Cell::Config config;
+    config.tls_bin_cache_capacity = static_cast<size_t>(state.range(0));
+    config.tls_bin_batch_refill = static_cast<size_t>(state.range(1));
+    Cell::Context ctx(config);
+
+    constexpr size_t kBurst = 256;
+    std::vector<void *> ptrs(kBurst);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBurst; ++i) {
+            ptrs[i] = ctx.alloc_bytes(64);
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+        for (size_t i = 0; i < kBurst; ++i) {
+            ctx.free_bytes(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_Cell_Policy_TlsBinCache)
+    ->ArgNames({"capacity", "refill"})
+    ->Args({8, 4})
+    ->Args({16, 8})
+    ->Args({32, 8})
+    ->Args({32, 16})
+    ->Args({32, 32});
+
+// Arg: warm_cells_per_bin. Bursts of 4KB blocks (3 per cell) empty their
+// cells on every free, so fewer warm cells mean more cell-pool round trips.
+static void BM_Cell_Policy_WarmCells(benchmark::State &state) {
+    Cell::Config config;
+    config.warm_cells_per_bin = static_cast<size_t>(state.range(0));
+    Cell::Context ctx(config);
+
+    constexpr size_t kBurst = 48;
+    std::vector<void *> ptrs(kBurst);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBurst; ++i) {
+            ptrs[i] = ctx.alloc_bytes(4096);
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+        for (size_t i = 0; i < kBurst; ++i) {
+            ctx.free_bytes(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_Cell_Policy_WarmCells)->ArgName("warm")->Arg(0)->Arg(2)->Arg(8)->Arg(32);
+
+// Arg: tls_cache_capacity. Bursts of whole cells spill magazines of half
+// this size to the global depot.
+static void BM_Cell_Policy_TlsCellCache(benchmark::State &state) {
+    Cell::Config config;
+    config.tls_cache_capacity = static_cast<size_t>(state.range(0));
+    Cell::Context ctx(config);
+
+    constexpr size_t kBurst = 256;
+    std::vector<Cell::CellData *> cells(kBurst);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBurst; ++i) {
+            cells[i] = ctx.alloc_cell();
+        }
+        benchmark::DoNotOptimize(cells.data());
+        for (size_t i = 0; i < kBurst; ++i) {
+            ctx.free_cell(cells[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_Cell_Policy_TlsCellCache)->ArgName("capacity")->Arg(2)->Arg(8)->Arg(32)->Arg(64);
+
+// =============================================================================
+// First Requests on a Fresh Context (Prewarm Comparison)
+// Arg 0: cold Context, Arg 1: Context::prewarm() and warm_thread() first.
+// Each iteration builds a Context outside the timed region, then times the
+// first 4 superblocks of cell allocations and 4096 small allocations, writing
+// every page. "faults" reports minor page faults in the timed region.
+// =============================================================================
+
+static void BM_Cell_FirstRequests(benchmark::State &state) {
+    Cell::Config config;
+    config.reserve_size = 256 * 1024 * 1024;
+
+    constexpr size_t kPageSize = 4096;
+    const size_t cell_count = Cell::kCellsPerSuperblock * 4;
+    std::vector<Cell::CellData *> cells(cell_count);
+    std::vector<void *> blocks(4096);
+
+    long faults = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto ctx = std::make_unique<Cell::Context>(config);
+        if (state.range(0)) {
+            ctx->prewarm((cell_count + Cell::kCellsPerSuperblock) * Cell::kCellSize);
+            ctx->warm_thread();
+        }
+        long faults_before = minor_faults();
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < cell_count; ++i) {
+            cells[i] = ctx->alloc_cell();
+            auto *bytes = reinterpret_cast<char *>(cells[i]);
+            for (size_t off = kPageSize; off < Cell::kCellSize; off += kPageSize) {
+                bytes[off] = static_cast<char>(i);
+            }
+        }
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i] = ctx->alloc_bytes(64);
+            static_cast<char *>(blocks[i])[0] = static_cast<char>(i);
+        }
+        benchmark::DoNotOptimize(cells.data());
+        benchmark::DoNotOptimize(blocks.data());
+
+        state.PauseTiming();
+        faults += minor_faults() - faults_before;
+        ctx.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetLabel(state.range(0) ? "prewarmed" : "cold");
+    state.counters["faults"] =
+        benchmark::Counter(static_cast<double>(faults), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * (cell_count + blocks.size()));
+}
+BENCHMARK(BM_Cell_FirstRequests)->Arg(0)->Arg(1);
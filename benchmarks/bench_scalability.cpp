@@ -0,0 +1,323 @@
+#include <benchmark/benchmark.h>
+#include <cell/context.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef CELL_ENABLE_STATS
+
+// =============================================================================
+// Scalability Benchmarks
+// Cross-thread free patterns, thread churn and thread counts up to 64 (plus
+// oversubscription), for each allocation tier. Every benchmark reports:
+//   committed_MB        Memory committed by the Context, over all tiers, when
+//                       the timed loop ends
+//   bin_lock_contended  Size-class bin lock acquisitions that found the lock
+//                       held
+// The contention count comes from the bin statistics, so these benchmarks
+// are only registered when CELL_ENABLE_STATS is defined.
+// Items/s that stop rising with the thread count while bin_lock_contended
+// climbs point at the bins; rising committed_MB points at memory stranded in
+// per-thread caches.
+// =============================================================================
+
+namespace {
+
+    /** @brief Block sizes covering the sub-cell, cell, buddy and large tiers. */
+    constexpr int64_t kSubCellBytes = 64;
+    constexpr int64_t kCellBytes = 12 * 1024;
+    constexpr int64_t kBuddyBytes = 64 * 1024;
+    constexpr int64_t kLargeBytes = 4 * 1024 * 1024;
+
+    /** @brief Blocks moved per iteration: 32 small blocks down to 1 large one. */
+    size_t batch_for(size_t size) { return std::clamp<size_t>(256 * 1024 / size, 1, 32); }
+
+    /**
+     * @brief Lock-free multi-producer inbox of freed-to-be blocks.
+     *
+     * Blocks are chained through their first word, so sending writes to the
+     * block the way a real producer would.
+     */
+    struct alignas(64) Inbox {
+        std::atomic<void *> head{nullptr};
+        std::atomic<size_t> count{0};
+
+        void push(void *first, void *last, size_t n) {
+            count.fetch_add(n, std::memory_order_relaxed);
+            void *old = head.load(std::memory_order_relaxed);
+            do {
+                *static_cast<void **>(last) = old;
+            } while (!head.compare_exchange_weak(old, first, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        }
+
+        /** @brief Frees every queued block into ctx; returns the number freed. */
+        size_t drain(Cell::Context &ctx) {
+            void *block = head.exchange(nullptr, std::memory_order_acquire);
+            size_t freed = 0;
+            while (block) {
+                void *next = *static_cast<void **>(block);
+                ctx.free_bytes(block);
+                block = next;
+                ++freed;
+            }
+            count.fetch_sub(freed, std::memory_order_relaxed);
+            return freed;
+        }
+    };
+
+    /** @brief State shared by the threads of one benchmark run. */
+    struct ScaleShared {
+        Cell::Context ctx;
+        std::vector<Inbox> inboxes;
+
+        explicit ScaleShared(size_t threads) : inboxes(threads) {}
+    };
+
+    ScaleShared *g_scale = nullptr;
+
+    /** @brief Allocates n chained blocks; returns the first and sets last. */
+    void *alloc_chain(Cell::Context &ctx, size_t size, size_t n, void *&last) {
+        void *first = nullptr;
+        for (size_t i = 0; i < n; ++i) {
+            void *block = ctx.alloc_bytes(size);
+            *static_cast<void **>(block) = first;
+            if (!first) {
+                last = block;
+            }
+            first = block;
+        }
+        return first;
+    }
+
+    void report_scaling_counters(benchmark::State &state, Cell::Context &ctx) {
+        constexpr double kMB = 1024.0 * 1024.0;
+        size_t contended = 0;
+        for (const Cell::BinStats &bin : ctx.get_stats().bins) {
+            contended += bin.lock_contended;
+        }
+        state.counters["bin_lock_contended"] = static_cast<double>(contended);
+        state.counters["committed_MB"] = static_cast<double>(ctx.committed_bytes()) / kMB;
+    }
+
+    void ScalingThreads(benchmark::internal::Benchmark *b) {
+        for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+            b->Threads(threads);
+        }
+    }
+
+    /** @brief Pairs of threads from 2 to 64 (producer/consumer needs an even count). */
+    void PairedThreads(benchmark::internal::Benchmark *b) {
+        for (int threads : {2, 4, 8, 16, 32, 64}) {
+            b->Threads(threads);
+        }
+    }
+
+    /** @brief Two and four times as many (even) threads as hardware threads. */
+    void OversubscribedThreads(benchmark::internal::Benchmark *b) {
+        int hw = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        b->Threads(2 * hw)->Threads(4 * hw);
+    }
+
+    void TierSizes(benchmark::internal::Benchmark *b) {
+        for (int64_t size : {kSubCellBytes, kCellBytes, kBuddyBytes, kLargeBytes}) {
+            b->Arg(size);
+        }
+    }
+
+} // namespace
+
+// =============================================================================
+// Same-Thread Baseline
+// Each thread allocates a batch and frees it itself.
+// =============================================================================
+
+static void BM_Scale_LocalFree(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_scale = new ScaleShared(static_cast<size_t>(state.threads()));
+    }
+
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t batch = batch_for(size);
+    std::vector<void *> ptrs(batch);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch; ++i) {
+            ptrs[i] = g_scale->ctx.alloc_bytes(size);
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+        for (size_t i = 0; i < batch; ++i) {
+            g_scale->ctx.free_bytes(ptrs[i]);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        report_scaling_counters(state, g_scale->ctx);
+        delete g_scale;
+        g_scale = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+BENCHMARK(BM_Scale_LocalFree)->Apply(TierSizes)->Apply(ScalingThreads)->UseRealTime();
+BENCHMARK(BM_Scale_LocalFree)->Apply(TierSizes)->Apply(OversubscribedThreads)->UseRealTime();
+
+// =============================================================================
+// Producer -> Consumer
+// Even threads allocate, odd threads free what their partner allocated, so
+// every free is remote. Producers wait while their consumer has 8 batches
+// queued.
+// =============================================================================
+
+static void BM_Scale_ProducerConsumer(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_scale = new ScaleShared(static_cast<size_t>(state.threads()));
+    }
+
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t batch = batch_for(size);
+    const bool producer = state.thread_index() % 2 == 0;
+    const size_t pair = static_cast<size_t>(state.thread_index()) / 2;
+
+    size_t freed = 0;
+    size_t target = 0;
+    for (auto _ : state) {
+        Inbox &inbox = g_scale->inboxes[pair];
+        if (producer) {
+            while (inbox.count.load(std::memory_order_relaxed) >= 8 * batch) {
+                std::this_thread::yield();
+            }
+            void *last = nullptr;
+            void *first = alloc_chain(g_scale->ctx, size, batch, last);
+            inbox.push(first, last, batch);
+        } else {
+            // Producer and consumer run the same number of iterations, so
+            // the consumer frees exactly what its partner sends
+            target += batch;
+            while (freed < target) {
+                size_t n = inbox.drain(g_scale->ctx);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+                freed += n;
+            }
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        report_scaling_counters(state, g_scale->ctx);
+        delete g_scale;
+        g_scale = nullptr;
+    }
+
+    // Count each block once, on the producer side
+    state.SetItemsProcessed(producer ? state.iterations() * static_cast<int64_t>(batch) : 0);
+}
+BENCHMARK(BM_Scale_ProducerConsumer)->Apply(TierSizes)->Apply(PairedThreads)->UseRealTime();
+BENCHMARK(BM_Scale_ProducerConsumer)
+    ->Apply(TierSizes)
+    ->Apply(OversubscribedThreads)
+    ->UseRealTime();
+
+// =============================================================================
+// All-to-All Exchange
+// Every thread sends each batch to the next thread in rotation and frees
+// whatever arrived in its own inbox. A batch bound for a backed-up inbox is
+// freed locally so no thread ever waits on another.
+// =============================================================================
+
+static void BM_Scale_AllToAll(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_scale = new ScaleShared(static_cast<size_t>(state.threads()));
+    }
+
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t batch = batch_for(size);
+    const size_t threads = static_cast<size_t>(state.threads());
+    const size_t self = static_cast<size_t>(state.thread_index());
+
+    size_t round = 0;
+    for (auto _ : state) {
+        size_t dest = threads > 1 ? (self + 1 + round % (threads - 1)) % threads : self;
+        ++round;
+
+        void *last = nullptr;
+        void *first = alloc_chain(g_scale->ctx, size, batch, last);
+        Inbox &out = g_scale->inboxes[dest];
+        if (out.count.load(std::memory_order_relaxed) < 8 * batch) {
+            out.push(first, last, batch);
+        } else {
+            while (first) {
+                void *next = *static_cast<void **>(first);
+                g_scale->ctx.free_bytes(first);
+                first = next;
+            }
+        }
+        g_scale->inboxes[self].drain(g_scale->ctx);
+    }
+
+    if (state.thread_index() == 0) {
+        report_scaling_counters(state, g_scale->ctx);
+        // Every thread has left the loop; free what is still in flight
+        for (Inbox &inbox : g_scale->inboxes) {
+            inbox.drain(g_scale->ctx);
+        }
+        delete g_scale;
+        g_scale = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+BENCHMARK(BM_Scale_AllToAll)->Apply(TierSizes)->Apply(ScalingThreads)->UseRealTime();
+
+// =============================================================================
+// Thread Churn
+// Each iteration starts a short-lived thread that allocates a batch, frees
+// half of it, flushes its caches and exits; the spawning thread frees the
+// other half. Measures per-thread cache setup and teardown.
+// =============================================================================
+
+static void BM_Scale_ThreadChurn(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_scale = new ScaleShared(static_cast<size_t>(state.threads()));
+    }
+
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t batch = std::max<size_t>(batch_for(size), 2);
+    std::vector<void *> ptrs(batch);
+
+    for (auto _ : state) {
+        std::thread worker([&ptrs, size, batch]() {
+            for (size_t i = 0; i < batch; ++i) {
+                ptrs[i] = g_scale->ctx.alloc_bytes(size);
+            }
+            for (size_t i = batch / 2; i < batch; ++i) {
+                g_scale->ctx.free_bytes(ptrs[i]);
+            }
+            g_scale->ctx.flush_tls_caches();
+        });
+        worker.join();
+        for (size_t i = 0; i < batch / 2; ++i) {
+            g_scale->ctx.free_bytes(ptrs[i]);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        report_scaling_counters(state, g_scale->ctx);
+        delete g_scale;
+        g_scale = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+BENCHMARK(BM_Scale_ThreadChurn)
+    ->Apply(TierSizes)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->Threads(64)
+    ->UseRealTime();
+
+#endif // CELL_ENABLE_STATS
@@ -105,6 +105,46 @@ static void BM_Cell_Parallel_Batch(benchmark::State &state) {
 }
 BENCHMARK(BM_Cell_Parallel_Batch)->Threads(1)->Threads(2)->Threads(4)->Threads(8);
 
+// =============================================================================
+// Cell Churn: bursts larger than the TLS cell cache
+// Every burst overflows the per-thread cache, so cells move through the
+// global magazine depot on both the free and the alloc side.
+// =============================================================================
+
+static void BM_Cell_Parallel_CellChurn(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        g_shared_ctx = new Cell::Context();
+    }
+
+    const size_t burst = static_cast<size_t>(state.range(0));
+    std::vector<Cell::CellData *> cells(burst);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < burst; ++i) {
+            cells[i] = g_shared_ctx->alloc_cell();
+        }
+        benchmark::DoNotOptimize(cells.data());
+
+        for (size_t i = 0; i < burst; ++i) {
+            g_shared_ctx->free_cell(cells[i]);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        delete g_shared_ctx;
+        g_shared_ctx = nullptr;
+    }
+
+    state.SetItemsProcessed(state.iterations() * burst);
+}
+BENCHMARK(BM_Cell_Parallel_CellChurn)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8);
+
 // =============================================================================
 // Mixed Size Parallel
 // =============================================================================
@@ -2,8 +2,10 @@
 
 #include "config.h"
 
+#include <array>
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 
 namespace Cell {
@@ -13,25 +15,30 @@ namespace Cell {
      */
     enum class SuperblockState : uint8_t {
         kUncommitted, ///< Never used, no physical pages allocated.
-        kInUse,       ///< Has at least one allocated cell.
-        kFree,        ///< All cells free, physical pages still committed.
-        kDecommitted  ///< All cells free, physical pages released to OS.
+        kInUse,       ///< Committed and carved into cells.
+        kDecommitted, ///< All cells free, physical pages released to OS.
+        kLazyFreed    ///< All cells free, pages reclaimable by the OS under pressure.
     };
 
     /**
-     * @brief A free cell node for the lock-free stack.
+     * @brief A free cell node, stored inline in the cell's memory when it's free.
      *
-     * Stored inline in the cell's memory when it's free.
+     * Free cells travel between threads in magazines: chains of up to
+     * Allocator::magazine_size() cells linked through @c next. Only the first cell of a
+     * magazine uses @c next_magazine and @c count.
      */
     struct FreeCell {
-        FreeCell *next;
+        FreeCell *next;           ///< Next cell in the same magazine.
+        uint64_t header_reserved; ///< Overlaps the debug CellHeader fields; never written.
+        FreeCell *next_magazine;  ///< Next magazine in the depot (magazine head only).
+        size_t count;             ///< Cells in this magazine (magazine head only).
     };
 
     /**
      * @brief Multi-tier memory allocator with memory decommit support.
      *
      * Tier 1: Thread-local cache (no locks)
-     * Tier 2: Global atomic stack (lock-free)
+     * Tier 2: Global magazine depot (lock-free, one CAS per magazine)
      * Tier 3: OS superblock allocation
      */
     class Allocator {
@@ -39,12 +46,35 @@ namespace Cell {
         /** @brief Maximum superblocks supported (for 8GB reserved = 4096 superblocks). */
         static constexpr size_t kMaxSuperblocks = 8192;
 
+        /**
+         * @brief Called before a superblock's address space is committed for the first time.
+         * @param user_data Pointer passed to set_superblock_hooks().
+         * @param superblock Start of the superblock about to be committed.
+         * @return false to fail the commit.
+         */
+        using SuperblockCommitHook = bool (*)(void *user_data, void *superblock);
+
+        /**
+         * @brief Called after decommit_unused() releases a whole superblock's pages.
+         * @param user_data Pointer passed to set_superblock_hooks().
+         * @param superblock Start of the released superblock.
+         */
+        using SuperblockReleaseHook = void (*)(void *user_data, void *superblock);
+
         /**
          * @brief Creates an allocator managing the given reserved range.
          * @param base Start of the reserved virtual address space.
          * @param reserved_size Total reserved bytes.
+         * @param release_policy How decommit_unused() returns pages to the OS.
+         * @param magazine_size Cells per magazine, clamped to [1, kCellMagazineSize].
+         *        Each thread caches up to two magazines.
+         * @param cell_size_log2 Log2 of the cell size, clamped to
+         *        [kMinCellSizeLog2, kMaxCellSizeLog2].
          */
-        explicit Allocator(void *base, size_t reserved_size);
+        explicit Allocator(void *base, size_t reserved_size,
+                           ReleasePolicy release_policy = ReleasePolicy::kDecommit,
+                           size_t magazine_size = kCellMagazineSize,
+                           size_t cell_size_log2 = kCellSizeLog2);
 
         ~Allocator();
 
@@ -61,47 +91,256 @@ namespace Cell {
         [[nodiscard]] void *alloc();
 
         /**
-         * @brief Returns a cell to the TLS cache or global pool.
+         * @brief Returns a cell to the TLS cache, spilling a magazine to the depot when full.
          * @param cell Pointer to the cell to free.
          */
         void free(void *cell);
 
         /**
-         * @brief Flushes the thread-local cache to the global pool.
+         * @brief Flushes the thread-local cache to the global depot.
+         *
+         * Does nothing if the cache holds another Allocator's cells.
          */
         void flush_tls_cache();
 
         /**
-         * @brief Decommits all fully-free superblocks.
+         * @brief Commits and prefaults superblocks until at least bytes are committed.
+         *
+         * Decommitted superblocks are reused first. Every cell of each warmed
+         * superblock goes to the global depot with its pages already faulted
+         * in, so the first allocations take neither a commit nor a page fault.
+         *
+         * @param bytes Target committed size in bytes.
+         * @return Bytes newly committed, which may fall short if the reservation runs out.
+         */
+        size_t prewarm(size_t bytes);
+
+        /**
+         * @brief Loads a depot magazine into the calling thread's TLS cache if it is empty.
+         */
+        void warm_tls_cache();
+
+        /**
+         * @brief Decommits fully-free superblocks and releases cold free cells.
+         *
+         * Free cells in the global depot beyond the newest
+         * kRetainedCellMagazines magazines have their pages returned to the OS
+         * individually, so a partially used superblock only stays resident for
+         * its live and recently freed cells. Released cells are reused, and
+         * recommitted if needed, before any new superblock is committed.
+         *
+         * Only cells in the global depot count as free: a superblock with a
+         * cell in any thread's TLS cache is never decommitted, so this is
+         * safe to call from any thread at any time.
+         *
+         * @param retained_magazines Depot magazines to keep resident.
          * @return Number of bytes released to the OS.
          */
-        size_t decommit_unused();
+        size_t decommit_unused(size_t retained_magazines = kRetainedCellMagazines);
+
+        /**
+         * @brief Installs hooks run around superblock commits and releases.
+         *
+         * commit runs before each fresh superblock commit; recommits of
+         * decommitted superblocks do not run it. release runs after a
+         * superblock is decommitted or lazily freed. Either may be null.
+         * Install them before the first allocation.
+         */
+        void set_superblock_hooks(SuperblockCommitHook commit, SuperblockReleaseHook release,
+                                  void *user_data) {
+            m_commit_hook = commit;
+            m_release_hook = release;
+            m_hook_data = user_data;
+        }
+
+        /** @brief Returns the number of cells per magazine. */
+        [[nodiscard]] size_t magazine_size() const { return m_magazine_size; }
+
+        /** @brief Returns the cell size in bytes. */
+        [[nodiscard]] size_t cell_size() const { return m_cell_size; }
 
         /**
          * @brief Returns currently committed physical memory.
+         *
+         * Lazily freed pages are excluded: the OS may reclaim them at any time.
          */
         [[nodiscard]] size_t committed_bytes() const;
 
+        /** @brief Returns superblocks committed so far, counting recommits. */
+        [[nodiscard]] size_t superblock_commits() const {
+            return m_superblock_commits.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Returns page-protection and release calls made so far.
+         *
+         * Counts mprotect and madvise (VirtualAlloc and VirtualFree on
+         * Windows), including calls that failed.
+         */
+        [[nodiscard]] size_t os_calls() const { return m_os_calls.load(std::memory_order_relaxed); }
+
     private:
-        void *refill_from_global();    ///< Tier 2 → Tier 1
-        void *refill_from_os();        ///< Tier 3 → Tier 2 → Tier 1
-        void push_global(FreeCell *c); ///< Lock-free push to global
-        FreeCell *pop_global();        ///< Lock-free pop from global
+        /**
+         * @brief Two-level bitmap over superblock indices with O(1) find-first.
+         *
+         * Bit i of @c bits marks superblock i; bit w of @c summary marks a
+         * non-zero bits[w]. Guarded by m_decommit_mutex.
+         */
+        struct SuperblockBitmap {
+            static constexpr size_t kWords = kMaxSuperblocks / 64;
+            static constexpr size_t kSummaryWords = (kWords + 63) / 64;
+
+            uint64_t bits[kWords]{};
+            uint64_t summary[kSummaryWords]{};
+
+            void set(size_t index);
+            void reset(size_t index);
+            [[nodiscard]] size_t find_first(size_t none) const; ///< Lowest set index, or none
+        };
+
+        /** @brief Words in a per-superblock cell bitmap. */
+        static constexpr size_t kCellBitmapWords = (kMaxCellsPerSuperblock + 63) / 64;
+
+        /** @brief Per-cell bitmap of one superblock. */
+        using CellBitmap = std::array<uint64_t, kCellBitmapWords>;
+
+        /**
+         * @brief Makes the calling thread's TLS cache hold this Allocator's cells.
+         *
+         * If another Allocator's cells are cached, they are flushed to that
+         * Allocator's depot first, so magazines never cross reservations.
+         */
+        void claim_tls_cache();
+
+        /** @brief Returns true if ptr lies in this Allocator's reservation. */
+        [[nodiscard]] bool in_reservation(const void *ptr) const {
+            auto addr = reinterpret_cast<uintptr_t>(ptr);
+            auto base = reinterpret_cast<uintptr_t>(m_base);
+            return addr >= base && addr - base < m_reserved_size;
+        }
+
+        bool refill_from_global(); ///< Tier 2 → Tier 1 (swap in a full magazine)
+        void *refill_from_os();    ///< Tier 3 → Tier 2 → Tier 1
+
+        /**
+         * @brief Commits a superblock, preferring a decommitted one over new address space.
+         * @return Start of the superblock, uncarved, or nullptr if none is available.
+         */
+        char *commit_superblock();
+
+        /**
+         * @brief Splices a list of magazines onto the depot with one CAS.
+         * @param first First magazine head.
+         * @param last Last magazine head; its next_magazine is overwritten.
+         */
+        void push_magazines(FreeCell *first, FreeCell *last);
+
+        /**
+         * @brief Pops one magazine from the depot.
+         * @return Magazine head, or nullptr if the depot is empty.
+         */
+        FreeCell *pop_magazine();
+
+        /**
+         * @brief Detaches every magazine from the depot.
+         * @return First magazine head, or nullptr if the depot was empty.
+         */
+        FreeCell *take_all_magazines();
+
+        /**
+         * @brief Links cells [first_cell, cells per superblock) into magazines and publishes them.
+         * @param superblock Start of a committed superblock.
+         * @param first_cell Index of the first cell to release.
+         */
+        void push_superblock_cells(char *superblock, size_t first_cell);
+
+        uint64_t encode_depot_head(FreeCell *magazine, uint64_t tag) const; ///< {index+1, tag}
+        FreeCell *decode_depot_head(uint64_t head) const;                   ///< Magazine or null
 
         size_t get_superblock_index(void *ptr) const;
         bool recommit_superblock(size_t index);
 
+        /**
+         * @brief Returns a page range to the OS according to m_release_policy.
+         * @return True on success.
+         */
+        bool release_pages(void *addr, size_t size) const;
+
+        /**
+         * @brief Records a superblock as decommitted. Caller holds m_decommit_mutex.
+         * @param index Superblock index.
+         */
+        void mark_decommitted(size_t index);
+
+        /**
+         * @brief Removes and returns the lowest decommitted superblock index.
+         *
+         * Caller holds m_decommit_mutex. O(1): one summary word selects the
+         * bitmap word, and count-trailing-zeros selects the bit.
+         *
+         * @return Superblock index, or m_num_superblocks if none is decommitted.
+         */
+        size_t take_decommitted();
+
+        /**
+         * @brief Returns cells' pages to the OS and records them as released.
+         *
+         * Caller holds m_decommit_mutex. Consecutive cells are released with
+         * one call.
+         *
+         * @param first First cell of a contiguous run.
+         * @param count Number of cells in the run.
+         * @return True if the pages were released.
+         */
+        bool release_cells(char *first, size_t count);
+
+        /**
+         * @brief Forgets every released cell of a superblock about to be decommitted.
+         * @param index Superblock index. Caller holds m_decommit_mutex.
+         * @return Number of released cells that were recorded.
+         */
+        size_t forget_released_cells(size_t index);
+
+        /**
+         * @brief Loads up to one magazine of released cells into the TLS cache.
+         * @return True if at least one cell was loaded.
+         */
+        bool reuse_released_cells();
+
         void *m_base;                                   ///< Start of reserved range.
         size_t m_reserved_size;                         ///< Total reserved bytes.
+        ReleasePolicy m_release_policy;                 ///< How free pages are released.
+        size_t m_magazine_size;                         ///< Cells per magazine.
+        size_t m_cell_size_log2;                        ///< Log2 of the cell size.
+        size_t m_cell_size;                             ///< Cell size in bytes.
+        size_t m_cells_per_superblock;                  ///< Cells carved from each superblock.
         std::atomic<size_t> m_committed_end{0};         ///< High-water mark for commits.
-        std::atomic<FreeCell *> m_global_head{nullptr}; ///< Lock-free stack head.
+        SuperblockCommitHook m_commit_hook = nullptr;   ///< Run before fresh commits.
+        SuperblockReleaseHook m_release_hook = nullptr; ///< Run after superblock releases.
+        void *m_hook_data = nullptr;                    ///< Passed to both hooks.
+
+        // Depot head: low 32 bits hold the head magazine's cell index + 1 (0 when
+        // empty), high 32 bits a tag bumped on every update to defeat ABA.
+        std::atomic<uint64_t> m_depot_head{0}; ///< Tagged magazine stack head.
 
         // Superblock tracking for decommit
         size_t m_num_superblocks{0}; ///< Total superblocks possible.
-        std::atomic<SuperblockState>
-            m_superblock_states[kMaxSuperblocks]{};            ///< Per-superblock state.
-        std::atomic<uint16_t> m_free_cells[kMaxSuperblocks]{}; ///< Free cell count per superblock.
-        std::mutex m_decommit_mutex;                           ///< Protects decommit operations.
+        std::atomic<SuperblockState> m_superblock_states[kMaxSuperblocks]{}; ///< Per-superblock.
+        std::mutex m_decommit_mutex; ///< Protects decommit operations.
+
+        SuperblockBitmap m_decommitted;             ///< Decommitted or lazily freed superblocks.
+        std::atomic<size_t> m_decommitted_count{0}; ///< Lock-free emptiness check.
+        std::atomic<size_t> m_committed_bytes{0};   ///< Committed cell-region bytes.
+        std::atomic<size_t> m_superblock_commits{0}; ///< Fresh commits plus recommits.
+        mutable std::atomic<size_t> m_os_calls{0};   ///< mprotect / madvise calls.
+
+        // Released cells: free cells whose pages were returned to the OS while
+        // the rest of their superblock stayed committed. Guarded by
+        // m_decommit_mutex; a set bit means the cell is not resident. The
+        // bitmaps are allocated by the first release, one per superblock.
+        std::unique_ptr<CellBitmap[]> m_released_cells; ///< Per-cell bits, or null.
+        SuperblockBitmap m_released_superblocks; ///< Superblocks with released cells.
+        std::atomic<size_t> m_released_count{0}; ///< Lock-free emptiness check.
     };
 
 }
@@ -151,15 +151,13 @@ namespace Cell {
             CellData *next;
         };
 
-        /** @brief Usable space per cell after header and link. */
-        static constexpr size_t kUsablePerCell = kCellSize - kBlockStartOffset - sizeof(CellLink);
-
         // =====================================================================
         // Members
         // =====================================================================
 
         Context &m_ctx;
         uint8_t m_tag;
+        size_t m_usable_per_cell; ///< Usable space per cell after header and link.
 
         CellData *m_head = nullptr;      ///< Current cell (allocating from this).
         size_t m_offset = 0;             ///< Current offset in head cell's usable space.
@@ -10,11 +10,15 @@
 namespace Cell {
 
     /**
-     * @brief Power-of-2 buddy allocator for medium-sized allocations (32KB - 2MB).
+     * @brief Power-of-2 buddy allocator for medium-sized allocations (32KB - 2MB by default).
      *
      * Uses buddy system for efficient splitting and coalescing of blocks.
      * All allocations are contiguous and safe for array indexing.
      *
+     * The largest order (and with it the superblock size) is chosen at
+     * construction, so workloads with many 4-64MB buffers can keep them in the
+     * buddy tier instead of paying for a dedicated OS mapping each time.
+     *
      * Thread safety: Protected by internal mutex.
      */
     class BuddyAllocator {
@@ -26,17 +30,20 @@ namespace Cell {
         /** @brief Minimum order: 2^15 = 32KB */
         static constexpr size_t kMinOrder = 15;
 
-        /** @brief Maximum order: 2^21 = 2MB (superblock size) */
-        static constexpr size_t kMaxOrder = 21;
+        /** @brief Default maximum order: 2^21 = 2MB (superblock size) */
+        static constexpr size_t kDefaultMaxOrder = 21;
+
+        /** @brief Largest configurable maximum order: 2^26 = 64MB */
+        static constexpr size_t kMaxSupportedOrder = 26;
 
-        /** @brief Number of orders: 15, 16, 17, 18, 19, 20, 21 = 7 orders */
-        static constexpr size_t kNumOrders = kMaxOrder - kMinOrder + 1;
+        /** @brief Number of free lists needed for the largest configuration */
+        static constexpr size_t kMaxNumOrders = kMaxSupportedOrder - kMinOrder + 1;
 
         /** @brief Minimum block size: 32KB */
         static constexpr size_t kMinBlockSize = size_t{1} << kMinOrder;
 
-        /** @brief Maximum block size / superblock size: 2MB */
-        static constexpr size_t kMaxBlockSize = size_t{1} << kMaxOrder;
+        /** @brief Default maximum block size / superblock size: 2MB */
+        static constexpr size_t kDefaultMaxBlockSize = size_t{1} << kDefaultMaxOrder;
 
         // =====================================================================
         // Construction
@@ -45,10 +52,16 @@ namespace Cell {
         /**
          * @brief Creates a buddy allocator with reserved virtual memory.
          *
+         * The region is expected to be reserved but inaccessible (PROT_NONE /
+         * MEM_RESERVE). Superblocks are committed on demand by grow(), so the
+         * commit charge follows actual use rather than the reservation size.
+         *
          * @param base Base address of reserved memory region.
-         * @param reserved_size Total reserved size (should be multiple of 2MB).
+         * @param reserved_size Total reserved size (should be a multiple of the max block size).
+         * @param max_order Largest block order, clamped to [kMinOrder, kMaxSupportedOrder].
+         *        Also the superblock size committed by each grow().
          */
-        BuddyAllocator(void *base, size_t reserved_size);
+        BuddyAllocator(void *base, size_t reserved_size, size_t max_order = kDefaultMaxOrder);
 
         ~BuddyAllocator();
 
@@ -68,9 +81,10 @@ namespace Cell {
          * Size is rounded up to the next power-of-2 >= 32KB.
          *
          * @param size Requested size in bytes.
+         * @param tag Memory tag, stored in the block header.
          * @return Pointer to allocated memory, or nullptr on failure.
          */
-        [[nodiscard]] void *alloc(size_t size);
+        [[nodiscard]] void *alloc(size_t size, uint8_t tag = 0);
 
         /**
          * @brief Frees a previously allocated block.
@@ -89,6 +103,7 @@ namespace Cell {
          * - Attempts buddy merging if growing to next order
          * - Falls back to allocate+copy+free if needed
          * - Data preserved up to min(old_size, new_size)
+         * - The block keeps its tag
          *
          * @param ptr Pointer from previous alloc/realloc_bytes call
          * @param new_size New size in bytes
@@ -96,6 +111,17 @@ namespace Cell {
          */
         [[nodiscard]] void *realloc_bytes(void *ptr, size_t new_size);
 
+        /**
+         * @brief Commits and prefaults superblocks until at least bytes are committed.
+         *
+         * New superblocks go on the free lists with their pages already
+         * faulted in, so the first allocations from them take no page faults.
+         *
+         * @param bytes Target committed size in bytes.
+         * @return Bytes newly committed, which may fall short if the reservation runs out.
+         */
+        size_t prewarm(size_t bytes);
+
         // =====================================================================
         // Introspection
         // =====================================================================
@@ -122,11 +148,39 @@ namespace Cell {
          */
         [[nodiscard]] size_t get_alloc_size(void *ptr) const;
 
+        /**
+         * @brief Returns the tag passed to alloc() for a pointer.
+         * @param ptr User pointer from alloc()
+         * @return Tag, or 0 if not a valid allocation
+         */
+        [[nodiscard]] uint8_t get_alloc_tag(void *ptr) const;
+
         /**
          * @brief Returns number of superblocks in use.
          */
         [[nodiscard]] size_t superblock_count() const;
 
+        /**
+         * @brief Returns the largest block order this allocator serves.
+         */
+        [[nodiscard]] size_t max_order() const { return m_max_order; }
+
+        /**
+         * @brief Returns the largest block size (and superblock size) in bytes.
+         */
+        [[nodiscard]] size_t max_block_size() const { return size_t{1} << m_max_order; }
+
+        /**
+         * @brief Returns the block size alloc(size) would consume.
+         *
+         * Includes the internal header and power-of-2 rounding, matching
+         * get_alloc_size() on the returned pointer.
+         *
+         * @param size Requested size in bytes.
+         * @return Block size in bytes, or 0 if the request exceeds max_block_size().
+         */
+        [[nodiscard]] size_t block_size_for(size_t size) const;
+
     private:
         // =====================================================================
         // Internal Types
@@ -148,8 +202,9 @@ namespace Cell {
          * returning the pointer to the user.
          */
         struct BlockHeader {
-            uint8_t order; ///< Allocation order (15-21)
-            uint8_t reserved[7];
+            uint8_t order; ///< Allocation order (kMinOrder to max_order())
+            uint8_t tag;   ///< Tag passed to alloc()
+            uint8_t reserved[6];
         };
 
         static_assert(sizeof(BlockHeader) == 8, "BlockHeader should be 8 bytes");
@@ -163,21 +218,24 @@ namespace Cell {
         std::atomic<size_t> m_committed{0}; ///< Bytes committed from OS
         std::atomic<size_t> m_allocated{0}; ///< Bytes currently allocated
         size_t m_superblock_count{0};       ///< Number of superblocks
+        size_t m_max_order;                 ///< Largest order (superblock = 2^m_max_order)
 
-        FreeBlock *m_free_lists[kNumOrders]{}; ///< Free list per order
-        std::mutex m_lock;                     ///< Protects free lists
+        FreeBlock *m_free_lists[kMaxNumOrders]{}; ///< Free list per order
+        std::mutex m_lock;                        ///< Protects free lists
 
         // =====================================================================
         // Internal Methods
         // =====================================================================
 
         /**
-         * @brief Converts size to order (index into free list).
+         * @brief Converts size to the smallest order that fits it.
+         *
+         * The result is not capped; callers compare it against m_max_order.
          */
         static size_t size_to_order(size_t size);
 
         /**
-         * @brief Allocates a new superblock from reserved memory.
+         * @brief Commits the next superblock of the reserved range.
          */
         bool grow();
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "config.h"
+
+#ifdef CELL_ENABLE_BUDGET
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cell {
+
+    /** @brief Number of allocation tags with their own budget. */
+    static constexpr size_t kNumBudgetTags = 256;
+
+    /** @brief Log2 of the cell-region bytes per block tag entry (the smallest block). */
+    static constexpr size_t kBlockTagShift = 4;
+    static_assert((size_t{1} << kBlockTagShift) == kMinBlockSize,
+                  "One block tag entry per smallest block");
+
+    // =========================================================================
+    // Per-Thread Budget Credit
+    // =========================================================================
+
+    /**
+     * @brief Budget bytes a thread has reserved but not yet allocated.
+     *
+     * Threads reserve credit from the Context's budget counters in chunks and
+     * spend it without touching the shared counters: an allocation needs
+     * credit both against the Context budget and against its tag's budget.
+     * Only the owning thread writes the credit; the Context reads it to report
+     * committed usage and takes it back once the thread has let go of it.
+     */
+    struct BudgetCredit {
+        std::atomic<size_t> bytes{0};                   ///< Against the Context budget.
+        std::atomic<size_t> tag_bytes[kNumBudgetTags]{}; ///< Against each tag's budget.
+    };
+
+    /**
+     * @brief The calling thread's credit and the Context it was reserved from.
+     *
+     * Trivially destructible so inline fast paths reach it without a TLS
+     * initialization call; Context keeps the credit alive through a separate
+     * thread-local owner shared with its registry.
+     */
+    struct ThreadBudgetCredit {
+        BudgetCredit *credit = nullptr;
+        uint64_t context_id = 0; ///< 0 = no credit held.
+    };
+
+    /** @brief Thread-local budget credit (one Context at a time per thread). */
+    inline thread_local ThreadBudgetCredit t_budget_credit;
+
+}
+
+#endif // CELL_ENABLE_BUDGET
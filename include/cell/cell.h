@@ -42,7 +42,7 @@ namespace Cell {
      */
     struct CellHeader {
         uint8_t tag;         /**< Application-defined memory tag for profiling. */
-        uint8_t size_class;  /**< Size class bin index (0-9), or kFullCellMarker. */
+        uint8_t size_class;  /**< Size class bin index, or kFullCellMarker. */
         uint16_t free_count; /**< Number of free blocks remaining in this cell. */
 #ifdef NDEBUG
         uint8_t reserved[4]; /**< Reserved for future use. */
@@ -109,11 +109,12 @@ namespace Cell {
      * Performs a constant-time alignment mask.
      *
      * @param ptr Any pointer within a Cell's memory range.
+     * @param cell_mask ~(cell size - 1) for the owning Context (default: kCellMask).
      * @return Pointer to the CellHeader at the start of the Cell.
      */
-    inline CellHeader *get_header(void *ptr) {
+    inline CellHeader *get_header(void *ptr, uintptr_t cell_mask = kCellMask) {
         auto addr = reinterpret_cast<uintptr_t>(ptr);
-        return reinterpret_cast<CellHeader *>(addr & kCellMask);
+        return reinterpret_cast<CellHeader *>(addr & cell_mask);
     }
 
     /**
@@ -6,20 +6,28 @@
 namespace Cell {
 
     /**
-     * @brief Log2 of the Cell size. Default is 14 (16KB).
+     * @brief Log2 of the default Cell size. Default is 14 (16KB).
      *
-     * Must be a power of 2. Minimum is 12 (4KB, standard page size).
+     * Config::cell_size_log2 selects the cell size per Context; kCellSize,
+     * kCellMask and kCellsPerSuperblock describe this default.
      */
     static constexpr size_t kCellSizeLog2 = 14;
 
-    /** @brief Cell size in bytes (2^kCellSizeLog2). */
+    /** @brief Smallest selectable cell size: 12 (4KB, standard page size). */
+    static constexpr size_t kMinCellSizeLog2 = 12;
+
+    /** @brief Largest selectable cell size: 16 (64KB). */
+    static constexpr size_t kMaxCellSizeLog2 = 16;
+
+    /** @brief Default cell size in bytes (2^kCellSizeLog2). */
     static constexpr size_t kCellSize = 1ULL << kCellSizeLog2;
 
-    /** @brief Bitmask for aligning pointers to Cell boundaries. */
+    /** @brief Bitmask for aligning pointers to default-size Cell boundaries. */
     static constexpr uintptr_t kCellMask = ~(kCellSize - 1);
 
-    static_assert(kCellSize >= 4096, "Cell size must be at least 4KB (standard page size)");
-    static_assert((kCellSize & (kCellSize - 1)) == 0, "Cell size must be a power of 2");
+    static_assert(kMinCellSizeLog2 >= 12, "Cell size must be at least 4KB (standard page size)");
+    static_assert(kCellSizeLog2 >= kMinCellSizeLog2 && kCellSizeLog2 <= kMaxCellSizeLog2,
+                  "Default cell size must be selectable");
 
     // -------------------------------------------------------------------------
     // Allocation Tier Configuration
@@ -31,45 +39,93 @@ namespace Cell {
     /** @brief Superblock size in bytes (2^kSuperblockSizeLog2). */
     static constexpr size_t kSuperblockSize = 1ULL << kSuperblockSizeLog2;
 
-    /** @brief Number of cells carved from each superblock. */
+    /** @brief Number of default-size cells carved from each superblock. */
     static constexpr size_t kCellsPerSuperblock = kSuperblockSize / kCellSize;
 
-    /** @brief Number of cells cached per thread (TLS). */
+    /** @brief Number of cells carved from each superblock at the smallest cell size. */
+    static constexpr size_t kMaxCellsPerSuperblock = kSuperblockSize >> kMinCellSizeLog2;
+
+    /**
+     * @brief Maximum (and default) number of cells cached per thread (TLS).
+     *
+     * Config::tls_cache_capacity can lower it per Context.
+     */
     static constexpr size_t kTlsCacheCapacity = 64;
 
-    /** @brief Number of bins with TLS caching (bins 0-8: 16B to 4KB). */
+    /**
+     * @brief Maximum (and default) cells per magazine moved between a TLS cache and the depot.
+     *
+     * Each thread caches a loaded and a previous magazine (kTlsCacheCapacity
+     * cells); overflow and underflow move one whole magazine to or from the
+     * depot, so each exchange costs a single CAS. A Context's magazines hold
+     * half its Config::tls_cache_capacity.
+     */
+    static constexpr size_t kCellMagazineSize = 32;
+
+    /**
+     * @brief Magazines of free cells the global depot keeps resident across decommit_unused().
+     *
+     * Older depot cells have their pages released individually.
+     */
+    static constexpr size_t kRetainedCellMagazines = 2;
+
+    /**
+     * @brief Maximum (and default) number of bins with TLS caching (bins 0-8: 16B to 4KB).
+     *
+     * Sizes the thread-local arrays; Config::tls_bin_cache_count can lower it.
+     */
     static constexpr size_t kTlsBinCacheCount = 9;
 
-    /** @brief Number of blocks cached per bin per thread. */
+    /**
+     * @brief Maximum (and default) number of blocks cached per bin per thread.
+     *
+     * Sizes the thread-local arrays; Config::tls_bin_cache_capacity can lower it.
+     */
     static constexpr size_t kTlsBinCacheCapacity = 32;
 
-    /** @brief Number of blocks to refill from global bin at once. */
+    /** @brief Default number of blocks to refill from global bin at once. */
     static constexpr size_t kTlsBinBatchRefill = 16;
 
     // Static validation for allocation tiers
-    static_assert(kSuperblockSize >= kCellSize, "Superblock must be >= cell size");
-    static_assert(kSuperblockSize % kCellSize == 0, "Superblock must be multiple of cell size");
+    static_assert(kSuperblockSizeLog2 >= kMaxCellSizeLog2, "Superblock must be >= cell size");
     static_assert(kCellsPerSuperblock >= 1, "Must have at least 1 cell per superblock");
     static_assert(kTlsCacheCapacity >= 1, "TLS cache must hold at least 1 cell");
+    static_assert(kCellMagazineSize >= 1, "Magazine must hold at least 1 cell");
+    static_assert(kTlsCacheCapacity == 2 * kCellMagazineSize,
+                  "TLS cell cache holds a loaded and a previous magazine");
+    static_assert(kTlsBinBatchRefill >= 1 && kTlsBinBatchRefill <= kTlsBinCacheCapacity,
+                  "Default TLS bin refill must fit the TLS bin cache");
 
     // -------------------------------------------------------------------------
     // Sub-Cell Allocation Configuration (Size Classes)
     // -------------------------------------------------------------------------
 
-    /** @brief Number of size class bins for sub-cell allocation. */
-    static constexpr size_t kNumSizeBins = 10;
+    /**
+     * @brief Number of size class bins for sub-cell allocation at the largest cell size.
+     *
+     * Size classes run up to half the cell size, so a Context uses the first
+     * cell_size_log2 - 4 bins (10 for 16KB cells).
+     */
+    static constexpr size_t kNumSizeBins = kMaxCellSizeLog2 - 4;
 
     /** @brief Minimum block size in bytes (must fit a free-list pointer). */
     static constexpr size_t kMinBlockSize = 16;
 
-    /** @brief Maximum size for sub-cell allocation. Larger uses full cells. */
-    static constexpr size_t kMaxSubCellSize = 8192;
+    /**
+     * @brief Maximum size for sub-cell allocation at the default cell size. Larger uses full cells.
+     *
+     * A Context's sub-cell ceiling is half its cell size.
+     */
+    static constexpr size_t kMaxSubCellSize = kCellSize / 2;
 
     /** @brief Size class lookup table (power-of-2 sizes). */
-    static constexpr size_t kSizeClasses[kNumSizeBins] = {16,  32,   64,   128,  256,
-                                                          512, 1024, 2048, 4096, 8192};
+    static constexpr size_t kSizeClasses[kNumSizeBins] = {
+        16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768};
+
+    /** @brief Largest size class, used only by Contexts with the largest cells. */
+    static constexpr size_t kMaxSizeClass = kSizeClasses[kNumSizeBins - 1];
 
-    /** @brief Number of warm cells to keep per bin (avoids thrashing). */
+    /** @brief Default number of warm cells to keep per bin (avoids thrashing). */
     static constexpr size_t kWarmCellsPerBin = 2;
 
     /** @brief Marker for full-cell allocations (not sub-cell). */
@@ -78,10 +134,44 @@ namespace Cell {
     // Static validation for sub-cell configuration
     static_assert(kNumSizeBins > 0, "Must have at least 1 size bin");
     static_assert(kMinBlockSize >= sizeof(void *), "Min block must fit a pointer");
-    static_assert(kMaxSubCellSize < kCellSize, "Max sub-cell size must be < cell size");
     static_assert(kSizeClasses[0] == kMinBlockSize, "First size class must match min block size");
-    static_assert(kSizeClasses[kNumSizeBins - 1] == kMaxSubCellSize,
-                  "Last size class must match max");
+    static_assert(kMaxSizeClass == (size_t{1} << (kMaxCellSizeLog2 - 1)),
+                  "Last size class must be half the largest cell");
+
+    /** @brief Default mean bytes between heap profiler samples (CELL_ENABLE_HEAP_PROFILER). */
+    static constexpr size_t kDefaultHeapSampleInterval = 512 * 1024;
+
+    /** @brief Default budget credit each thread may hold (CELL_ENABLE_BUDGET). */
+    static constexpr size_t kDefaultBudgetSlack = 64 * 1024;
+
+    /** @brief Default events buffered per thread (CELL_ENABLE_INSTRUMENTATION). */
+    static constexpr size_t kDefaultEventRingCapacity = 4096;
+
+    /**
+     * @brief How decommit_unused() returns free cell memory to the OS.
+     */
+    enum class ReleasePolicy : uint8_t {
+        /**
+         * Drop the pages immediately (MADV_DONTNEED / MEM_DECOMMIT). RSS falls at
+         * once; every page faults back in zero-filled on reuse.
+         */
+        kDecommit,
+        /**
+         * Mark the pages reclaimable (MADV_FREE / MEM_RESET). The kernel takes
+         * them only under memory pressure, so prompt reuse avoids page faults.
+         * Falls back to kDecommit where unsupported.
+         */
+        kLazyFree
+    };
+
+    /**
+     * @brief Severity of memory pressure, used to scale Context::trim().
+     */
+    enum class PressureLevel : uint8_t {
+        kNone,     ///< No action.
+        kModerate, ///< Drop warm cells and caches, release cold free memory.
+        kCritical  ///< As kModerate, and release every free cell's pages.
+    };
 
     /**
      * @brief Configuration for creating a Context.
@@ -94,6 +184,82 @@ namespace Cell {
          */
         size_t reserve_size = 16ULL * 1024 * 1024 * 1024;
 
+        /**
+         * @brief Log2 of the largest block the buddy allocator serves.
+         *
+         * Requests whose block (size plus header) fits 2^buddy_max_order go to
+         * the buddy tier; larger ones are mapped directly from the OS. Raising
+         * it keeps multi-megabyte buffers out of per-allocation mmap/munmap.
+         * Clamped to [15, 26]. Default: 21 (2MB).
+         */
+        size_t buddy_max_order = 21;
+
+        /**
+         * @brief Log2 of this Context's cell size.
+         *
+         * Sets the full-cell allocation size, the sub-cell ceiling (half a
+         * cell), and the Arena chunk size. 64KB cells (16) serve 8-32KB
+         * objects from size-class bins; 4KB cells (12) suit small heaps.
+         * Clamped to [kMinCellSizeLog2, kMaxCellSizeLog2]. Default: 14 (16KB).
+         *
+         * Contexts with different cell sizes can share a thread: its sub-cell
+         * block cache is flushed back to its owner whenever another Context
+         * uses it, so alternating Contexts on one thread costs a flush per switch.
+         */
+        size_t cell_size_log2 = kCellSizeLog2;
+
+        /**
+         * @brief How free cells and superblocks are released by decommit_unused().
+         *
+         * Default: ReleasePolicy::kDecommit.
+         */
+        ReleasePolicy release_policy = ReleasePolicy::kDecommit;
+
+        // ---------------------------------------------------------------------
+        // Cache Policy (fixed per Context at construction)
+        // ---------------------------------------------------------------------
+
+        /**
+         * @brief Cells each thread caches, as two magazines of half this many.
+         *
+         * Larger caches make bursts of alloc_cell/free_cell cheaper; smaller
+         * ones keep fewer free cells where decommit_unused() cannot see them.
+         * Clamped to [2, kTlsCacheCapacity] and rounded down to even.
+         */
+        size_t tls_cache_capacity = kTlsCacheCapacity;
+
+        /**
+         * @brief Number of smallest size classes served from a TLS block cache.
+         *
+         * Larger size classes always take their bin lock. Clamped to
+         * [0, kTlsBinCacheCount].
+         */
+        size_t tls_bin_cache_count = kTlsBinCacheCount;
+
+        /**
+         * @brief Blocks each thread caches per size class.
+         *
+         * Clamped to [1, kTlsBinCacheCapacity].
+         */
+        size_t tls_bin_cache_capacity = kTlsBinCacheCapacity;
+
+        /**
+         * @brief Blocks moved from a bin into a TLS cache per refill.
+         *
+         * Clamped to [1, tls_bin_cache_capacity].
+         */
+        size_t tls_bin_batch_refill = kTlsBinBatchRefill;
+
+        /** @brief Empty cells each size class keeps instead of returning them to the pool. */
+        size_t warm_cells_per_bin = kWarmCellsPerBin;
+
+        /**
+         * @brief Page-guard one in this many allocations (see Context::set_page_guard_tag).
+         *
+         * Sampled per thread. 0 disables sampling. Default: 0.
+         */
+        size_t page_guard_sample_rate = 0;
+
 #ifdef CELL_ENABLE_BUDGET
         /**
          * @brief Maximum bytes this Context may allocate.
@@ -102,6 +268,50 @@ namespace Cell {
          * Default: 0 (unlimited).
          */
         size_t memory_budget = 0;
+
+        /**
+         * @brief Usage at which this Context starts reclaiming memory.
+         *
+         * Crossing the soft budget trims warm cells and cached blocks, takes
+         * back abandoned thread credit and then invokes the budget pressure
+         * callback so the application can release memory of its own. The same
+         * pipeline runs once more before an allocation fails at the hard
+         * limit (memory_budget). Should be below memory_budget.
+         * Default: 0 (no soft limit).
+         */
+        size_t soft_memory_budget = 0;
+
+        /**
+         * @brief Budget bytes each thread may reserve ahead of its allocations.
+         *
+         * Cell and sub-cell allocations spend thread-local credit and only
+         * touch the shared budget counter to refill or return it, so the TLS
+         * fast paths stay enabled. Unspent credit counts against the budget,
+         * so an allocation can fail up to budget_slack bytes early per other
+         * allocating thread. 0 makes accounting exact (one atomic per
+         * allocation and free).
+         */
+        size_t budget_slack = kDefaultBudgetSlack;
+#endif
+
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        /**
+         * @brief Events each thread's ring holds for Context::drain_events().
+         *
+         * Rounded up to a power of 2. Events arriving at a full ring are
+         * dropped and counted. Default: 4096 (128KB per thread).
+         */
+        size_t event_ring_capacity = kDefaultEventRingCapacity;
+#endif
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        /**
+         * @brief Mean bytes allocated between heap profiler samples.
+         *
+         * 0 disables sampling; it can be changed later through
+         * Context::heap_profiler(). Default: 512KB.
+         */
+        size_t heap_sample_interval = kDefaultHeapSampleInterval;
 #endif
     };
 
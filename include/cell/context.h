@@ -2,21 +2,38 @@
 
 #include "allocator.h"
 #include "buddy.h"
+#include "budget.h"
 #include "cell.h"
 #include "config.h"
 #include "debug.h"
+#include "event_ring.h"
+#include "heap_profiler.h"
 #include "large.h"
+#include "leak_table.h"
+#include "page_guard.h"
 #include "stats.h"
 #include "sub_cell.h"
+#include "tls_bin_cache.h"
 
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
 #include <memory>
 #include <mutex>
-#ifdef CELL_DEBUG_LEAKS
-#include <unordered_map>
+#if defined(CELL_ENABLE_BUDGET) || defined(CELL_ENABLE_INSTRUMENTATION)
+#include <vector>
 #endif
 
 namespace Cell {
 
+// Header-inline fast paths (alloc_fixed / free_fixed) skip the bookkeeping these builds need
+#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS) && !defined(CELL_ENABLE_STATS) &&   \
+    !defined(CELL_ENABLE_INSTRUMENTATION)
+#define CELL_INLINE_FAST_PATH 1
+#else
+#define CELL_INLINE_FAST_PATH 0
+#endif
+
 #ifdef CELL_ENABLE_BUDGET
     /**
      * @brief Callback invoked when an allocation would exceed the budget.
@@ -26,20 +43,50 @@ namespace Cell {
      *        the size used for budget accounting, not the raw requested size.
      * @param budget Current budget limit.
      * @param current Currently allocated bytes (tracked at rounded sizes).
+     *        Other threads' unspent credit (Config::budget_slack) is not
+     *        included, so current + allocation_size may be within budget.
      *
      * @note Budget enforcement uses rounded allocation sizes throughout to
      *       ensure the budget check and accounting are consistent. The caller
      *       should size their budget with this rounding in mind.
      */
     using BudgetCallback = void (*)(size_t allocation_size, size_t budget, size_t current);
+
+    /**
+     * @brief Callback invoked when an allocation would exceed its tag's budget.
+     *
+     * @param tag Tag whose budget would be exceeded.
+     * @param allocation_size Rounded bytes that would be allocated (as for BudgetCallback).
+     * @param budget The tag's budget limit.
+     * @param current Bytes currently allocated under the tag.
+     */
+    using TagBudgetCallback = void (*)(uint8_t tag, size_t allocation_size, size_t budget,
+                                       size_t current);
+
+    /**
+     * @brief Callback invoked when usage crosses the soft budget.
+     *
+     * Runs after the Context has reclaimed its own cached memory, on the
+     * allocating thread, so it may free memory (but should not block on
+     * other allocating threads). Also runs before an allocation fails at the
+     * hard limit; that allocation is retried once afterwards.
+     *
+     * @param soft_budget The soft budget limit.
+     * @param hard_budget The hard budget limit (0 = unlimited).
+     * @param current Currently allocated bytes, as get_budget_current().
+     */
+    using BudgetPressureCallback = void (*)(size_t soft_budget, size_t hard_budget,
+                                            size_t current);
 #endif
 
 #ifdef CELL_ENABLE_INSTRUMENTATION
     /**
      * @brief Callback invoked on each allocation and deallocation.
      * @param ptr Pointer to allocated/freed memory.
-     * @param size Size in bytes (requested size, not rounded).
-     * @param tag Application-defined memory tag.
+     * @param size Requested size for allocations; for frees, the block size
+     *        recorded in the cell header or buddy/large metadata.
+     * @param tag Application-defined memory tag. Frees read it from block metadata;
+     *        sub-cell blocks report the tag of the cell they were carved from.
      * @param is_alloc true for allocation, false for deallocation.
      */
     using AllocationCallback = void (*)(void *ptr, size_t size, uint8_t tag, bool is_alloc);
@@ -50,10 +97,13 @@ namespace Cell {
      *
      * RAII: Memory is released when the Context is destroyed.
      *
-     * @warning DESIGN CONSTRAINT: Only ONE Context instance per thread is supported at a time.
-     * The TLS cache scheme assumes a single active Context per thread. Sequential Contexts
-     * (create → destroy → create) are safe, but concurrent Contexts on the same thread will
-     * cause cache conflicts and undefined behavior.
+     * A thread may use several Contexts, including Contexts with different
+     * Config::cell_size_log2. The thread's cell-level and sub-cell bin caches each
+     * track the Context whose memory they hold and hand it back when another Context
+     * uses them, so alternating Contexts on one thread costs a cache flush per switch.
+     *
+     * @warning Threads other than the destroying one must call flush_tls_caches()
+     * before a Context they used is destroyed.
      */
     class Context {
     public:
@@ -86,20 +136,22 @@ namespace Cell {
         /**
          * @brief Allocates memory of the specified size.
          *
-         * Routing by size:
-         * - <= kMaxSubCellSize (8KB): Sub-cell bins
-         * - <= kCellSize (16KB): Full cell
-         * - <= 2MB: Buddy allocator
-         * - > 2MB: Direct OS allocation
+         * Routing by size (for the default 16KB cell size):
+         * - <= half the cell size (8KB): Sub-cell bins
+         * - <= cell size minus header (~16KB): Full cell
+         * - Fits the buddy max block (Config::buddy_max_order, 2MB default): Buddy allocator
+         * - Larger: Direct OS allocation
          *
          * Alignment guarantees:
-         * - Sub-cell/cell allocations: Naturally aligned to 16 bytes (cell alignment)
+         * - Sub-cell allocations: Aligned to their size class
+         * - Cell allocations: Aligned to 16 bytes
          * - Buddy allocations: 8-byte alignment (due to internal header)
          * - For alignments > 16 bytes, use alloc_aligned() instead
          *
          * @param size Size in bytes to allocate.
          * @param tag Application-defined tag for profiling (default: 0).
-         * @param alignment Required alignment (default: 8, must be power of 2, max 16).
+         * @param alignment Required alignment (default: 8, must be power of 2, max 16
+         *        unless a sub-cell bin holds size at that alignment).
          * @return Pointer to allocated memory, or nullptr on failure.
          *
          * @note The alignment parameter only affects size class selection for sub-cell.
@@ -138,7 +190,11 @@ namespace Cell {
          * @return Pointer to uninitialized memory for T, or nullptr on failure.
          */
         template <typename T> [[nodiscard]] T *alloc(uint8_t tag = 0) {
-            return static_cast<T *>(alloc_bytes(sizeof(T), tag, alignof(T)));
+            if constexpr (alignof(T) <= 8) {
+                return static_cast<T *>(alloc_fixed<sizeof(T)>(tag));
+            } else {
+                return static_cast<T *>(alloc_bytes(sizeof(T), tag, alignof(T)));
+            }
         }
 
         /**
@@ -153,6 +209,95 @@ namespace Cell {
             return static_cast<T *>(alloc_bytes(sizeof(T) * count, tag, alignof(T)));
         }
 
+        /**
+         * @brief Allocates N bytes with the size class resolved at compile time.
+         *
+         * A hit in the calling thread's bin cache is served inline: one bounds
+         * check and a pop, with no call into the allocator. Misses, sizes above
+         * the cached bins, and builds with stats, instrumentation or debug
+         * tracking go to alloc_bytes(N, tag). With budgets, the block is paid
+         * for from the thread's budget credit; with the heap profiler, the
+         * sampling countdown is charged inline as well.
+         *
+         * @tparam N Size in bytes.
+         * @param tag Application-defined tag for profiling (default: 0).
+         * @return Pointer to at least N bytes, or nullptr on failure.
+         */
+        template <size_t N> [[nodiscard]] void *alloc_fixed(uint8_t tag = 0) {
+            static_assert(N > 0, "alloc_fixed requires a non-zero size");
+#if CELL_INLINE_FAST_PATH
+            constexpr uint8_t bin_index = static_size_class(N);
+            if (CELL_UNLIKELY(m_page_guard_active.load(std::memory_order_relaxed))) {
+                return alloc_bytes(N, tag);
+            }
+#ifdef CELL_ENABLE_HEAP_PROFILER
+            if (heap_sample_tick(N)) {
+                return alloc_sampled(N, tag, 8);
+            }
+#endif
+            if constexpr (bin_index < kTlsBinCacheCount) {
+                claim_bin_cache();
+                TlsBinCache &cache = t_bin_cache[bin_index];
+                if (CELL_LIKELY(bin_index < m_tls_bin_count && cache.count > 0)) {
+#ifdef CELL_ENABLE_BUDGET
+                    if (CELL_UNLIKELY(!take_budget_credit(kSizeClasses[bin_index], tag))) {
+                        return alloc_bytes(N, tag);
+                    }
+                    void *block = cache.blocks[--cache.count];
+                    set_block_tag(block, tag);
+                    return block;
+#else
+                    return cache.blocks[--cache.count];
+#endif
+                }
+            }
+#endif
+            return alloc_bytes(N, tag);
+        }
+
+        /**
+         * @brief Frees a block from alloc_fixed<N>() or alloc_bytes(N).
+         *
+         * The inline counterpart of alloc_fixed(): the bin is known from N, so
+         * a free with room in the thread's bin cache reads no cell header.
+         * Everything else goes to free_bytes().
+         *
+         * @tparam N Size passed when the block was allocated.
+         * @param ptr Block to free (nullptr is ignored).
+         */
+        template <size_t N> void free_fixed(void *ptr) {
+#if CELL_INLINE_FAST_PATH
+            constexpr uint8_t bin_index = static_size_class(N);
+            if constexpr (bin_index < kTlsBinCacheCount) {
+                claim_bin_cache();
+                TlsBinCache &cache = t_bin_cache[bin_index];
+                if (CELL_LIKELY(ptr && bin_index < m_tls_bin_count &&
+                                cache.count < m_tls_bin_capacity &&
+                                !m_page_guards.has_allocations())) {
+                    assert(get_header(ptr, m_cell_mask)->size_class == bin_index &&
+                           "free_fixed<N> size does not match the allocation");
+#ifdef CELL_ENABLE_BUDGET
+                    if (CELL_UNLIKELY(
+                            !give_budget_credit(kSizeClasses[bin_index], block_tag(ptr)))) {
+                        free_bytes(ptr);
+                        return;
+                    }
+#endif
+#ifdef CELL_ENABLE_HEAP_PROFILER
+                    // Only here: free_bytes() records the free on every fallback
+                    m_heap_profiler.record_free(ptr);
+#endif
+#ifndef NDEBUG
+                    std::memset(ptr, kPoisonByte, kSizeClasses[bin_index]);
+#endif
+                    cache.blocks[cache.count++] = static_cast<FreeBlock *>(ptr);
+                    return;
+                }
+            }
+#endif
+            free_bytes(ptr);
+        }
+
         // =====================================================================
         // Batch Allocation API (SIMD-optimized for high throughput)
         // =====================================================================
@@ -192,12 +337,12 @@ namespace Cell {
          * @brief Explicitly allocates a large block (uses buddy or direct OS).
          *
          * Routing:
-         * - <= 2MB: Buddy allocator
-         * - > 2MB: Direct OS with optional huge pages
+         * - Fits the buddy max block (Config::buddy_max_order): Buddy allocator
+         * - Larger: Direct OS with optional huge pages
          *
          * @param size Size in bytes.
          * @param tag Application-defined tag for profiling.
-         * @param try_huge_pages For >2MB allocations, try to use huge pages.
+         * @param try_huge_pages For direct OS allocations, try to use huge pages.
          * @return Pointer to allocated memory, or nullptr on failure.
          */
         [[nodiscard]] void *alloc_large(size_t size, uint8_t tag = 0, bool try_huge_pages = true);
@@ -210,11 +355,16 @@ namespace Cell {
         void free_large(void *ptr);
 
         /**
-         * @brief Allocates memory with explicit alignment (buddy/large only).
+         * @brief Allocates memory with explicit alignment.
          *
-         * For sizes that fit in sub-cell/cell range, use regular alloc() which
-         * provides natural 16-byte alignment. This API is for cases requiring
-         * higher alignment (e.g., SIMD, cache lines, page boundaries).
+         * For cases requiring higher alignment (e.g., SIMD, cache lines, page
+         * boundaries). Sizes a sub-cell bin holds at the alignment, and cell
+         * sizes at alignments up to 16, are served from the cell tiers like
+         * alloc_bytes(): bin blocks are aligned to their size class.
+         *
+         * Larger requests that buddy blocks cannot align are served from
+         * dedicated, page-rounded OS mappings (huge pages where possible),
+         * never from the system heap.
          *
          * @param size Size in bytes.
          * @param alignment Required alignment (must be power of 2).
@@ -246,7 +396,12 @@ namespace Cell {
         // =====================================================================
 
         /**
-         * @brief Allocates a full Cell (16KB) from this context's pool.
+         * @brief Returns this context's cell size in bytes (Config::cell_size_log2).
+         */
+        [[nodiscard]] size_t cell_size() const { return m_cell_size; }
+
+        /**
+         * @brief Allocates a full Cell (cell_size() bytes) from this context's pool.
          * @param tag Application-defined tag for profiling (default: 0).
          * @return Pointer to an aligned CellData, or nullptr on failure.
          */
@@ -262,35 +417,128 @@ namespace Cell {
         // Memory Management API
         // =====================================================================
 
+        /**
+         * @brief Commits and prefaults memory ahead of traffic, e.g. at startup.
+         *
+         * Commits at least bytes_per_tier in the cell tier and in the buddy
+         * tier, faulting every page in (MADV_POPULATE_WRITE, or by touching
+         * it) so early requests pay neither a commit nor a page fault. Also
+         * carves one cell for each chosen sub-cell size class that has none.
+         * Committed memory stays subject to decommit_unused() and trim().
+         *
+         * @param bytes_per_tier Bytes to have committed in each of the cell and buddy tiers.
+         * @param block_sizes Sub-cell sizes whose bins get a carved cell; empty means all.
+         * @return Number of bytes newly committed.
+         */
+        size_t prewarm(size_t bytes_per_tier, std::initializer_list<size_t> block_sizes = {});
+
+        /**
+         * @brief Fills the calling thread's caches so its first allocations hit them.
+         *
+         * Refills the TLS bin cache of each chosen size class that is empty
+         * and loads a magazine of free cells into the TLS cell cache. Call
+         * once at thread start, after prewarm(). Sizes above the TLS-cached
+         * size classes are ignored.
+         *
+         * @param block_sizes Sub-cell sizes whose TLS caches to fill; empty means all.
+         */
+        void warm_thread(std::initializer_list<size_t> block_sizes = {});
+
         /**
          * @brief Decommits all fully-free memory regions to the OS.
          *
          * Call during loading screens, pause menus, or other idle periods
          * to release physical memory while keeping virtual address space.
+         * Config::release_policy chooses between dropping the pages at once
+         * and letting the OS reclaim them lazily under pressure.
          *
          * @return Number of bytes released to the OS.
          */
         size_t decommit_unused();
 
+        /**
+         * @brief Returns cached and free memory to the OS in proportion to pressure.
+         *
+         * kModerate releases the warm (empty) cells every sub-cell bin keeps,
+         * flushes the calling thread's TLS caches, and runs decommit_unused().
+         * kCritical additionally releases the pages of every free cell in the
+         * global pool instead of keeping the newest magazines resident. Other
+         * threads' TLS caches are untouched.
+         *
+         * Safe to call from any thread, e.g. a PressureMonitor.
+         *
+         * @param level Pressure severity.
+         * @return Number of bytes released to the OS.
+         */
+        size_t trim(PressureLevel level);
+
         /**
          * @brief Returns currently committed physical memory.
+         *
+         * Sums the cell region, the buddy superblocks and the large mappings.
          */
         [[nodiscard]] size_t committed_bytes() const;
 
+        // =====================================================================
+        // Page Guards
+        // =====================================================================
+
+        /**
+         * @brief Places every allocation with tag in front of a guard page.
+         *
+         * alloc_bytes, alloc_fixed, alloc_batch and alloc_aligned (alignments
+         * up to a page) requests with the tag get
+         * a dedicated mapping that ends at an inaccessible page (see
+         * PageGuardRegistry), so overflowing them faults immediately. Other
+         * tags keep the normal paths; while any tag or sampling is enabled,
+         * each allocation pays one extra flag check, and frees check the
+         * registry only while guarded blocks are live.
+         *
+         * @param tag Tag to guard.
+         * @param enabled false returns the tag to the normal paths.
+         */
+        void set_page_guard_tag(uint8_t tag, bool enabled);
+
+        /** @brief Returns true if allocations with tag are page-guarded. */
+        [[nodiscard]] bool page_guard_tag(uint8_t tag) const {
+            return m_page_guard_tags[tag].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Page-guards one in one_in allocations of any tag (0 = off).
+         *
+         * Each thread counts its own allocations.
+         */
+        void set_page_guard_sample_rate(size_t one_in);
+
+        /** @brief Returns the page guard sampling rate (0 = off). */
+        [[nodiscard]] size_t page_guard_sample_rate() const {
+            return m_page_guard_sample_rate.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Returns the number of live page-guarded allocations. */
+        [[nodiscard]] size_t page_guarded_count() const {
+            return m_page_guards.allocation_count();
+        }
+
         // =====================================================================
         // Statistics (compile-time optional via CELL_ENABLE_STATS)
         // =====================================================================
 
 #ifdef CELL_ENABLE_STATS
         /**
-         * @brief Returns current memory statistics.
+         * @brief Returns a snapshot of the memory statistics.
+         *
+         * Counters are kept in per-thread shards and summed here, so the
+         * snapshot does not change as allocation continues; call again for
+         * fresh values. OS activity is read from the cell and buddy tiers.
          */
-        [[nodiscard]] const MemoryStats &get_stats() const { return m_stats; }
+        [[nodiscard]] MemoryStats get_stats() const;
 
         /**
          * @brief Prints memory statistics to stdout.
          */
-        void dump_stats() const { m_stats.dump(); }
+        void dump_stats() const { get_stats().dump(); }
 
         /**
          * @brief Resets all statistics counters.
@@ -316,16 +564,76 @@ namespace Cell {
 
         /**
          * @brief Returns current memory usage tracked against budget.
-         * This is the actual allocated size (rounded to size classes).
+         * This is the actual allocated size (rounded to size classes), not
+         * counting budget credit that threads have reserved but not spent.
+         */
+        [[nodiscard]] size_t get_budget_current() const;
+
+        /**
+         * @brief Sets the budget credit each thread may hold (see Config::budget_slack).
+         *
+         * Threads adjust their credit at their next refill or return.
+         */
+        void set_budget_slack(size_t bytes) { m_budget_slack = bytes; }
+
+        /**
+         * @brief Returns the budget credit each thread may hold.
+         */
+        [[nodiscard]] size_t get_budget_slack() const { return m_budget_slack; }
+
+        /**
+         * @brief Sets the memory budget for one allocation tag.
+         *
+         * Enforced alongside the Context budget on the same rounded sizes.
+         * Each thread holds up to the budget slack of credit per tag, so a
+         * tag's allocation can fail that much early per other allocating thread.
+         *
+         * @param tag Tag to limit.
+         * @param bytes Maximum bytes allocated under tag. 0 = unlimited.
+         */
+        void set_tag_budget(uint8_t tag, size_t bytes) { m_tag_budget[tag] = bytes; }
+
+        /**
+         * @brief Returns the budget limit for tag (0 = unlimited).
          */
-        [[nodiscard]] size_t get_budget_current() const {
-            return m_budget_current.load(std::memory_order_relaxed);
+        [[nodiscard]] size_t get_tag_budget(uint8_t tag) const { return m_tag_budget[tag]; }
+
+        /**
+         * @brief Returns the bytes currently allocated under tag (rounded sizes).
+         *
+         * Tracked for every tag, whether or not it has a budget.
+         */
+        [[nodiscard]] size_t get_tag_budget_current(uint8_t tag) const;
+
+        /**
+         * @brief Sets the callback for allocations that would exceed tag's budget.
+         */
+        void set_tag_budget_callback(uint8_t tag, TagBudgetCallback cb) {
+            m_tag_budget_callbacks[tag] = cb;
         }
 
         /**
          * @brief Sets a callback for when allocations exceed budget.
          */
         void set_budget_callback(BudgetCallback cb) { m_budget_callback = cb; }
+
+        /**
+         * @brief Sets the soft budget (see Config::soft_memory_budget).
+         * @param bytes Usage that starts reclamation. 0 = no soft limit.
+         */
+        void set_soft_budget(size_t bytes) { m_soft_budget = bytes; }
+
+        /**
+         * @brief Returns the soft budget limit (0 = none).
+         */
+        [[nodiscard]] size_t get_soft_budget() const { return m_soft_budget; }
+
+        /**
+         * @brief Sets the callback run when usage crosses the soft budget.
+         */
+        void set_budget_pressure_callback(BudgetPressureCallback cb) {
+            m_budget_pressure_callback = cb;
+        }
 #endif
 
         // =====================================================================
@@ -343,12 +651,64 @@ namespace Cell {
          * @brief Returns the current allocation callback.
          */
         [[nodiscard]] AllocationCallback get_alloc_callback() const { return m_alloc_callback; }
+
+        /**
+         * @brief Turns the event stream on or off.
+         *
+         * While on, every allocation and free appends an AllocEvent to the
+         * calling thread's ring (Config::event_ring_capacity events, created
+         * on the thread's first event). Recording is lock-free and runs
+         * alongside any callback; a full ring drops events instead of blocking.
+         */
+        void set_event_stream(bool enabled) {
+            m_event_stream.store(enabled, std::memory_order_relaxed);
+        }
+
+        /** @brief Returns true while the event stream is on. */
+        [[nodiscard]] bool event_stream_enabled() const {
+            return m_event_stream.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Moves buffered events from all threads' rings into out.
+         *
+         * Events from one thread arrive in order; events from different
+         * threads are not merged (sort by AllocEvent::timestamp if needed).
+         * Rings of exited threads are released once drained. Call from one
+         * consumer thread at a time.
+         *
+         * @param out Buffer for at least max_events events.
+         * @param max_events Capacity of out.
+         * @return Number of events written.
+         */
+        size_t drain_events(AllocEvent *out, size_t max_events);
+
+        /**
+         * @brief Returns the number of events dropped because a ring was full.
+         */
+        [[nodiscard]] size_t dropped_events() const;
 #endif
 
         // =====================================================================
         // Debug Features (compile-time optional)
         // =====================================================================
 
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        // =====================================================================
+        // Heap Profiler (compile-time optional via CELL_ENABLE_HEAP_PROFILER)
+        // =====================================================================
+
+        /**
+         * @brief Returns the sampling heap profiler.
+         *
+         * Samples alloc_bytes(), alloc_fixed() and alloc_batch() at
+         * Config::heap_sample_interval; use it to change the interval, reset
+         * the allocation window, or write a pprof heap profile.
+         */
+        [[nodiscard]] HeapProfiler &heap_profiler() { return m_heap_profiler; }
+        [[nodiscard]] const HeapProfiler &heap_profiler() const { return m_heap_profiler; }
+#endif
+
 #ifdef CELL_DEBUG_GUARDS
         /**
          * @brief Checks if an allocation's guard bytes are intact.
@@ -393,6 +753,14 @@ namespace Cell {
          */
         void free_to_bin(void *ptr, CellHeader *header);
 
+        /**
+         * @brief Locks a size class bin.
+         *
+         * With CELL_ENABLE_STATS, tries the lock first and counts a
+         * BinEvent::kLockContended if another thread holds it.
+         */
+        std::unique_lock<std::mutex> lock_bin(size_t bin_index);
+
         /**
          * @brief Initializes a fresh cell for a size class.
          * @param cell Raw cell memory.
@@ -401,13 +769,62 @@ namespace Cell {
          */
         void init_cell_for_bin(void *cell, size_t bin_index, uint8_t tag);
 
+        /**
+         * @brief Returns a bitmask of the bins for block_sizes, or every bin if it is empty.
+         */
+        static uint32_t bin_mask_for(std::initializer_list<size_t> block_sizes);
+
+        /**
+         * @brief Makes t_bin_cache hold this Context's blocks.
+         *
+         * Blocks cached for another Context are flushed to that Context's bins
+         * first, so they are never handed out here or masked with this
+         * Context's cell size.
+         */
+        void claim_bin_cache() {
+            if (CELL_UNLIKELY(t_bin_cache_owner != this)) {
+                take_bin_cache();
+            }
+        }
+
+        /** @brief Slow path of claim_bin_cache(). */
+        void take_bin_cache();
+
+        /** @brief Returns the blocks in t_bin_cache to this Context's bins. */
+        void flush_bin_cache();
+
         /**
          * @brief Batch refills TLS cache from global bin.
-         * @param bin_index Size class index (must be < kTlsBinCacheCount).
+         * @param bin_index Size class index (must be < m_tls_bin_count).
          * @param tag Tag for profiling (used if new cell is needed).
          */
         void batch_refill_tls_bin(size_t bin_index, uint8_t tag);
 
+        /**
+         * @brief Returns true if a block for size fits the buddy max block size.
+         */
+        bool fits_buddy(size_t size) const;
+
+        /**
+         * @brief Returns true if a sub-cell bin serves size at an alignment above 16.
+         *
+         * Bin blocks are aligned to their size class. Never true with
+         * CELL_DEBUG_GUARDS, whose front guard offsets the user pointer.
+         */
+        bool fits_aligned_bin(size_t size, size_t alignment) const;
+
+        /** @brief Returns true if this allocation should be page-guarded. */
+        bool should_page_guard(uint8_t tag);
+
+        /** @brief Allocates from m_page_guards with stats, budget and debug tracking. */
+        void *alloc_page_guarded(size_t size, uint8_t tag, size_t alignment);
+
+        /** @brief Frees a block owned by m_page_guards. */
+        void free_page_guarded(void *ptr);
+
+        /** @brief Recomputes m_page_guard_active. Caller holds m_page_guard_config_lock. */
+        void update_page_guard_active();
+
         // =====================================================================
         // Members
         // =====================================================================
@@ -416,40 +833,232 @@ namespace Cell {
         size_t m_reserved_size = 0;             ///< Total reserved bytes.
         std::unique_ptr<Allocator> m_allocator; ///< Cell-level allocator.
 
+        // Cell geometry from Config::cell_size_log2
+        size_t m_cell_size_log2;                    ///< Log2 of the cell size.
+        size_t m_cell_size;                         ///< Cell size in bytes.
+        uintptr_t m_cell_mask;                      ///< ~(m_cell_size - 1) for get_header().
+        size_t m_num_bins;                          ///< Size classes served (up to half a cell).
+        size_t m_max_subcell_size;                  ///< Largest sub-cell size class.
+        uint16_t m_blocks_per_cell[kNumSizeBins]{}; ///< Blocks per cell for each bin.
+
         SizeBin m_bins[kNumSizeBins];         ///< Size class bins.
         std::mutex m_bin_locks[kNumSizeBins]; ///< Per-bin locks.
 
-        // Buddy allocator for 32KB - 2MB
+        // Cache policy from Config, clamped to the TLS array sizes
+        size_t m_tls_bin_count;      ///< Bins served from the TLS bin cache.
+        size_t m_tls_bin_capacity;   ///< Blocks cached per bin per thread.
+        size_t m_tls_bin_refill;     ///< Blocks moved per TLS bin refill.
+        size_t m_warm_cells_per_bin; ///< Empty cells kept per bin.
+
+        // Buddy allocator for 32KB up to its configured max block size
         void *m_buddy_base = nullptr;     ///< Start of buddy region.
         size_t m_buddy_reserved_size = 0; ///< Buddy reserved size.
         std::unique_ptr<BuddyAllocator> m_buddy;
 
-        // Large allocation registry for > 2MB
+        // Large allocation registry for sizes above the buddy max block
         LargeAllocRegistry m_large_allocs;
 
+        // Page-guarded allocations for selected tags and sampled requests
+        PageGuardRegistry m_page_guards;
+        std::atomic<bool> m_page_guard_tags[256]{};
+        std::atomic<size_t> m_page_guard_sample_rate{0};
+        std::atomic<bool> m_page_guard_active{false}; ///< Any tag guarded or sampling on.
+        std::mutex m_page_guard_config_lock;          ///< Serializes the setters.
+
 #ifdef CELL_ENABLE_STATS
-        mutable MemoryStats m_stats;
+        mutable StatsCounters m_stats;
+#endif
+
+#if defined(CELL_ENABLE_BUDGET) || defined(CELL_ENABLE_INSTRUMENTATION)
+        uint64_t m_context_id; ///< Matches thread-local credit and event rings to this Context.
 #endif
 
 #ifdef CELL_DEBUG_LEAKS
-        mutable std::unordered_map<void *, DebugAllocation> m_live_allocs;
-        mutable std::mutex m_debug_mutex;
+        LeakTable m_live_allocs; ///< Sharded; tracking takes no Context-wide lock.
 #endif
 
 #ifdef CELL_ENABLE_BUDGET
         size_t m_budget = 0;
-        std::atomic<size_t> m_budget_current{0};
+        size_t m_budget_slack = kDefaultBudgetSlack;
+        std::atomic<size_t> m_budget_current{0}; ///< Allocated bytes plus threads' credit.
         BudgetCallback m_budget_callback = nullptr;
 
-        bool check_budget(size_t size);
-        void record_budget_alloc(size_t size);
-        void record_budget_free(size_t size);
+        // Soft budget: crossing it runs relieve_budget_pressure() once until usage drops back
+        size_t m_soft_budget = 0;
+        BudgetPressureCallback m_budget_pressure_callback = nullptr;
+        std::atomic<bool> m_soft_budget_crossed{false};
+        std::mutex m_budget_pressure_lock; ///< Held while the reclamation pipeline runs.
+
+        // Per-tag budgets; a tag's counter includes threads' credit like m_budget_current
+        size_t m_tag_budget[kNumBudgetTags]{};
+        std::atomic<size_t> m_tag_budget_current[kNumBudgetTags]{};
+        TagBudgetCallback m_tag_budget_callbacks[kNumBudgetTags]{};
+
+        /// Tag of each cell-region block, one byte per 16 bytes (sub-cell blocks share cells).
+        uint8_t *m_block_tags = nullptr;
+        size_t m_block_tags_size = 0; ///< Bytes reserved for m_block_tags.
+
+        // Thread credit registry: one entry per thread that has reserved credit
+        mutable std::mutex m_budget_credits_lock; ///< Guards m_budget_credits.
+        std::vector<std::shared_ptr<BudgetCredit>> m_budget_credits;
+
+        // Buddy and large allocations: exact, against the shared counters
+        bool check_budget(size_t size, uint8_t tag);
+        void record_budget_alloc(size_t size, uint8_t tag);
+        void record_budget_free(size_t size, uint8_t tag);
+
+        /**
+         * @brief Runs the soft-budget pipeline if usage crossed the soft limit.
+         *
+         * Re-arms once usage is back under the limit. Usage here includes
+         * threads' unspent credit, so the crossing is seen up to the budget
+         * slack early, at a credit refill rather than on every allocation.
+         */
+        void check_soft_budget();
+
+        /**
+         * @brief Reclaims cached memory and invokes the budget pressure callback.
+         *
+         * Takes back abandoned thread credit, trims the Context
+         * (PressureLevel::kModerate) and then calls the pressure callback.
+         * Never waits: if another thread is already running the pipeline,
+         * returns false without doing anything.
+         *
+         * @return true if the pipeline ran.
+         */
+        bool relieve_budget_pressure();
+
+        /** @brief Returns the m_block_tags index of the cell-region block at ptr. */
+        size_t block_tag_index(const void *ptr) const {
+            return (reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(m_base)) >>
+                   kBlockTagShift;
+        }
+
+        /** @brief Records the tag of the cell-region block at ptr. */
+        void set_block_tag(const void *ptr, uint8_t tag) {
+            m_block_tags[block_tag_index(ptr)] = tag;
+        }
+
+        /** @brief Returns the tag recorded for the cell-region block at ptr. */
+        uint8_t block_tag(const void *ptr) const { return m_block_tags[block_tag_index(ptr)]; }
+
+        /**
+         * @brief Allocator::SuperblockCommitHook that commits a superblock's block tags.
+         *
+         * m_block_tags is only reserved, so tags take memory as the cell
+         * region they describe is committed.
+         */
+        static bool commit_block_tags(void *user_data, void *superblock);
+
+        /** @brief Allocator::SuperblockReleaseHook that discards a superblock's block tags. */
+        static void release_block_tags(void *user_data, void *superblock);
+
+        /**
+         * @brief Spends size bytes of the calling thread's credit for tag, if it has enough.
+         * @return false if the caller must go through charge_budget().
+         */
+        bool take_budget_credit(size_t size, uint8_t tag) {
+            ThreadBudgetCredit &local = t_budget_credit;
+            if (CELL_LIKELY(local.context_id == m_context_id)) {
+                BudgetCredit &credit = *local.credit;
+                size_t held = credit.bytes.load(std::memory_order_relaxed);
+                size_t tag_held = credit.tag_bytes[tag].load(std::memory_order_relaxed);
+                if (CELL_LIKELY(held >= size && tag_held >= size)) {
+                    credit.bytes.store(held - size, std::memory_order_relaxed);
+                    credit.tag_bytes[tag].store(tag_held - size, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Adds size freed bytes to the calling thread's credit, if it stays within slack.
+         * @return false if the caller must go through refund_budget().
+         */
+        bool give_budget_credit(size_t size, uint8_t tag) {
+            ThreadBudgetCredit &local = t_budget_credit;
+            if (CELL_LIKELY(local.context_id == m_context_id)) {
+                BudgetCredit &credit = *local.credit;
+                size_t held = credit.bytes.load(std::memory_order_relaxed) + size;
+                size_t tag_held = credit.tag_bytes[tag].load(std::memory_order_relaxed) + size;
+                if (CELL_LIKELY(held <= m_budget_slack && tag_held <= m_budget_slack)) {
+                    credit.bytes.store(held, std::memory_order_relaxed);
+                    credit.tag_bytes[tag].store(tag_held, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Charges a cell or sub-cell allocation against the Context and tag budgets.
+         *
+         * Spends the thread's credit, refilling it from the shared counters
+         * when it runs short.
+         *
+         * @param notify Invoke the budget callbacks if the charge fails.
+         * @return false if the allocation would exceed either budget.
+         */
+        bool charge_budget(size_t size, uint8_t tag, bool notify = true);
+
+        /**
+         * @brief Returns a freed cell or sub-cell block's bytes to the budgets.
+         *
+         * Credit beyond the slack goes back to the shared counters.
+         */
+        void refund_budget(size_t size, uint8_t tag);
+
+        /**
+         * @brief Tops up credit to at least size bytes from a shared counter.
+         * @return false if counter cannot grant the shortfall within limit.
+         */
+        bool refill_budget_credit(std::atomic<size_t> &credit, std::atomic<size_t> &counter,
+                                  size_t limit, size_t size);
+
+        /** @brief Moves credit above half the slack back to counter. */
+        void return_budget_credit(std::atomic<size_t> &credit, std::atomic<size_t> &counter);
+
+        /** @brief Returns the calling thread's credit, creating and registering it if needed. */
+        BudgetCredit *thread_budget_credit();
+
+        /** @brief Returns all of credit to the shared counters. */
+        void release_budget_credit(BudgetCredit &credit);
+
+        /** @brief Returns credit of threads that let go of it. Caller holds the lock. */
+        void reclaim_budget_credits();
+#endif
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        HeapProfiler m_heap_profiler{kDefaultHeapSampleInterval};
+
+        /**
+         * @brief Allocation whose size crossed the thread's sample point.
+         *
+         * Re-arms the countdown, allocates through alloc_bytes(), and records
+         * the result if the profiler is sampling.
+         */
+        void *alloc_sampled(size_t size, uint8_t tag, size_t alignment);
 #endif
 
 #ifdef CELL_ENABLE_INSTRUMENTATION
         AllocationCallback m_alloc_callback = nullptr;
 
-        void invoke_alloc_callback(void *ptr, size_t size, uint8_t tag, bool is_alloc);
+        // Event stream: one ring per thread that has recorded an event
+        std::atomic<bool> m_event_stream{false};
+        size_t m_event_ring_capacity = kDefaultEventRingCapacity;
+        mutable std::mutex m_event_rings_lock; ///< Guards the fields below.
+        std::vector<std::shared_ptr<EventRing>> m_event_rings;
+        size_t m_retired_dropped_events = 0; ///< Drops from released rings.
+
+        /**
+         * @brief Reports an allocation or free to the callback and the event stream.
+         * @param size_class Bin index, kFullCellMarker, kEventClassBuddy or kEventClassLarge.
+         */
+        void record_event(void *ptr, size_t size, uint8_t size_class, uint8_t tag, bool is_alloc);
+
+        /** @brief Returns the calling thread's ring for this Context, registering it once. */
+        EventRing *thread_event_ring();
 #endif
     };
 
@@ -10,8 +10,11 @@
  * Compile-time flags:
  * - CELL_DEBUG_GUARDS: Enable guard bytes before/after allocations
  * - CELL_DEBUG_STACKTRACE: Capture stack trace on allocation
+ * - CELL_FRAME_POINTER_UNWIND: Walk frame pointers instead of calling backtrace()
  * - CELL_DEBUG_LEAKS: Track all allocations for leak detection
  *
+ * Stack capture is also built for CELL_ENABLE_HEAP_PROFILER (see heap_profiler.h).
+ *
  * All features have zero overhead when disabled.
  */
 
@@ -37,12 +40,21 @@ namespace Cell {
     /** @brief Maximum stack frames to capture per allocation. */
     static constexpr size_t kMaxStackDepth = 16;
 
+    /** @brief Handle to a deduplicated stack trace in the StackDepot (see stack_depot.h). */
+    using StackId = uint32_t;
+
+    /** @brief StackId meaning "no trace captured". */
+    static constexpr StackId kInvalidStackId = 0;
+#endif
+
+#if defined(CELL_DEBUG_STACKTRACE) || defined(CELL_ENABLE_HEAP_PROFILER)
+
     /**
      * @brief Captures the current call stack.
      *
      * Platform support:
-     * - Linux/glibc: backtrace()
-     * - macOS/iOS: backtrace()
+     * - Linux/glibc: backtrace(), or a frame-pointer walk with CELL_FRAME_POINTER_UNWIND
+     * - macOS/iOS: backtrace(), or a frame-pointer walk with CELL_FRAME_POINTER_UNWIND
      * - Android: _Unwind_Backtrace()
      * - Windows: CaptureStackBackTrace()
      *
@@ -75,8 +87,7 @@ namespace Cell {
         size_t size; ///< Requested size in bytes.
         uint8_t tag; ///< Application-defined tag.
 #ifdef CELL_DEBUG_STACKTRACE
-        void *stack[kMaxStackDepth]; ///< Captured stack trace.
-        size_t stack_depth;          ///< Number of valid stack frames.
+        StackId stack_id; ///< Allocation site in the StackDepot, or kInvalidStackId.
 #endif
     };
 #endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "config.h"
+
+#ifdef CELL_ENABLE_INSTRUMENTATION
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Cell {
+
+    // =========================================================================
+    // Allocation Events
+    // =========================================================================
+
+    /** @brief AllocEvent::size_class for a buddy allocation. */
+    static constexpr uint8_t kEventClassBuddy = 0xFD;
+
+    /** @brief AllocEvent::size_class for a large (direct OS) allocation. */
+    static constexpr uint8_t kEventClassLarge = 0xFE;
+
+    /** @brief Kind of an AllocEvent. */
+    enum class AllocEventOp : uint8_t {
+        kAlloc, ///< Block handed out.
+        kFree   ///< Block returned.
+    };
+
+    /**
+     * @brief One allocation or free, as recorded in a thread's event ring.
+     */
+    struct AllocEvent {
+        uint64_t timestamp; ///< std::chrono::steady_clock time in nanoseconds.
+        void *ptr;          ///< Pointer returned to / passed by the caller.
+        size_t size;        ///< Requested size for kAlloc; block size for kFree.
+        uint8_t size_class; ///< Bin index, kFullCellMarker, kEventClassBuddy or kEventClassLarge.
+        uint8_t tag;        ///< Allocation tag; for kFree, the block's (sub-cell: its cell's).
+        AllocEventOp op;    ///< Alloc or free.
+    };
+
+    static_assert(sizeof(AllocEvent) <= 32, "AllocEvent should stay within half a cache line");
+
+    // =========================================================================
+    // EventRing
+    // =========================================================================
+
+    /**
+     * @brief Bounded single-producer, single-consumer queue of AllocEvents.
+     *
+     * The owning thread pushes without locking or read-modify-write
+     * operations; one consumer at a time pops in batches. When the ring is
+     * full, new events are dropped and counted rather than blocking the
+     * allocating thread.
+     */
+    class EventRing {
+    public:
+        /**
+         * @brief Creates a ring.
+         * @param capacity Events held; rounded up to a power of 2 (at least 2).
+         */
+        explicit EventRing(size_t capacity);
+
+        // Non-copyable, non-movable
+        EventRing(const EventRing &) = delete;
+        EventRing &operator=(const EventRing &) = delete;
+        EventRing(EventRing &&) = delete;
+        EventRing &operator=(EventRing &&) = delete;
+
+        /**
+         * @brief Appends an event. Producer thread only.
+         * @return false if the ring was full and the event was dropped.
+         */
+        bool push(const AllocEvent &event) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head - m_cached_tail >= m_capacity) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head - m_cached_tail >= m_capacity) {
+                    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+                                    std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            m_events[head & (m_capacity - 1)] = event;
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Moves up to max_events of the oldest events to out. Consumer only.
+         * @return Number of events copied.
+         */
+        size_t pop(AllocEvent *out, size_t max_events);
+
+        /** @brief Returns true if no events are waiting. */
+        [[nodiscard]] bool empty() const {
+            return m_head.load(std::memory_order_acquire) ==
+                   m_tail.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Returns the number of events dropped because the ring was full. */
+        [[nodiscard]] size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+        /** @brief Returns the ring's capacity in events. */
+        [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    private:
+        size_t m_capacity;
+        std::unique_ptr<AllocEvent[]> m_events;
+
+        // Producer side
+        alignas(64) std::atomic<size_t> m_head{0}; ///< Next slot to write.
+        size_t m_cached_tail = 0;                  ///< Producer's last view of m_tail.
+        std::atomic<size_t> m_dropped{0};          ///< Written by the producer only.
+
+        // Consumer side
+        alignas(64) std::atomic<size_t> m_tail{0}; ///< Next slot to read.
+    };
+
+}
+
+#endif // CELL_ENABLE_INSTRUMENTATION
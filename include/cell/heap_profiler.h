@@ -0,0 +1,211 @@
+#pragma once
+
+#include "config.h"
+#include "sub_cell.h"
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Cell {
+
+    // =========================================================================
+    // Heap Profiler Configuration
+    // =========================================================================
+
+    /** @brief Maximum stack frames recorded per sampled allocation. */
+    static constexpr size_t kHeapProfileMaxDepth = 32;
+
+    /** @brief Slots in the counting filter that screens frees for sampled pointers. */
+    static constexpr size_t kHeapSampleFilterSlots = 1 << 16;
+
+    /** @brief How often a thread rechecks the interval while sampling is off. */
+    static constexpr int64_t kHeapSampleDisabledRecheck = 1 << 20;
+
+    // =========================================================================
+    // Per-Thread Sampling State
+    // =========================================================================
+
+    /**
+     * @brief Per-thread countdown to the next sampled allocation.
+     *
+     * Each allocation subtracts its size; the allocation that takes the count
+     * below zero is sampled and the count is re-armed with a fresh interval.
+     * A zero rng marks a thread that has not drawn its first interval yet.
+     */
+    struct HeapSampleState {
+        int64_t bytes_until_sample = 0; ///< Bytes left before the next sample.
+        uint64_t rng = 0;               ///< xorshift64* state for interval draws.
+    };
+
+    /** @brief Thread-local sampling state (shared by all Contexts on the thread). */
+    inline thread_local HeapSampleState t_heap_sample;
+
+    /**
+     * @brief Charges size bytes to the calling thread's countdown.
+     * @return true if this allocation crossed a sample point; call HeapProfiler::rearm().
+     */
+    inline bool heap_sample_tick(size_t size) {
+        t_heap_sample.bytes_until_sample -= static_cast<int64_t>(size);
+        return CELL_UNLIKELY(t_heap_sample.bytes_until_sample < 0);
+    }
+
+    // =========================================================================
+    // HeapProfiler
+    // =========================================================================
+
+    /**
+     * @brief Sampling heap profiler with pprof-compatible output.
+     *
+     * Sampling is a Poisson process over allocated bytes: intervals between
+     * samples are drawn from an exponential distribution with mean
+     * sample_interval(), so an allocation of s bytes is sampled with
+     * probability 1 - exp(-s / interval) regardless of what else the thread
+     * allocates. Unsampled allocations pay one thread-local subtraction.
+     *
+     * Sampled allocations record their call stack and are aggregated into
+     * per-stack buckets holding live (in-use) and cumulative (allocated)
+     * counts. Frees of sampled pointers are found through a counting filter
+     * indexed by pointer hash, so unsampled frees pay one table load; only a
+     * filter hit takes the lock.
+     *
+     * profile() writes the legacy pprof heap format ("heap_v2"), which pprof
+     * un-samples using the recorded interval. Only available when
+     * CELL_ENABLE_HEAP_PROFILER is defined.
+     */
+    class HeapProfiler {
+    public:
+        /**
+         * @brief Creates a profiler.
+         * @param sample_interval Mean bytes between samples; 0 disables sampling.
+         */
+        explicit HeapProfiler(size_t sample_interval);
+
+        // Non-copyable, non-movable
+        HeapProfiler(const HeapProfiler &) = delete;
+        HeapProfiler &operator=(const HeapProfiler &) = delete;
+        HeapProfiler(HeapProfiler &&) = delete;
+        HeapProfiler &operator=(HeapProfiler &&) = delete;
+
+        /**
+         * @brief Sets the mean bytes between samples; 0 disables sampling.
+         *
+         * Threads pick up the new interval at their next sample point.
+         */
+        void set_sample_interval(size_t bytes) {
+            m_sample_interval.store(bytes, std::memory_order_relaxed);
+        }
+
+        /** @brief Returns the mean bytes between samples (0 = disabled). */
+        [[nodiscard]] size_t sample_interval() const {
+            return m_sample_interval.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Re-arms the calling thread's countdown after heap_sample_tick() fired.
+         *
+         * The new countdown includes pending_size, so re-issuing the
+         * allocation that fired the tick does not fire it again.
+         *
+         * @param pending_size Bytes the caller is about to charge again.
+         * @return true if the allocation should be recorded.
+         */
+        bool rearm(size_t pending_size);
+
+        /**
+         * @brief Records a sampled allocation and captures its call stack.
+         * @param ptr Pointer returned to the caller.
+         * @param size Requested size in bytes.
+         */
+        void record_alloc(void *ptr, size_t size);
+
+        /**
+         * @brief Removes ptr from the live profile if it was sampled.
+         */
+        void record_free(void *ptr) {
+            if (CELL_UNLIKELY(m_filter[filter_slot(ptr)].load(std::memory_order_relaxed) != 0)) {
+                record_free_slow(ptr);
+            }
+        }
+
+        /**
+         * @brief Returns the profile in the legacy pprof heap text format.
+         *
+         * Each stack reports in-use and cumulative sampled objects and bytes,
+         * followed by the process memory map (on Linux) for symbolization:
+         * @code
+         * heap profile: 3: 1536 [ 10: 5120] @ heap_v2/524288
+         *      2: 1024 [ 6: 3072] @ 0x4011f6 0x401a2c 0x7f3a1c029d90
+         * @endcode
+         * View live memory with `pprof -sample_index=inuse_space` and the
+         * allocation rate since the last reset() with `-sample_index=alloc_space`.
+         */
+        [[nodiscard]] std::string profile() const;
+
+        /**
+         * @brief Writes profile() to path.
+         * @return false if the file could not be written.
+         */
+        bool write_profile(const char *path) const;
+
+        /**
+         * @brief Clears cumulative allocation counts, starting a new rate window.
+         *
+         * Live samples are kept, so in-use figures are unaffected.
+         */
+        void reset();
+
+        /** @brief Returns the number of sampled allocations not yet freed. */
+        [[nodiscard]] size_t live_sample_count() const;
+
+        /** @brief Returns the number of allocations sampled since the last reset(). */
+        [[nodiscard]] size_t sample_count() const;
+
+    private:
+        /** @brief Sampled allocations that share a call stack. */
+        struct Bucket {
+            void *stack[kHeapProfileMaxDepth]; ///< Return addresses, innermost first.
+            size_t depth = 0;                  ///< Valid entries in stack.
+            size_t inuse_count = 0;            ///< Live sampled objects.
+            size_t inuse_bytes = 0;            ///< Live sampled bytes.
+            size_t alloc_count = 0;            ///< Sampled objects since reset().
+            size_t alloc_bytes = 0;            ///< Sampled bytes since reset().
+        };
+
+        /** @brief A sampled allocation that has not been freed. */
+        struct LiveSample {
+            Bucket *bucket; ///< Bucket charged with this allocation.
+            size_t size;    ///< Requested size.
+        };
+
+        static size_t filter_slot(const void *ptr) {
+            auto bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr) >> 4);
+            return static_cast<size_t>((bits * 0x9E3779B97F4A7C15ULL) >> 48);
+        }
+        static_assert(kHeapSampleFilterSlots == size_t(1) << 16,
+                      "filter_slot() produces 16-bit indices");
+
+        void record_free_slow(void *ptr);
+        Bucket *find_bucket(void *const *stack, size_t depth); ///< Caller holds m_mutex.
+        void release_sample(void *ptr, const LiveSample &sample); ///< Caller holds m_mutex.
+
+        std::atomic<size_t> m_sample_interval;
+
+        /// Live samples per slot; nonzero sends a free to record_free_slow().
+        std::unique_ptr<std::atomic<uint16_t>[]> m_filter;
+
+        mutable std::mutex m_mutex;
+        std::unordered_multimap<uint64_t, Bucket> m_buckets; ///< By stack hash. Node-stable.
+        std::unordered_map<void *, LiveSample> m_live;       ///< By pointer.
+        size_t m_sample_count = 0;                           ///< Guarded by m_mutex.
+    };
+
+}
+
+#endif // CELL_ENABLE_HEAP_PROFILER
@@ -27,6 +27,9 @@ namespace Cell {
         /** @brief Alignment for large allocations */
         static constexpr size_t kLargeAlignment = 2 * 1024 * 1024; // 2MB
 
+        /** @brief Huge page size assumed for MAP_HUGETLB / MADV_HUGEPAGE mappings */
+        static constexpr size_t kHugePageSize = 2 * 1024 * 1024; // 2MB
+
         // =====================================================================
         // Construction
         // =====================================================================
@@ -81,14 +84,19 @@ namespace Cell {
         /**
          * @brief Allocates a large block with explicit alignment.
          *
-         * Uses platform-specific aligned allocation (posix_memalign, _aligned_malloc).
+         * The block is a dedicated OS mapping: the range is over-reserved by the
+         * alignment and the unaligned head and tail are trimmed. When huge pages
+         * are requested, MAP_HUGETLB is tried first and MADV_HUGEPAGE is applied
+         * as a fallback when no hugetlbfs pages are reserved.
          *
          * @param size Size in bytes.
          * @param alignment Required alignment (must be power of 2).
          * @param tag Memory tag for profiling.
+         * @param try_huge_pages Attempt to back the block with huge pages.
          * @return Aligned pointer, or nullptr on failure.
          */
-        [[nodiscard]] void *alloc_aligned(size_t size, size_t alignment, uint8_t tag = 0);
+        [[nodiscard]] void *alloc_aligned(size_t size, size_t alignment, uint8_t tag = 0,
+                                          bool try_huge_pages = true);
 
         // =====================================================================
         // Introspection
@@ -116,16 +124,55 @@ namespace Cell {
          */
         [[nodiscard]] size_t get_alloc_size(void *ptr) const;
 
+        /**
+         * @brief Returns the tag passed to alloc() for a pointer.
+         * @param ptr User pointer from alloc()
+         * @return Tag, or 0 if not found
+         */
+        [[nodiscard]] uint8_t get_alloc_tag(void *ptr) const;
+
+        /**
+         * @brief Returns the accounted size of a large allocation.
+         *
+         * Requests are rounded up to the OS page size. This is the value
+         * get_alloc_size() reports, so budget checks made before allocating
+         * agree with the size recorded afterwards.
+         *
+         * @param size Requested size in bytes.
+         * @return Page-rounded size in bytes, or 0 if rounding would overflow.
+         */
+        [[nodiscard]] static size_t rounded_size(size_t size);
+
+        /**
+         * @brief Maps an aligned, read-write range from the OS.
+         *
+         * Untracked by the registry; LeakTable uses it for its own storage.
+         *
+         * @param size Page-rounded size in bytes.
+         * @param alignment Required alignment (power of 2).
+         * @param try_huge_pages Attempt MAP_HUGETLB, then MADV_HUGEPAGE.
+         * @param out_mapping_size Receives the mapping length to release later.
+         * @param out_huge Receives whether hugetlbfs pages back the mapping.
+         * @return Aligned mapping start, or nullptr on failure.
+         */
+        static void *map_aligned(size_t size, size_t alignment, bool try_huge_pages,
+                                 size_t &out_mapping_size, bool &out_huge);
+
+        /**
+         * @brief Releases a mapping returned by map_aligned().
+         */
+        static void unmap(void *ptr, size_t mapping_size);
+
     private:
         /**
          * @brief Metadata for a large allocation.
          */
         struct LargeAlloc {
-            size_t size;
-            void *original_ptr; ///< Original pointer (for aligned allocs, may differ from key)
+            size_t size;           ///< Accounted size (page-rounded)
+            size_t mapping_size;   ///< Length of the OS mapping (huge-page rounded if hugetlb)
+            size_t alignment;      ///< Requested alignment, preserved across realloc
             uint8_t tag;
             bool huge_pages;
-            bool aligned; ///< Was this an aligned allocation?
         };
 
         std::unordered_map<void *, LargeAlloc> m_allocs;
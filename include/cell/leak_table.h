@@ -0,0 +1,122 @@
+#pragma once
+
+#include "debug.h"
+
+#ifdef CELL_DEBUG_LEAKS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Cell {
+
+    /** @brief Number of independently locked shards in a LeakTable (power of 2). */
+    static constexpr size_t kLeakTableShards = 64;
+
+    /** @brief Slots a shard maps on its first insert (power of 2). */
+    static constexpr size_t kLeakTableInitialSlots = 512;
+
+    // =========================================================================
+    // LeakTable
+    // =========================================================================
+
+    /**
+     * @brief Live-allocation table for CELL_DEBUG_LEAKS.
+     *
+     * Pointers are hashed to one of kLeakTableShards shards, each an
+     * open-addressing (linear probing) array of DebugAllocation records
+     * behind its own lock, so threads tracking different allocations rarely
+     * contend. Deletion shifts later entries back instead of leaving
+     * tombstones, keeping probe sequences short under churn.
+     *
+     * Shard storage is mapped directly from the OS with the large tier's
+     * mapping primitives and doubles when a shard is half full, so tracking
+     * never allocates from the system heap or re-enters the Context.
+     */
+    class LeakTable {
+    public:
+        LeakTable() = default;
+        ~LeakTable();
+
+        // Non-copyable, non-movable
+        LeakTable(const LeakTable &) = delete;
+        LeakTable &operator=(const LeakTable &) = delete;
+        LeakTable(LeakTable &&) = delete;
+        LeakTable &operator=(LeakTable &&) = delete;
+
+        /**
+         * @brief Records a live allocation, replacing any record for alloc.ptr.
+         * @return false if the shard could not grow; the allocation is untracked.
+         */
+        bool insert(const DebugAllocation &alloc);
+
+        /**
+         * @brief Removes the record for ptr.
+         * @param out Receives the removed record if non-null.
+         * @return false if ptr was not tracked.
+         */
+        bool erase(void *ptr, DebugAllocation *out = nullptr);
+
+        /**
+         * @brief Copies the record for ptr to out.
+         * @return false if ptr is not tracked.
+         */
+        bool find(void *ptr, DebugAllocation *out) const;
+
+        /** @brief Returns the number of tracked allocations (without locking). */
+        [[nodiscard]] size_t size() const;
+
+        /**
+         * @brief Calls fn(const DebugAllocation &) for every record.
+         *
+         * Locks one shard at a time, so the walk is not a single snapshot.
+         * fn must not allocate from or free to the owning Context.
+         */
+        template <typename Fn> void for_each(Fn &&fn) const {
+            for (const Shard &shard : m_shards) {
+                std::lock_guard<std::mutex> lock(shard.lock);
+                for (size_t i = 0; i < shard.capacity; ++i) {
+                    if (shard.slots[i].ptr) {
+                        fn(shard.slots[i]);
+                    }
+                }
+            }
+        }
+
+    private:
+        struct alignas(64) Shard {
+            mutable std::mutex lock;
+            DebugAllocation *slots = nullptr; ///< capacity entries; ptr == nullptr is empty.
+            size_t capacity = 0;
+            size_t mapping_size = 0;          ///< Bytes mapped for slots.
+            std::atomic<size_t> count{0};     ///< Written under lock; read by size().
+        };
+
+        static uint64_t hash(const void *ptr) {
+            // Murmur3 finalizer: spreads aligned pointers over shard and slot bits
+            auto h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        Shard &shard_for(uint64_t h) { return m_shards[h >> 58]; }
+        const Shard &shard_for(uint64_t h) const { return m_shards[h >> 58]; }
+        static_assert(kLeakTableShards == 64, "shard_for() uses the top 6 hash bits");
+
+        /** @brief Returns ptr's slot index, or capacity if absent. Caller holds lock. */
+        static size_t find_slot(const Shard &shard, const void *ptr, uint64_t h);
+
+        /** @brief Doubles the shard's capacity (or maps its first slots). Caller holds lock. */
+        static bool grow(Shard &shard);
+
+        Shard m_shards[kLeakTableShards];
+    };
+
+}
+
+#endif // CELL_DEBUG_LEAKS
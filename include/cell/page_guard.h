@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace Cell {
+
+    /** @brief Thread-local countdown to the next sampled page-guarded allocation. */
+    inline thread_local size_t t_page_guard_countdown = 0;
+
+    /**
+     * @brief Registry for page-guarded allocations (electric-fence style).
+     *
+     * Each allocation gets its own mapping: the block ends flush against
+     * the end of its last data page, followed by one PROT_NONE
+     * (PAGE_NOACCESS) guard page, so a read or write past the end faults at
+     * the offending instruction instead of being found at free. Underflows
+     * and overflows into the alignment padding, up to alignment - 1 bytes,
+     * are not caught: under 16 bytes for alloc_bytes(), and up to a page
+     * less one byte for alloc_aligned(), which guards alignments up to a
+     * page.
+     *
+     * Every allocation costs at least two pages and two system calls, so
+     * Context routes only selected tags or a sampled fraction here.
+     *
+     * Thread safety: Protected by internal mutex.
+     */
+    class PageGuardRegistry {
+    public:
+        PageGuardRegistry() = default;
+        ~PageGuardRegistry();
+
+        // Non-copyable, non-movable
+        PageGuardRegistry(const PageGuardRegistry &) = delete;
+        PageGuardRegistry &operator=(const PageGuardRegistry &) = delete;
+        PageGuardRegistry(PageGuardRegistry &&) = delete;
+        PageGuardRegistry &operator=(PageGuardRegistry &&) = delete;
+
+        /**
+         * @brief Maps a block whose end touches a guard page.
+         *
+         * @param size Size in bytes.
+         * @param alignment Alignment of the returned pointer (power of 2, at most a page).
+         * @param tag Memory tag for profiling.
+         * @return Pointer to size usable bytes, or nullptr on failure.
+         */
+        [[nodiscard]] void *alloc(size_t size, size_t alignment, uint8_t tag = 0);
+
+        /**
+         * @brief Unmaps a block and its guard page.
+         */
+        void free(void *ptr);
+
+        /** @brief Returns true if ptr was allocated by this registry. */
+        [[nodiscard]] bool owns(void *ptr) const;
+
+        /**
+         * @brief Returns true if any page-guarded block is live.
+         *
+         * One relaxed load; lets free paths skip the registry lookup.
+         */
+        [[nodiscard]] bool has_allocations() const {
+            return m_count.load(std::memory_order_relaxed) != 0;
+        }
+
+        /** @brief Returns the number of live page-guarded blocks. */
+        [[nodiscard]] size_t allocation_count() const {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Returns the requested size of a block, or 0 if not found. */
+        [[nodiscard]] size_t get_alloc_size(void *ptr) const;
+
+        /** @brief Returns the mapped bytes of a block, guard page included, or 0. */
+        [[nodiscard]] size_t get_mapping_size(void *ptr) const;
+
+        /** @brief Returns the tag of a block, or 0 if not found. */
+        [[nodiscard]] uint8_t get_alloc_tag(void *ptr) const;
+
+        /**
+         * @brief Returns the bytes mapped for a block of size bytes (guard page included).
+         */
+        [[nodiscard]] static size_t mapping_size_for(size_t size);
+
+    private:
+        /** @brief Metadata for a page-guarded block. */
+        struct GuardedAlloc {
+            void *mapping;       ///< Start of the OS mapping.
+            size_t mapping_size; ///< Data pages plus the guard page.
+            size_t size;         ///< Requested size.
+            uint8_t tag;
+        };
+
+        std::unordered_map<void *, GuardedAlloc> m_allocs; ///< By user pointer.
+        mutable std::mutex m_lock;
+        std::atomic<size_t> m_count{0}; ///< m_allocs.size(), readable without the lock.
+    };
+
+}
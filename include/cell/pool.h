@@ -45,9 +45,7 @@ namespace Cell {
          *
          * @return Pointer to uninitialized memory, or nullptr on failure.
          */
-        [[nodiscard]] T *alloc() {
-            return static_cast<T *>(m_ctx.alloc_bytes(sizeof(T), m_tag, alignof(T)));
-        }
+        [[nodiscard]] T *alloc() { return m_ctx.alloc<T>(m_tag); }
 
         /**
          * @brief Allocates memory for an array without calling constructors.
@@ -95,7 +93,11 @@ namespace Cell {
         void destroy(T *ptr) {
             if (ptr) {
                 ptr->~T();
-                free(ptr);
+                if constexpr (alignof(T) <= 8) {
+                    m_ctx.free_fixed<sizeof(T)>(ptr);
+                } else {
+                    free(ptr);
+                }
             }
         }
 
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "context.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Cell {
+
+    /**
+     * @brief Format of the file a PressureMonitor polls.
+     */
+    enum class PressureSource : uint8_t {
+        /**
+         * Linux PSI, e.g. /proc/pressure/memory or a cgroup's memory.pressure:
+         * "some avg10=... " and "full avg10=..." lines.
+         */
+        kPsi,
+        /**
+         * cgroup v2 memory.events: "high N", "max N", "oom N", "oom_kill N"
+         * counters. Pressure is any increase since the previous poll.
+         */
+        kCgroupEvents
+    };
+
+    /**
+     * @brief Configuration for a PressureMonitor.
+     */
+    struct PressureMonitorConfig {
+        /** @brief File to poll. Any readable file in the source format works (e.g. in tests). */
+        std::string path = "/proc/pressure/memory";
+
+        /** @brief Format of @c path. */
+        PressureSource source = PressureSource::kPsi;
+
+        /** @brief PSI "some avg10" percentage at or above which pressure is moderate. */
+        double moderate_avg10 = 10.0;
+
+        /**
+         * @brief PSI "some avg10" percentage at or above which pressure is critical.
+         *
+         * Any "full avg10" at or above moderate_avg10 is also critical.
+         */
+        double critical_avg10 = 40.0;
+
+        /** @brief Poll interval for the background thread. */
+        std::chrono::milliseconds interval{1000};
+    };
+
+    /**
+     * @brief Trims a Context when the system or its cgroup reports memory pressure.
+     *
+     * Each poll reads the configured file, maps it to a PressureLevel, and
+     * calls Context::trim() with that level. Polls can be driven manually with
+     * poll_once() or by a background thread via start().
+     *
+     * Thread safety: poll_once() may be called from any thread, but not
+     * concurrently with itself or with a running background thread.
+     */
+    class PressureMonitor {
+    public:
+        /**
+         * @brief Creates a monitor for ctx. Does not start polling.
+         * @param ctx Context to trim; must outlive the monitor.
+         * @param config Source file and thresholds.
+         */
+        explicit PressureMonitor(Context &ctx, PressureMonitorConfig config = {});
+
+        /**
+         * @brief Stops the background thread if running.
+         */
+        ~PressureMonitor();
+
+        // Non-copyable, non-movable
+        PressureMonitor(const PressureMonitor &) = delete;
+        PressureMonitor &operator=(const PressureMonitor &) = delete;
+        PressureMonitor(PressureMonitor &&) = delete;
+        PressureMonitor &operator=(PressureMonitor &&) = delete;
+
+        /**
+         * @brief Reads the source once and trims the Context if under pressure.
+         * @return Level observed; kNone if the file is missing or unparsable.
+         */
+        PressureLevel poll_once();
+
+        /**
+         * @brief Starts polling every config.interval on a background thread.
+         * @return false if already running.
+         */
+        bool start();
+
+        /**
+         * @brief Stops the background thread and waits for it to exit.
+         */
+        void stop();
+
+        /** @brief Returns true while the background thread is running. */
+        [[nodiscard]] bool running() const { return m_thread.joinable(); }
+
+        /** @brief Returns the level observed by the most recent poll. */
+        [[nodiscard]] PressureLevel last_level() const {
+            return m_last_level.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Returns total bytes released by trims this monitor triggered. */
+        [[nodiscard]] size_t bytes_reclaimed() const {
+            return m_bytes_reclaimed.load(std::memory_order_relaxed);
+        }
+
+    private:
+        PressureLevel read_level();
+        PressureLevel parse_psi(const char *text) const;
+        PressureLevel parse_cgroup_events(const char *text);
+
+        Context &m_ctx;
+        PressureMonitorConfig m_config;
+
+        // memory.events counters from the previous poll
+        bool m_have_baseline = false; ///< First cgroup poll only records counters.
+        uint64_t m_last_high = 0;     ///< Previous "high" count.
+        uint64_t m_last_max = 0;      ///< Previous "max" count.
+        uint64_t m_last_oom = 0;      ///< Previous "oom" + "oom_kill" count.
+
+        std::atomic<PressureLevel> m_last_level{PressureLevel::kNone};
+        std::atomic<size_t> m_bytes_reclaimed{0};
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stop = false; ///< Guarded by m_mutex.
+    };
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "debug.h"
+
+#ifdef CELL_DEBUG_STACKTRACE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace Cell {
+
+    /** @brief Hash buckets in the StackDepot (power of 2). */
+    static constexpr size_t kStackDepotBuckets = 16384;
+
+    /** @brief Bytes mapped per StackDepot storage chunk (power of 2). */
+    static constexpr size_t kStackDepotChunkSize = 1024 * 1024;
+
+    /** @brief Maximum storage chunks; bounds the depot at 4 GB of traces. */
+    static constexpr size_t kStackDepotMaxChunks = 4096;
+
+    /** @brief Frames stored per trace; deeper traces are truncated. */
+    static constexpr size_t kStackDepotMaxDepth = 64;
+
+    // =========================================================================
+    // StackDepot
+    // =========================================================================
+
+    /**
+     * @brief Process-wide store of unique stack traces.
+     *
+     * Allocation sites repeat, so storing each trace once and handing out a
+     * 4-byte StackId shrinks per-allocation debug records from a fixed
+     * frame array to a single integer.
+     *
+     * Traces are hashed into kStackDepotBuckets chains. Lookups walk a chain
+     * without locking: records are immutable once published and bucket
+     * heads are updated with release stores. Inserts take one mutex, so only
+     * the first capture of a new trace pays for it.
+     *
+     * Records are bump-allocated from chunks mapped with the large tier's
+     * mapping primitives and are never freed, so an ID stays valid for the
+     * life of the process (including static destruction).
+     */
+    class StackDepot {
+    public:
+        /** @brief A trace stored in the depot. */
+        struct StackTrace {
+            void *const *frames; ///< Return addresses, innermost first.
+            size_t depth;        ///< Number of frames (0 if the ID is invalid).
+        };
+
+        /** @brief Returns the process-wide depot (never destroyed). */
+        static StackDepot &instance();
+
+        // Non-copyable, non-movable
+        StackDepot(const StackDepot &) = delete;
+        StackDepot &operator=(const StackDepot &) = delete;
+        StackDepot(StackDepot &&) = delete;
+        StackDepot &operator=(StackDepot &&) = delete;
+
+        /**
+         * @brief Stores a trace, or finds the identical trace already stored.
+         *
+         * @param stack Frame addresses.
+         * @param depth Number of frames (truncated to kStackDepotMaxDepth).
+         * @return ID of the trace, or kInvalidStackId if depth is 0 or the
+         *         depot is out of memory.
+         */
+        StackId put(void *const *stack, size_t depth);
+
+        /** @brief Returns the trace for id (depth 0 for kInvalidStackId). */
+        [[nodiscard]] StackTrace get(StackId id) const;
+
+        /** @brief Returns the number of unique traces stored. */
+        [[nodiscard]] size_t unique_stacks() const {
+            return m_unique.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Returns the bytes mapped for trace storage. */
+        [[nodiscard]] size_t memory_usage() const {
+            return m_chunk_count.load(std::memory_order_relaxed) * kStackDepotChunkSize;
+        }
+
+    private:
+        StackDepot() = default;
+
+        /** @brief Header of a stored trace; depth frame pointers follow it. */
+        struct Record {
+            uint64_t hash;
+            StackId next;   ///< Next record in the bucket chain.
+            uint32_t depth;
+        };
+
+        static uint64_t hash(void *const *stack, size_t depth);
+
+        const Record *resolve(StackId id) const;
+
+        /** @brief Walks a bucket chain for an identical trace. */
+        StackId find(StackId head, uint64_t h, void *const *stack, size_t depth) const;
+
+        std::atomic<StackId> m_buckets[kStackDepotBuckets] = {};
+        std::atomic<uint8_t *> m_chunks[kStackDepotMaxChunks] = {};
+        std::atomic<size_t> m_chunk_count{0};
+        std::atomic<size_t> m_unique{0};
+        size_t m_chunk_used = kStackDepotChunkSize; ///< Bytes used in the newest chunk.
+        std::mutex m_lock;                          ///< Serializes inserts.
+    };
+
+    /**
+     * @brief Captures the caller's stack and stores it in the StackDepot.
+     *
+     * @param skip_frames Frames to skip above the caller (as for capture_stack()).
+     * @return ID of the trace, or kInvalidStackId if nothing was captured.
+     */
+    StackId capture_stack_id(size_t skip_frames = 1);
+
+}
+
+#endif // CELL_DEBUG_STACKTRACE
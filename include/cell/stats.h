@@ -1,123 +1,124 @@
 #pragma once
 
+#include "config.h"
+
 #include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <string>
 
 namespace Cell {
 
 #ifdef CELL_ENABLE_STATS
 
     /**
-     * @brief Memory statistics for tracking allocations.
+     * @brief Counters for one sub-cell size class, part of MemoryStats.
+     *
+     * Use requested_bytes against rounded_bytes to judge size-class fit, and
+     * the TLS and refill counters to size the thread caches.
+     */
+    struct BinStats {
+        size_t allocs = 0;          ///< Blocks allocated (tls_hits + tls_misses)
+        size_t requested_bytes = 0; ///< Bytes callers asked for
+        size_t rounded_bytes = 0;   ///< Bytes handed out (allocs * size class)
+        size_t tls_hits = 0;        ///< Served by the inline thread-cache fast path
+        size_t tls_misses = 0;      ///< Served by the bin slow path
+        size_t refill_batches = 0;  ///< Thread-cache batch refills from the bin
+        size_t cells_carved = 0;    ///< Fresh cells initialized for this bin
+        size_t cells_returned = 0;  ///< Empty cells handed back to the cell allocator
+        size_t lock_contended = 0;  ///< Bin lock acquisitions that found it held
+    };
+
+    /**
+     * @brief Snapshot of a Context's memory statistics.
      *
-     * All counters are atomic for thread-safe updates.
-     * Only compiled when CELL_ENABLE_STATS is defined.
+     * Returned by value from Context::get_stats(); counters are summed over
+     * all shards when the snapshot is taken, without pausing allocation.
+     * Each counter is individually exact, but counters read a few
+     * nanoseconds apart may not describe the same instant. Only compiled
+     * when CELL_ENABLE_STATS is defined.
      */
     struct MemoryStats {
         // =====================================================================
         // Global Counters
         // =====================================================================
 
-        std::atomic<size_t> total_allocated{0};   ///< Cumulative bytes allocated
-        std::atomic<size_t> total_freed{0};       ///< Cumulative bytes freed
-        std::atomic<size_t> current_allocated{0}; ///< Currently allocated bytes
-        std::atomic<size_t> peak_allocated{0};    ///< Peak allocated bytes
+        size_t total_allocated = 0;   ///< Cumulative bytes allocated
+        size_t total_freed = 0;       ///< Cumulative bytes freed
+        size_t current_allocated = 0; ///< Currently allocated bytes
+        size_t peak_allocated = 0;    ///< Peak allocated bytes (sampled, see StatsCounters)
 
         // =====================================================================
         // Per-Allocator Counters
         // =====================================================================
 
-        std::atomic<size_t> cell_allocs{0};    ///< Full cell allocations
-        std::atomic<size_t> cell_frees{0};     ///< Full cell frees
-        std::atomic<size_t> subcell_allocs{0}; ///< Sub-cell allocations
-        std::atomic<size_t> subcell_frees{0};  ///< Sub-cell frees
-        std::atomic<size_t> buddy_allocs{0};   ///< Buddy allocations
-        std::atomic<size_t> buddy_frees{0};    ///< Buddy frees
-        std::atomic<size_t> large_allocs{0};   ///< Large (>2MB) allocations
-        std::atomic<size_t> large_frees{0};    ///< Large frees
+        size_t cell_allocs = 0;    ///< Full cell allocations
+        size_t cell_frees = 0;     ///< Full cell frees
+        size_t subcell_allocs = 0; ///< Sub-cell allocations
+        size_t subcell_frees = 0;  ///< Sub-cell frees
+        size_t buddy_allocs = 0;   ///< Buddy allocations
+        size_t buddy_frees = 0;    ///< Buddy frees
+        size_t large_allocs = 0;   ///< Large (>2MB) allocations
+        size_t large_frees = 0;    ///< Large frees
 
         // =====================================================================
         // Per-Tag Tracking
         // =====================================================================
 
-        std::array<std::atomic<size_t>, 256> per_tag_current{}; ///< Current bytes per tag
+        std::array<size_t, 256> per_tag_current{}; ///< Current bytes per tag
 
         // =====================================================================
-        // Methods
+        // Size Classes and OS Activity
         // =====================================================================
 
-        /**
-         * @brief Records an allocation.
-         */
-        void record_alloc(size_t size, uint8_t tag) {
-            total_allocated.fetch_add(size, std::memory_order_relaxed);
-            size_t current = current_allocated.fetch_add(size, std::memory_order_relaxed) + size;
-
-            // Update peak (relaxed is fine, approximate is okay)
-            size_t peak = peak_allocated.load(std::memory_order_relaxed);
-            while (current > peak) {
-                if (peak_allocated.compare_exchange_weak(peak, current,
-                                                         std::memory_order_relaxed)) {
-                    break;
-                }
-            }
+        std::array<BinStats, kNumSizeBins> bins{}; ///< Per size class counters
+        size_t superblock_commits = 0; ///< Cell and buddy superblocks committed (incl. recommits)
+        size_t os_calls = 0;           ///< mprotect / madvise (VirtualAlloc / VirtualFree) calls
 
-            per_tag_current[tag].fetch_add(size, std::memory_order_relaxed);
-        }
+        // =====================================================================
+        // Address Space
+        // =====================================================================
+
+        size_t reserved_bytes = 0;        ///< Cell and buddy regions reserved
+        size_t cell_committed_bytes = 0;  ///< Committed cell-region bytes
+        size_t buddy_committed_bytes = 0; ///< Committed buddy-region bytes
+        size_t large_committed_bytes = 0; ///< Bytes mapped for large allocations
 
         /**
-         * @brief Records a deallocation.
+         * @brief Serializes the snapshot as a single-line JSON object.
+         *
+         * Bins are listed in size order; tags appear only when non-zero.
          */
-        void record_free(size_t size, uint8_t tag) {
-            total_freed.fetch_add(size, std::memory_order_relaxed);
-            current_allocated.fetch_sub(size, std::memory_order_relaxed);
-            per_tag_current[tag].fetch_sub(size, std::memory_order_relaxed);
-        }
+        [[nodiscard]] std::string to_json() const;
 
         /**
-         * @brief Resets all counters.
+         * @brief Serializes the snapshot in Prometheus text exposition format.
+         * @param prefix Metric name prefix (default "cell").
          */
-        void reset() {
-            total_allocated = 0;
-            total_freed = 0;
-            current_allocated = 0;
-            peak_allocated = 0;
-            cell_allocs = 0;
-            cell_frees = 0;
-            subcell_allocs = 0;
-            subcell_frees = 0;
-            buddy_allocs = 0;
-            buddy_frees = 0;
-            large_allocs = 0;
-            large_frees = 0;
-            for (auto &tag : per_tag_current) {
-                tag = 0;
-            }
-        }
+        [[nodiscard]] std::string to_prometheus(const char *prefix = "cell") const;
 
         /**
          * @brief Prints stats to stdout.
          */
         void dump() const {
             printf("=== Cell Memory Stats ===\n");
-            printf("Total allocated:   %zu bytes\n", total_allocated.load());
-            printf("Total freed:       %zu bytes\n", total_freed.load());
-            printf("Current allocated: %zu bytes\n", current_allocated.load());
-            printf("Peak allocated:    %zu bytes\n", peak_allocated.load());
+            printf("Total allocated:   %zu bytes\n", total_allocated);
+            printf("Total freed:       %zu bytes\n", total_freed);
+            printf("Current allocated: %zu bytes\n", current_allocated);
+            printf("Peak allocated:    %zu bytes\n", peak_allocated);
             printf("\n");
-            printf("Cell allocs/frees:    %zu / %zu\n", cell_allocs.load(), cell_frees.load());
-            printf("SubCell allocs/frees: %zu / %zu\n", subcell_allocs.load(),
-                   subcell_frees.load());
-            printf("Buddy allocs/frees:   %zu / %zu\n", buddy_allocs.load(), buddy_frees.load());
-            printf("Large allocs/frees:   %zu / %zu\n", large_allocs.load(), large_frees.load());
+            printf("Cell allocs/frees:    %zu / %zu\n", cell_allocs, cell_frees);
+            printf("SubCell allocs/frees: %zu / %zu\n", subcell_allocs, subcell_frees);
+            printf("Buddy allocs/frees:   %zu / %zu\n", buddy_allocs, buddy_frees);
+            printf("Large allocs/frees:   %zu / %zu\n", large_allocs, large_frees);
 
             // Print non-zero tags
             bool has_tags = false;
             for (size_t i = 0; i < 256; ++i) {
-                size_t val = per_tag_current[i].load();
+                size_t val = per_tag_current[i];
                 if (val > 0) {
                     if (!has_tags) {
                         printf("\nPer-tag current:\n");
@@ -126,9 +127,305 @@ namespace Cell {
                     printf("  Tag %3zu: %zu bytes\n", i, val);
                 }
             }
+
+            printf("\nSuperblock commits: %zu, OS calls: %zu\n", superblock_commits, os_calls);
+
+            bool has_bins = false;
+            for (size_t i = 0; i < kNumSizeBins; ++i) {
+                const BinStats &bin = bins[i];
+                if (bin.allocs == 0 && bin.cells_carved == 0 && bin.lock_contended == 0) {
+                    continue;
+                }
+                if (!has_bins) {
+                    printf("\nSize classes:\n");
+                    printf("  %6s %10s %12s %12s %10s %10s %8s %7s %8s %9s\n", "class",
+                           "allocs", "requested", "rounded", "tls_hits", "tls_miss", "refills",
+                           "carved", "returned", "contended");
+                    has_bins = true;
+                }
+                printf("  %6zu %10zu %12zu %12zu %10zu %10zu %8zu %7zu %8zu %9zu\n",
+                       kSizeClasses[i], bin.allocs, bin.requested_bytes, bin.rounded_bytes,
+                       bin.tls_hits, bin.tls_misses, bin.refill_batches, bin.cells_carved,
+                       bin.cells_returned, bin.lock_contended);
+            }
         }
     };
 
+    /**
+     * @brief Allocation tier an event is counted against.
+     */
+    enum class StatsTier : uint8_t { kCell, kSubCell, kBuddy, kLarge };
+
+    /** @brief Number of StatsTier values. */
+    static constexpr size_t kStatsTierCount = 4;
+
+    /**
+     * @brief Infrequent per-bin events, recorded under or near the bin lock.
+     */
+    enum class BinEvent : uint8_t { kRefillBatch, kCellCarved, kCellReturned, kLockContended };
+
+    /**
+     * @brief Number of counter shards per Context.
+     *
+     * Threads are assigned shards round-robin, so up to this many threads
+     * update disjoint cache lines; beyond it, threads share shards.
+     */
+    static constexpr size_t kStatsShardCount = 32;
+
+    /**
+     * @brief Log2 of the per-shard allocation volume between peak samples.
+     *
+     * Each time a shard's cumulative allocated bytes cross a 64KB boundary,
+     * the allocating thread sums all shards and raises the peak. The peak can
+     * therefore miss short spikes of up to 64KB per active shard.
+     */
+    static constexpr size_t kPeakSampleShift = 16;
+
+    /**
+     * @brief Returns the calling thread's stats shard index.
+     */
+    inline size_t stats_shard_index() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t index =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % kStatsShardCount;
+        return index;
+    }
+
+    /**
+     * @brief Live statistics counters, sharded per thread.
+     *
+     * Every update is a relaxed add on the calling thread's shard, which no
+     * other thread writes unless there are more than kStatsShardCount
+     * threads. Current bytes are derived from allocated minus freed, and the
+     * peak is sampled rather than maintained with a CAS on every allocation.
+     * Reads sum the shards into a MemoryStats snapshot.
+     */
+    class StatsCounters {
+    public:
+        StatsCounters() : m_shards(std::make_unique<Shard[]>(kStatsShardCount)) {}
+
+        /**
+         * @brief Records count allocations totalling size bytes.
+         */
+        void record_alloc(size_t size, uint8_t tag, StatsTier tier, size_t count = 1) {
+            Shard &shard = m_shards[stats_shard_index()];
+            size_t before = shard.allocated.fetch_add(size, std::memory_order_relaxed);
+            shard.allocs[static_cast<size_t>(tier)].fetch_add(count, std::memory_order_relaxed);
+            shard.tag_bytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+            if (((before ^ (before + size)) >> kPeakSampleShift) != 0) {
+                sample_peak();
+            }
+        }
+
+        /**
+         * @brief Records count sub-cell allocations from one bin.
+         *
+         * @param requested Bytes the callers asked for in total.
+         * @param tls_hits How many of the count came from the inline thread-cache path.
+         */
+        void record_subcell_alloc(size_t requested, size_t bin_index, uint8_t tag,
+                                  size_t count = 1, size_t tls_hits = 0) {
+            Shard &shard = m_shards[stats_shard_index()];
+            size_t size = kSizeClasses[bin_index] * count;
+            size_t before = shard.allocated.fetch_add(size, std::memory_order_relaxed);
+            shard.tag_bytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+            BinShard &bin = shard.bins[bin_index];
+            bin.requested.fetch_add(requested, std::memory_order_relaxed);
+            if (tls_hits > 0) {
+                bin.tls_hits.fetch_add(tls_hits, std::memory_order_relaxed);
+            }
+            if (count > tls_hits) {
+                bin.tls_misses.fetch_add(count - tls_hits, std::memory_order_relaxed);
+            }
+
+            if (((before ^ (before + size)) >> kPeakSampleShift) != 0) {
+                sample_peak();
+            }
+        }
+
+        /**
+         * @brief Records a refill, cell carve, cell return or contended lock for a bin.
+         */
+        void record_bin_event(size_t bin_index, BinEvent event) {
+            BinShard &bin = m_shards[stats_shard_index()].bins[bin_index];
+            switch (event) {
+            case BinEvent::kRefillBatch:
+                bin.refill_batches.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case BinEvent::kCellCarved:
+                bin.cells_carved.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case BinEvent::kCellReturned:
+                bin.cells_returned.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case BinEvent::kLockContended:
+                bin.lock_contended.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        /**
+         * @brief Records count frees totalling size bytes.
+         */
+        void record_free(size_t size, uint8_t tag, StatsTier tier, size_t count = 1) {
+            Shard &shard = m_shards[stats_shard_index()];
+            shard.freed.fetch_add(size, std::memory_order_relaxed);
+            shard.frees[static_cast<size_t>(tier)].fetch_add(count, std::memory_order_relaxed);
+            shard.tag_bytes[tag].fetch_sub(size, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records count frees whose size is not tracked.
+         */
+        void record_free_count(StatsTier tier, size_t count = 1) {
+            Shard &shard = m_shards[stats_shard_index()];
+            shard.frees[static_cast<size_t>(tier)].fetch_add(count, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Sums all shards into a snapshot.
+         *
+         * The current total observed here also raises the peak, so the peak
+         * never reads lower than a current value already reported.
+         */
+        [[nodiscard]] MemoryStats snapshot() {
+            MemoryStats stats;
+            for (size_t i = 0; i < kStatsShardCount; ++i) {
+                const Shard &shard = m_shards[i];
+                stats.total_allocated += shard.allocated.load(std::memory_order_relaxed);
+                stats.total_freed += shard.freed.load(std::memory_order_relaxed);
+                stats.cell_allocs += load(shard.allocs, StatsTier::kCell);
+                stats.cell_frees += load(shard.frees, StatsTier::kCell);
+                stats.subcell_allocs += load(shard.allocs, StatsTier::kSubCell);
+                stats.subcell_frees += load(shard.frees, StatsTier::kSubCell);
+                stats.buddy_allocs += load(shard.allocs, StatsTier::kBuddy);
+                stats.buddy_frees += load(shard.frees, StatsTier::kBuddy);
+                stats.large_allocs += load(shard.allocs, StatsTier::kLarge);
+                stats.large_frees += load(shard.frees, StatsTier::kLarge);
+                for (size_t tag = 0; tag < 256; ++tag) {
+                    stats.per_tag_current[tag] +=
+                        shard.tag_bytes[tag].load(std::memory_order_relaxed);
+                }
+                for (size_t b = 0; b < kNumSizeBins; ++b) {
+                    const BinShard &from = shard.bins[b];
+                    BinStats &to = stats.bins[b];
+                    to.requested_bytes += from.requested.load(std::memory_order_relaxed);
+                    to.tls_hits += from.tls_hits.load(std::memory_order_relaxed);
+                    to.tls_misses += from.tls_misses.load(std::memory_order_relaxed);
+                    to.refill_batches += from.refill_batches.load(std::memory_order_relaxed);
+                    to.cells_carved += from.cells_carved.load(std::memory_order_relaxed);
+                    to.cells_returned += from.cells_returned.load(std::memory_order_relaxed);
+                    to.lock_contended += from.lock_contended.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Sub-cell allocation counts come from the bins
+            for (size_t b = 0; b < kNumSizeBins; ++b) {
+                BinStats &bin = stats.bins[b];
+                bin.allocs = bin.tls_hits + bin.tls_misses;
+                bin.rounded_bytes = bin.allocs * kSizeClasses[b];
+                stats.subcell_allocs += bin.allocs;
+            }
+
+            // Shards wrap individually; the sums are exact modulo 2^64. A free
+            // read before its allocation can leave a sum briefly negative.
+            stats.current_allocated = clamp_net(stats.total_allocated - stats.total_freed);
+            for (size_t &bytes : stats.per_tag_current) {
+                bytes = clamp_net(bytes);
+            }
+            raise_peak(stats.current_allocated);
+            stats.peak_allocated = m_peak.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        /**
+         * @brief Resets all counters.
+         */
+        void reset() {
+            for (size_t i = 0; i < kStatsShardCount; ++i) {
+                Shard &shard = m_shards[i];
+                shard.allocated.store(0, std::memory_order_relaxed);
+                shard.freed.store(0, std::memory_order_relaxed);
+                for (size_t t = 0; t < kStatsTierCount; ++t) {
+                    shard.allocs[t].store(0, std::memory_order_relaxed);
+                    shard.frees[t].store(0, std::memory_order_relaxed);
+                }
+                for (auto &bytes : shard.tag_bytes) {
+                    bytes.store(0, std::memory_order_relaxed);
+                }
+                for (BinShard &bin : shard.bins) {
+                    bin.requested.store(0, std::memory_order_relaxed);
+                    bin.tls_hits.store(0, std::memory_order_relaxed);
+                    bin.tls_misses.store(0, std::memory_order_relaxed);
+                    bin.refill_batches.store(0, std::memory_order_relaxed);
+                    bin.cells_carved.store(0, std::memory_order_relaxed);
+                    bin.cells_returned.store(0, std::memory_order_relaxed);
+                    bin.lock_contended.store(0, std::memory_order_relaxed);
+                }
+            }
+            m_peak.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        /**
+         * @brief One size class's counters within a shard.
+         */
+        struct BinShard {
+            std::atomic<size_t> requested{0};      ///< Requested bytes.
+            std::atomic<size_t> tls_hits{0};       ///< Inline thread-cache allocations.
+            std::atomic<size_t> tls_misses{0};     ///< Slow-path allocations.
+            std::atomic<size_t> refill_batches{0}; ///< Thread-cache refills.
+            std::atomic<size_t> cells_carved{0};   ///< Cells initialized for the bin.
+            std::atomic<size_t> cells_returned{0}; ///< Cells given back to the allocator.
+            std::atomic<size_t> lock_contended{0}; ///< Bin lock found held.
+        };
+
+        /**
+         * @brief One thread group's counters, on its own cache lines.
+         */
+        struct alignas(64) Shard {
+            std::atomic<size_t> allocated{0}; ///< Bytes allocated through this shard.
+            std::atomic<size_t> freed{0};     ///< Bytes freed through this shard.
+            std::array<std::atomic<size_t>, kStatsTierCount> allocs{}; ///< Per-tier counts.
+            std::array<std::atomic<size_t>, kStatsTierCount> frees{};  ///< Per-tier counts.
+            std::array<std::atomic<size_t>, 256> tag_bytes{}; ///< Net bytes per tag (wraps).
+            std::array<BinShard, kNumSizeBins> bins{};        ///< Per size class counters.
+        };
+
+        static size_t load(const std::array<std::atomic<size_t>, kStatsTierCount> &counts,
+                           StatsTier tier) {
+            return counts[static_cast<size_t>(tier)].load(std::memory_order_relaxed);
+        }
+
+        /** @brief Maps a wrapped, transiently negative byte total to 0. */
+        static size_t clamp_net(size_t net) {
+            return static_cast<ptrdiff_t>(net) < 0 ? 0 : net;
+        }
+
+        /** @brief Sums current bytes across shards and raises the peak. */
+        void sample_peak() {
+            size_t allocated = 0;
+            size_t freed = 0;
+            for (size_t i = 0; i < kStatsShardCount; ++i) {
+                allocated += m_shards[i].allocated.load(std::memory_order_relaxed);
+                freed += m_shards[i].freed.load(std::memory_order_relaxed);
+            }
+            raise_peak(clamp_net(allocated - freed));
+        }
+
+        void raise_peak(size_t current) {
+            size_t peak = m_peak.load(std::memory_order_relaxed);
+            while (current > peak &&
+                   !m_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::unique_ptr<Shard[]> m_shards;
+        alignas(64) std::atomic<size_t> m_peak{0}; ///< Highest sampled current bytes.
+    };
+
 #endif // CELL_ENABLE_STATS
 
 }
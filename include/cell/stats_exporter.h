@@ -0,0 +1,124 @@
+#pragma once
+
+#include "context.h"
+
+#ifdef CELL_ENABLE_STATS
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Cell {
+
+    /**
+     * @brief Output format of a StatsExporter file.
+     */
+    enum class StatsFormat : uint8_t {
+        kJson,      ///< MemoryStats::to_json(), one object per file.
+        kPrometheus ///< MemoryStats::to_prometheus(), e.g. for a textfile collector.
+    };
+
+    /**
+     * @brief Configuration for a StatsExporter.
+     */
+    struct StatsExporterConfig {
+        /**
+         * @brief File to write each snapshot to; empty to skip file output.
+         *
+         * Written to "<path>.tmp" and renamed over path, so readers never see
+         * a partial snapshot.
+         */
+        std::string path;
+
+        /** @brief Format of @c path. */
+        StatsFormat format = StatsFormat::kJson;
+
+        /** @brief Metric name prefix for StatsFormat::kPrometheus. */
+        std::string prometheus_prefix = "cell";
+
+        /** @brief Called with each snapshot, after the file is written. May be empty. */
+        std::function<void(const MemoryStats &)> callback;
+
+        /** @brief Export interval for the background thread. */
+        std::chrono::milliseconds interval{10000};
+    };
+
+    /**
+     * @brief Periodically publishes a Context's MemoryStats snapshot.
+     *
+     * Each export takes a snapshot with Context::get_stats(), which sums the
+     * per-thread counter shards without pausing allocation, then writes it to
+     * the configured file and/or passes it to the callback. Exports can be
+     * driven manually with export_once() or by a background thread via start().
+     * Only available when CELL_ENABLE_STATS is defined.
+     *
+     * Thread safety: export_once() may be called from any thread, but not
+     * concurrently with itself or with a running background thread.
+     */
+    class StatsExporter {
+    public:
+        /**
+         * @brief Creates an exporter for ctx. Does not start exporting.
+         * @param ctx Context to snapshot; must outlive the exporter.
+         * @param config Output file, format, callback and interval.
+         */
+        explicit StatsExporter(Context &ctx, StatsExporterConfig config = {});
+
+        /**
+         * @brief Stops the background thread if running.
+         */
+        ~StatsExporter();
+
+        // Non-copyable, non-movable
+        StatsExporter(const StatsExporter &) = delete;
+        StatsExporter &operator=(const StatsExporter &) = delete;
+        StatsExporter(StatsExporter &&) = delete;
+        StatsExporter &operator=(StatsExporter &&) = delete;
+
+        /**
+         * @brief Takes one snapshot and publishes it.
+         * @return false if the file could not be written.
+         */
+        bool export_once();
+
+        /**
+         * @brief Starts exporting every config.interval on a background thread.
+         * @return false if already running.
+         */
+        bool start();
+
+        /**
+         * @brief Stops the background thread and waits for it to exit.
+         */
+        void stop();
+
+        /** @brief Returns true while the background thread is running. */
+        [[nodiscard]] bool running() const { return m_thread.joinable(); }
+
+        /** @brief Returns the number of snapshots published so far. */
+        [[nodiscard]] size_t export_count() const {
+            return m_export_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        bool write_file(const MemoryStats &stats) const;
+
+        Context &m_ctx;
+        StatsExporterConfig m_config;
+
+        std::atomic<size_t> m_export_count{0};
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stop = false; ///< Guarded by m_mutex.
+    };
+
+}
+
+#endif // CELL_ENABLE_STATS
@@ -72,7 +72,7 @@ namespace Cell {
      * Only valid for power-of-2 size classes.
      *
      * @param size Size of the allocation (will be rounded up to min).
-     * @return Bin index (0-9), or kFullCellMarker if too large.
+     * @return Bin index (0 to kNumSizeBins-1), or kFullCellMarker if too large.
      */
     CELL_FORCE_INLINE uint8_t get_size_class_fast(size_t size) {
         // Clamp to minimum
@@ -81,7 +81,7 @@ namespace Cell {
         }
 
         // Too large for sub-cell
-        if (CELL_UNLIKELY(size > kMaxSubCellSize)) {
+        if (CELL_UNLIKELY(size > kMaxSizeClass)) {
             return kFullCellMarker;
         }
 
@@ -110,16 +110,58 @@ namespace Cell {
         return static_cast<uint8_t>(order - 4);
     }
 
+    /**
+     * @brief Compile-time size class lookup for default (8-byte) alignment.
+     *
+     * Gives the same bin as get_size_class_fast(), for use in constant
+     * expressions such as Context::alloc_fixed<N>().
+     *
+     * @param size Size of the allocation in bytes.
+     * @return Bin index (0 to kNumSizeBins-1), or kFullCellMarker if too large.
+     */
+    inline constexpr uint8_t static_size_class(size_t size) {
+        for (size_t i = 0; i < kNumSizeBins; ++i) {
+            if (kSizeClasses[i] >= size) {
+                return static_cast<uint8_t>(i);
+            }
+        }
+        return kFullCellMarker;
+    }
+
+    /**
+     * @brief Returns the offset of a bin's first block from the start of its cell.
+     *
+     * Blocks start at a multiple of their size class, so every block is
+     * aligned to its size. Cells and size classes are powers of two, so this
+     * fits as many blocks as starting at kBlockStartOffset would.
+     *
+     * @param bin_index The size class bin index.
+     */
+    inline constexpr size_t bin_block_offset(size_t bin_index) {
+        return kSizeClasses[bin_index] > kBlockStartOffset ? kSizeClasses[bin_index]
+                                                            : kBlockStartOffset;
+    }
+
     /**
      * @brief Calculates how many blocks fit in a cell for a given size class.
      *
      * @param bin_index The size class bin index.
+     * @param cell_size Cell size in bytes (default: kCellSize).
      * @return Number of blocks that fit in one cell.
      */
-    inline constexpr size_t blocks_per_cell(size_t bin_index) {
-        return (kCellSize - kBlockStartOffset) / kSizeClasses[bin_index];
+    inline constexpr size_t blocks_per_cell(size_t bin_index, size_t cell_size = kCellSize) {
+        return (cell_size - bin_block_offset(bin_index)) / kSizeClasses[bin_index];
     }
 
+    /**
+     * @brief Returns the number of size classes served with the given cell size.
+     *
+     * Size classes run up to half the cell size.
+     *
+     * @param cell_size_log2 Log2 of the cell size.
+     */
+    inline constexpr size_t size_class_count(size_t cell_size_log2) { return cell_size_log2 - 4; }
+
     // -------------------------------------------------------------------------
     // Size Bin
     // -------------------------------------------------------------------------
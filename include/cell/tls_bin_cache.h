@@ -0,0 +1,43 @@
+#pragma once
+
+#include "cell.h"
+#include "config.h"
+
+namespace Cell {
+
+    class Context;
+
+    /**
+     * @brief Per-thread cache for sub-cell blocks (the first kTlsBinCacheCount bins).
+     *
+     * Fixed-size array, no locking required.
+     * Stores FreeBlock pointers for fast alloc/free on hot sizes. The array
+     * holds kTlsBinCacheCapacity; each Context fills it to its own capacity.
+     * Public so that Context::alloc_fixed<N>() can be inlined into callers.
+     */
+    struct TlsBinCache {
+        FreeBlock *blocks[kTlsBinCacheCapacity] = {};
+        size_t count = 0;
+
+        [[nodiscard]] bool is_empty() const { return count == 0; }
+        [[nodiscard]] bool is_full(size_t capacity) const { return count >= capacity; }
+
+        void push(FreeBlock *b) { blocks[count++] = b; }
+        [[nodiscard]] FreeBlock *pop() { return blocks[--count]; }
+    };
+
+    /**
+     * @brief Thread-local bin caches for sizes 16B to 4KB.
+     *
+     * Index 0 = bin 0 (16B), index 1 = bin 1 (32B), etc.
+     */
+    inline thread_local TlsBinCache t_bin_cache[kTlsBinCacheCount];
+
+    /**
+     * @brief Context whose blocks t_bin_cache holds, or nullptr.
+     *
+     * One cache serves every Context on the thread; see Context::claim_bin_cache().
+     */
+    inline thread_local Context *t_bin_cache_owner = nullptr;
+
+}
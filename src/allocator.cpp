@@ -1,11 +1,14 @@
 #include "cell/allocator.h"
 #include "cell/cell.h"
 
+#include "prefault.h"
 #include "tls_cache.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstring>
+#include <utility>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -15,21 +18,59 @@
 
 namespace Cell {
 
-    Allocator::Allocator(void *base, size_t reserved_size) {
+    namespace {
+        inline size_t popcount(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_popcountll(v));
+#else
+            size_t n = 0;
+            for (; v; v &= v - 1) {
+                ++n;
+            }
+            return n;
+#endif
+        }
+
+        inline size_t count_trailing_zeros(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(v));
+#elif defined(_MSC_VER)
+            unsigned long idx;
+            _BitScanForward64(&idx, v);
+            return static_cast<size_t>(idx);
+#else
+            size_t n = 0;
+            while ((v & 1) == 0) {
+                v >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+    } // namespace
+
+    Allocator::Allocator(void *base, size_t reserved_size, ReleasePolicy release_policy,
+                         size_t magazine_size, size_t cell_size_log2)
+        : m_release_policy(release_policy),
+          m_magazine_size(std::clamp(magazine_size, size_t{1}, kCellMagazineSize)),
+          m_cell_size_log2(std::clamp(cell_size_log2, kMinCellSizeLog2, kMaxCellSizeLog2)),
+          m_cell_size(size_t{1} << m_cell_size_log2),
+          m_cells_per_superblock(kSuperblockSize >> m_cell_size_log2) {
 #if defined(_WIN32)
         // Windows VirtualAlloc has 64KB allocation granularity, which guarantees
-        // 16KB (kCellSize) alignment. No further alignment needed.
+        // alignment for every supported cell size. No further alignment needed.
         m_base = base;
         m_reserved_size = reserved_size;
 #ifndef NDEBUG
         // Verify our assumption that VirtualAlloc returns aligned addresses
         auto addr = reinterpret_cast<uintptr_t>(base);
-        assert((addr & (kCellSize - 1)) == 0 && "VirtualAlloc should return 16KB-aligned address");
+        assert((addr & (m_cell_size - 1)) == 0 &&
+               "VirtualAlloc should return cell-aligned address");
 #endif
 #else
-        // Linux: mmap might not align to kCellSize, so align manually
+        // Linux: mmap might not align to the cell size, so align manually
         auto addr = reinterpret_cast<uintptr_t>(base);
-        auto aligned_addr = (addr + kCellSize - 1) & kCellMask;
+        auto aligned_addr = (addr + m_cell_size - 1) & ~(uintptr_t{m_cell_size} - 1);
         size_t alignment_offset = aligned_addr - addr;
 
         m_base = reinterpret_cast<void *>(aligned_addr);
@@ -46,7 +87,6 @@ namespace Cell {
         // Initialize all superblocks as uncommitted
         for (size_t i = 0; i < m_num_superblocks; ++i) {
             m_superblock_states[i].store(SuperblockState::kUncommitted, std::memory_order_relaxed);
-            m_free_cells[i].store(0, std::memory_order_relaxed);
         }
     }
 
@@ -56,37 +96,31 @@ namespace Cell {
         // The Context destructor clears the TLS bin caches which is sufficient.
     }
 
+    void Allocator::claim_tls_cache() {
+        if (t_cache.owner == this) {
+            return;
+        }
+        // Another Context's cells: give them back to their own depot before
+        // this Allocator's magazines are encoded relative to m_base
+        if (t_cache.owner) {
+            t_cache.owner->flush_tls_cache();
+        }
+        t_cache.owner = this;
+    }
+
     void *Allocator::alloc() {
         void *result = nullptr;
-        bool from_pool = false; // Track if from TLS or global (not fresh from OS)
+        claim_tls_cache();
 
         // Tier 1: Try TLS cache first (no locks)
-        if (!t_cache.is_empty()) {
+        // Tier 2: Refill it with one magazine from the global depot (lock-free),
+        //         or else with released cells before committing a superblock
+        if (t_cache.loaded_count != 0 || refill_from_global() || reuse_released_cells()) {
             result = t_cache.pop();
-            from_pool = true;
         }
-        // Tier 2: Try global pool (lock-free)
-        else if (FreeCell *cell = pop_global()) {
-            result = cell;
-            from_pool = true;
-        }
-        // Tier 3: Allocate from OS (count already set in refill_from_os)
+        // Tier 3: Allocate from OS
         else {
             result = refill_from_os();
-            // from_pool stays false - refill_from_os handles accounting
-        }
-
-        // Track cell allocation for superblock state
-        // Only decrement for tier 1/2; tier 3 sets count correctly already
-        if (result && from_pool) {
-            size_t sb_idx = get_superblock_index(result);
-            if (sb_idx < m_num_superblocks) {
-                uint16_t old_free = m_free_cells[sb_idx].fetch_sub(1, std::memory_order_relaxed);
-                if (old_free == kCellsPerSuperblock) {
-                    m_superblock_states[sb_idx].store(SuperblockState::kInUse,
-                                                      std::memory_order_relaxed);
-                }
-            }
         }
 
 #ifndef NDEBUG
@@ -111,84 +145,213 @@ namespace Cell {
         header->generation++;
 #endif
 
-        // Track cell free for superblock state
-        size_t sb_idx = get_superblock_index(ptr);
-        if (sb_idx < m_num_superblocks) {
-            uint16_t new_free = m_free_cells[sb_idx].fetch_add(1, std::memory_order_relaxed) + 1;
-            // Mark as free if all cells are now free
-            if (new_free == kCellsPerSuperblock) {
-                m_superblock_states[sb_idx].store(SuperblockState::kFree,
-                                                  std::memory_order_relaxed);
+        assert(in_reservation(ptr) && "Cell belongs to another Allocator");
+        claim_tls_cache();
+        auto *cell = static_cast<FreeCell *>(ptr);
+
+        // Tier 2: When the loaded magazine is full, it becomes the previous one
+        // and any older full magazine goes to the global depot in one CAS
+        if (t_cache.loaded_count >= m_magazine_size) {
+            if (t_cache.previous_count != 0) {
+                t_cache.previous->count = t_cache.previous_count;
+                push_magazines(t_cache.previous, t_cache.previous);
             }
+            t_cache.previous = t_cache.loaded;
+            t_cache.previous_count = t_cache.loaded_count;
+            t_cache.loaded = nullptr;
+            t_cache.loaded_count = 0;
         }
 
-        auto *cell = static_cast<FreeCell *>(ptr);
+        // Tier 1: Return to TLS cache
+        t_cache.push(cell);
+    }
 
-        // Tier 1: Return to TLS cache if not full
-        if (!t_cache.is_full()) {
-            t_cache.push(cell);
-            return;
+    void Allocator::flush_tls_cache() {
+        if (t_cache.owner != this) {
+            return; // Empty, or holding another Allocator's cells
+        }
+        FreeCell *first = nullptr;
+        FreeCell *last = nullptr;
+        for (auto [magazine, count] : {std::pair{t_cache.loaded, t_cache.loaded_count},
+                                       std::pair{t_cache.previous, t_cache.previous_count}}) {
+            if (count == 0) {
+                continue;
+            }
+            magazine->count = count;
+            if (last) {
+                last->next_magazine = magazine;
+            } else {
+                first = magazine;
+            }
+            last = magazine;
         }
+        t_cache.clear();
 
-        // Tier 2: Return to global pool
-        push_global(cell);
+        if (first) {
+            push_magazines(first, last);
+        }
     }
 
-    void Allocator::flush_tls_cache() {
-        while (!t_cache.is_empty()) {
-            push_global(t_cache.pop());
+    size_t Allocator::prewarm(size_t bytes) {
+        size_t warmed = 0;
+        while (committed_bytes() < bytes) {
+            char *superblock = commit_superblock();
+            if (!superblock) {
+                break;
+            }
+
+            // Fault the pages in before linking cells, then publish every cell
+            prefault_pages(superblock, kSuperblockSize);
+            push_superblock_cells(superblock, 0);
+            warmed += kSuperblockSize;
+        }
+        return warmed;
+    }
+
+    void Allocator::warm_tls_cache() {
+        claim_tls_cache();
+        if (t_cache.loaded_count == 0) {
+            refill_from_global();
         }
     }
 
-    size_t Allocator::decommit_unused() {
+    size_t Allocator::decommit_unused(size_t retained_magazines) {
         std::lock_guard<std::mutex> lock(m_decommit_mutex);
         size_t total_freed = 0;
 
-        std::array<uint8_t, kMaxSuperblocks> decommit_mask{};
-        bool any_to_decommit = false;
+        // Current thread TLS cache joins the depot so it is filtered below.
+        flush_tls_cache();
 
+        // Global depot: detach every magazine. From here on this thread owns
+        // every detached cell, and released cells are owned under the mutex.
+        FreeCell *detached = take_all_magazines();
+
+        // A superblock is fully free exactly when all of its cells are detached
+        // or released. Cells held by other threads (in use, in TLS caches, or in
+        // a magazine being popped) are never counted, so they cannot be
+        // decommitted under their holder.
+        std::array<uint16_t, kMaxSuperblocks> pooled{};
+        for (FreeCell *m = detached; m; m = m->next_magazine) {
+            for (FreeCell *cell = m; cell; cell = cell->next) {
+                size_t sb_idx = get_superblock_index(cell);
+                if (sb_idx < m_num_superblocks) {
+                    ++pooled[sb_idx];
+                }
+            }
+        }
+
+        std::array<uint8_t, kMaxSuperblocks> decommit_mask{};
         for (size_t i = 0; i < m_num_superblocks; ++i) {
-            if (m_superblock_states[i].load(std::memory_order_relaxed) == SuperblockState::kFree) {
+            size_t released = 0;
+            if (m_released_cells) {
+                for (uint64_t word : m_released_cells[i]) {
+                    released += popcount(word);
+                }
+            }
+            if (pooled[i] + released == m_cells_per_superblock &&
+                m_superblock_states[i].load(std::memory_order_relaxed) ==
+                    SuperblockState::kInUse) {
                 decommit_mask[i] = 1;
-                any_to_decommit = true;
             }
         }
 
-        if (any_to_decommit) {
-            // Cells are stored inline in superblocks. If we decommit a superblock while pointers to
-            // its cells remain in the TLS cache or global pool, the next alloc/pop will touch
-            // decommitted memory and crash. Purge any free-list entries belonging to superblocks
-            // we're about to decommit.
+        // Cells are stored inline in superblocks. Drop the free-list entries of
+        // superblocks we're about to decommit, and release the pages of cold
+        // cells elsewhere.
+        auto doomed = [&](FreeCell *cell) {
+            size_t sb_idx = get_superblock_index(cell);
+            return sb_idx < m_num_superblocks && decommit_mask[sb_idx];
+        };
+
+        // Repack the surviving cells.
+        FreeCell *magazine = detached;
+        FreeCell *keep_first = nullptr;
+        FreeCell *keep_last = nullptr;
+        FreeCell *building = nullptr;
+        FreeCell *building_tail = nullptr;
+
+        auto keep = [&](FreeCell *cell) {
+            if (!building) {
+                building = cell;
+                building->count = 0;
+                building->next_magazine = nullptr;
+            } else {
+                building_tail->next = cell;
+            }
+            cell->next = nullptr;
+            building_tail = cell;
 
-            // Current thread TLS cache.
-            while (!t_cache.is_empty()) {
-                FreeCell *cell = t_cache.pop();
-                size_t sb_idx = get_superblock_index(cell);
-                if (sb_idx < m_num_superblocks && decommit_mask[sb_idx]) {
-                    continue; // drop
+            if (++building->count == m_magazine_size) {
+                if (keep_last) {
+                    keep_last->next_magazine = building;
+                } else {
+                    keep_first = building;
                 }
-                push_global(cell);
+                keep_last = building;
+                building = nullptr;
             }
-
-            // Global pool.
-            FreeCell *head = m_global_head.exchange(nullptr, std::memory_order_acq_rel);
-            FreeCell *keep_head = nullptr;
-
-            while (head) {
-                FreeCell *next = head->next;
-                size_t sb_idx = get_superblock_index(head);
-                if (sb_idx < m_num_superblocks && decommit_mask[sb_idx]) {
+        };
+
+        // The depot is LIFO, so cells past the newest magazines have sat free
+        // the longest. Release those in runs of adjacent cells.
+        size_t retain = retained_magazines * m_magazine_size;
+        char *run_start = nullptr;
+        size_t run_cells = 0;
+        size_t released_cells = 0;
+
+        auto flush_run = [&]() {
+            if (run_cells == 0) {
+                return;
+            }
+            if (release_cells(run_start, run_cells)) {
+                released_cells += run_cells;
+            } else {
+                for (size_t j = 0; j < run_cells; ++j) {
+                    keep(reinterpret_cast<FreeCell *>(run_start + j * m_cell_size));
+                }
+            }
+            run_cells = 0;
+        };
+
+        while (magazine) {
+            FreeCell *next_magazine = magazine->next_magazine;
+            for (FreeCell *cell = magazine; cell;) {
+                FreeCell *next = cell->next;
+                if (doomed(cell)) {
                     // drop
+                } else if (retain > 0) {
+                    --retain;
+                    keep(cell);
                 } else {
-                    head->next = keep_head;
-                    keep_head = head;
+                    auto *addr = reinterpret_cast<char *>(cell);
+                    if (run_cells != 0 && addr != run_start + run_cells * m_cell_size) {
+                        flush_run();
+                    }
+                    if (run_cells == 0) {
+                        run_start = addr;
+                    }
+                    ++run_cells;
                 }
-                head = next;
+                cell = next;
             }
+            magazine = next_magazine;
+        }
+        flush_run();
 
-            m_global_head.store(keep_head, std::memory_order_release);
+        if (building) {
+            if (keep_last) {
+                keep_last->next_magazine = building;
+            } else {
+                keep_first = building;
+            }
+            keep_last = building;
+        }
+        if (keep_first) {
+            push_magazines(keep_first, keep_last);
         }
 
+        total_freed += released_cells * m_cell_size;
+
         for (size_t i = 0; i < m_num_superblocks; ++i) {
             if (!decommit_mask[i]) {
                 continue;
@@ -196,42 +359,215 @@ namespace Cell {
 
             void *sb_addr = static_cast<char *>(m_base) + i * kSuperblockSize;
 
+            // Released cells were already uncounted from committed bytes
+            size_t resident = kSuperblockSize - forget_released_cells(i) * m_cell_size;
+
+            SuperblockState released_state = m_release_policy == ReleasePolicy::kLazyFree
+                                                 ? SuperblockState::kLazyFreed
+                                                 : SuperblockState::kDecommitted;
+
 #if defined(_WIN32)
-            if (VirtualFree(sb_addr, kSuperblockSize, MEM_DECOMMIT)) {
-                m_superblock_states[i].store(SuperblockState::kDecommitted,
-                                             std::memory_order_relaxed);
-                total_freed += kSuperblockSize;
+            if (release_pages(sb_addr, kSuperblockSize)) {
+                m_superblock_states[i].store(released_state, std::memory_order_relaxed);
+                mark_decommitted(i);
+                total_freed += resident;
+                if (m_release_hook) {
+                    m_release_hook(m_hook_data, sb_addr);
+                }
             } else {
-                // Decommit failed: rebuild the free list for this fully-free superblock.
-                auto *base_ptr = static_cast<char *>(sb_addr);
-                for (size_t j = 0; j < kCellsPerSuperblock; ++j) {
-                    auto *cell = reinterpret_cast<FreeCell *>(base_ptr + j * kCellSize);
-                    push_global(cell);
+                // Decommit failed: recommit any released cells and rebuild the free list for
+                // this fully-free superblock.
+                m_os_calls.fetch_add(1, std::memory_order_relaxed);
+                if (VirtualAlloc(sb_addr, kSuperblockSize, MEM_COMMIT, PAGE_READWRITE)) {
+                    m_committed_bytes.fetch_add(kSuperblockSize - resident,
+                                                std::memory_order_relaxed);
+                    push_superblock_cells(static_cast<char *>(sb_addr), 0);
                 }
             }
 #else
-            if (madvise(sb_addr, kSuperblockSize, MADV_DONTNEED) == 0) {
-                m_superblock_states[i].store(SuperblockState::kDecommitted,
-                                             std::memory_order_relaxed);
-                total_freed += kSuperblockSize;
+            if (release_pages(sb_addr, kSuperblockSize)) {
+                m_superblock_states[i].store(released_state, std::memory_order_relaxed);
+                mark_decommitted(i);
+                total_freed += resident;
+                if (m_release_hook) {
+                    m_release_hook(m_hook_data, sb_addr);
+                }
             } else {
-                // Best-effort on Linux: keep the block committed; free list entries remain valid.
+                // Best-effort on Linux: keep the block committed and rebuild its free list.
+                // Released cells fault back in on first touch.
+                m_committed_bytes.fetch_add(kSuperblockSize - resident, std::memory_order_relaxed);
+                push_superblock_cells(static_cast<char *>(sb_addr), 0);
             }
 #endif
         }
 
+        m_committed_bytes.fetch_sub(total_freed, std::memory_order_relaxed);
         return total_freed;
     }
 
     size_t Allocator::committed_bytes() const {
-        size_t committed = 0;
-        for (size_t i = 0; i < m_num_superblocks; ++i) {
-            SuperblockState state = m_superblock_states[i].load(std::memory_order_relaxed);
-            if (state == SuperblockState::kInUse || state == SuperblockState::kFree) {
-                committed += kSuperblockSize;
+        return m_committed_bytes.load(std::memory_order_relaxed);
+    }
+
+    // =========================================================================
+    // Superblock Bitmaps
+    // =========================================================================
+
+    void Allocator::SuperblockBitmap::set(size_t index) {
+        size_t word = index / 64;
+        bits[word] |= uint64_t{1} << (index % 64);
+        summary[word / 64] |= uint64_t{1} << (word % 64);
+    }
+
+    void Allocator::SuperblockBitmap::reset(size_t index) {
+        size_t word = index / 64;
+        bits[word] &= ~(uint64_t{1} << (index % 64));
+        if (bits[word] == 0) {
+            summary[word / 64] &= ~(uint64_t{1} << (word % 64));
+        }
+    }
+
+    size_t Allocator::SuperblockBitmap::find_first(size_t none) const {
+        for (size_t s = 0; s < kSummaryWords; ++s) {
+            if (summary[s] != 0) {
+                size_t word = s * 64 + count_trailing_zeros(summary[s]);
+                return word * 64 + count_trailing_zeros(bits[word]);
             }
         }
-        return committed;
+        return none;
+    }
+
+    void Allocator::mark_decommitted(size_t index) {
+        m_decommitted.set(index);
+        m_decommitted_count.fetch_add(1, std::memory_order_release);
+    }
+
+    size_t Allocator::take_decommitted() {
+        size_t index = m_decommitted.find_first(m_num_superblocks);
+        if (index < m_num_superblocks) {
+            m_decommitted.reset(index);
+            m_decommitted_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return index;
+    }
+
+    // =========================================================================
+    // Released Cells
+    // =========================================================================
+
+    bool Allocator::release_pages(void *addr, size_t size) const {
+#if defined(_WIN32)
+        if (m_release_policy == ReleasePolicy::kLazyFree) {
+            m_os_calls.fetch_add(1, std::memory_order_relaxed);
+            if (VirtualAlloc(addr, size, MEM_RESET, PAGE_READWRITE)) {
+                return true;
+            }
+        }
+        m_os_calls.fetch_add(1, std::memory_order_relaxed);
+        return VirtualFree(addr, size, MEM_DECOMMIT) != 0;
+#else
+#if defined(MADV_FREE)
+        // MADV_FREE fails with EINVAL on kernels older than 4.5
+        if (m_release_policy == ReleasePolicy::kLazyFree) {
+            m_os_calls.fetch_add(1, std::memory_order_relaxed);
+            if (madvise(addr, size, MADV_FREE) == 0) {
+                return true;
+            }
+        }
+#endif
+        m_os_calls.fetch_add(1, std::memory_order_relaxed);
+        return madvise(addr, size, MADV_DONTNEED) == 0;
+#endif
+    }
+
+    bool Allocator::release_cells(char *first, size_t count) {
+        if (!m_released_cells) {
+            m_released_cells = std::make_unique<CellBitmap[]>(m_num_superblocks);
+        }
+        if (!release_pages(first, count * m_cell_size)) {
+            return false;
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+            char *cell = first + j * m_cell_size;
+            size_t sb_idx = get_superblock_index(cell);
+            size_t cell_idx = (static_cast<size_t>(cell - static_cast<char *>(m_base)) >>
+                               m_cell_size_log2) %
+                              m_cells_per_superblock;
+            m_released_cells[sb_idx][cell_idx / 64] |= uint64_t{1} << (cell_idx % 64);
+            m_released_superblocks.set(sb_idx);
+        }
+        m_released_count.fetch_add(count, std::memory_order_release);
+        return true;
+    }
+
+    size_t Allocator::forget_released_cells(size_t index) {
+        if (!m_released_cells) {
+            return 0;
+        }
+        size_t forgotten = 0;
+        for (uint64_t &word : m_released_cells[index]) {
+            forgotten += popcount(word);
+            word = 0;
+        }
+        if (forgotten > 0) {
+            m_released_superblocks.reset(index);
+            m_released_count.fetch_sub(forgotten, std::memory_order_relaxed);
+        }
+        return forgotten;
+    }
+
+    bool Allocator::reuse_released_cells() {
+        if (m_released_count.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_decommit_mutex);
+        size_t taken = 0;
+        bool failed = false;
+
+        while (taken < m_magazine_size && !failed) {
+            size_t sb_idx = m_released_superblocks.find_first(m_num_superblocks);
+            if (sb_idx >= m_num_superblocks) {
+                break;
+            }
+
+            char *sb_addr = static_cast<char *>(m_base) + sb_idx * kSuperblockSize;
+            uint64_t *words = m_released_cells[sb_idx].data();
+            for (size_t w = 0; w < kCellBitmapWords && taken < m_magazine_size; ++w) {
+                while (words[w] != 0 && taken < m_magazine_size) {
+                    size_t cell_idx = w * 64 + count_trailing_zeros(words[w]);
+                    char *cell = sb_addr + cell_idx * m_cell_size;
+#if defined(_WIN32)
+                    m_os_calls.fetch_add(1, std::memory_order_relaxed);
+                    if (!VirtualAlloc(cell, m_cell_size, MEM_COMMIT, PAGE_READWRITE)) {
+                        failed = true;
+                        break;
+                    }
+#endif
+                    // Linux keeps the mapping: decommitted pages fault back in zeroed on
+                    // touch, and lazily freed ones are kept by the first write
+                    words[w] &= words[w] - 1;
+                    t_cache.push(reinterpret_cast<FreeCell *>(cell));
+                    ++taken;
+                }
+                if (failed) {
+                    break;
+                }
+            }
+
+            bool any_left = false;
+            for (size_t w = 0; w < kCellBitmapWords; ++w) {
+                any_left |= words[w] != 0;
+            }
+            if (!any_left) {
+                m_released_superblocks.reset(sb_idx);
+            }
+        }
+
+        m_released_count.fetch_sub(taken, std::memory_order_relaxed);
+        m_committed_bytes.fetch_add(taken * m_cell_size, std::memory_order_relaxed);
+        return taken > 0;
     }
 
     size_t Allocator::get_superblock_index(void *ptr) const {
@@ -245,52 +581,84 @@ namespace Cell {
     bool Allocator::recommit_superblock(size_t index) {
         if (index >= m_num_superblocks)
             return false;
-        if (m_superblock_states[index].load(std::memory_order_relaxed) !=
-            SuperblockState::kDecommitted)
+        SuperblockState state = m_superblock_states[index].load(std::memory_order_relaxed);
+        if (state != SuperblockState::kDecommitted && state != SuperblockState::kLazyFreed)
             return true;
 
-        void *sb_addr = static_cast<char *>(m_base) + index * kSuperblockSize;
+        // Lazily freed pages are still mapped and committed: the first write to
+        // each page cancels the pending free, so no system call is needed.
+        if (state == SuperblockState::kDecommitted) {
+            void *sb_addr = static_cast<char *>(m_base) + index * kSuperblockSize;
+            m_os_calls.fetch_add(1, std::memory_order_relaxed);
 
 #if defined(_WIN32)
-        if (!VirtualAlloc(sb_addr, kSuperblockSize, MEM_COMMIT, PAGE_READWRITE)) {
-            return false;
-        }
+            if (!VirtualAlloc(sb_addr, kSuperblockSize, MEM_COMMIT, PAGE_READWRITE)) {
+                return false;
+            }
 #else
-        if (mprotect(sb_addr, kSuperblockSize, PROT_READ | PROT_WRITE) != 0) {
-            return false;
-        }
+            if (mprotect(sb_addr, kSuperblockSize, PROT_READ | PROT_WRITE) != 0) {
+                return false;
+            }
 #endif
+        }
 
         m_superblock_states[index].store(SuperblockState::kInUse, std::memory_order_relaxed);
+        m_committed_bytes.fetch_add(kSuperblockSize, std::memory_order_relaxed);
+        m_superblock_commits.fetch_add(1, std::memory_order_relaxed);
         return true;
     }
 
-    void *Allocator::refill_from_global() { return pop_global(); }
+    bool Allocator::refill_from_global() {
+        // Prefer the full magazine this thread already holds
+        if (t_cache.previous_count != 0) {
+            t_cache.loaded = t_cache.previous;
+            t_cache.loaded_count = t_cache.previous_count;
+            t_cache.previous = nullptr;
+            t_cache.previous_count = 0;
+            return true;
+        }
+
+        FreeCell *magazine = pop_magazine();
+        if (!magazine) {
+            return false;
+        }
+
+        t_cache.loaded = magazine;
+        t_cache.loaded_count = magazine->count;
+        return true;
+    }
 
     void *Allocator::refill_from_os() {
-        // Find the next uncommitted superblock
-        size_t sb_idx = m_committed_end.load(std::memory_order_relaxed) / kSuperblockSize;
+        char *superblock = commit_superblock();
+        if (!superblock) {
+            return nullptr;
+        }
 
-        // Check if we need to recommit a decommitted superblock first
-        // (This handles the case where we decommitted and need to reuse)
-        for (size_t i = 0; i < m_num_superblocks; ++i) {
-            if (m_superblock_states[i].load(std::memory_order_relaxed) ==
-                SuperblockState::kDecommitted) {
-                if (recommit_superblock(i)) {
-                    // Re-carve this superblock
-                    void *sb_addr = static_cast<char *>(m_base) + i * kSuperblockSize;
-                    auto *base_ptr = static_cast<char *>(sb_addr);
+        // Carve superblock into cells, push all but one to global pool
+        push_superblock_cells(superblock, 1);
 
-                    // Reset free count (we're about to hand out all cells)
-                    m_free_cells[i].store(kCellsPerSuperblock - 1, std::memory_order_relaxed);
+        return superblock;
+    }
 
-                    for (size_t j = 1; j < kCellsPerSuperblock; ++j) {
-                        auto *cell = reinterpret_cast<FreeCell *>(base_ptr + j * kCellSize);
-                        push_global(cell);
-                    }
+    char *Allocator::commit_superblock() {
+        // Reuse a decommitted superblock before claiming a new one. Taking the
+        // index under the mutex gives this thread sole ownership of it, so two
+        // refilling threads can never recommit and carve the same superblock.
+        if (m_decommitted_count.load(std::memory_order_acquire) > 0) {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> lock(m_decommit_mutex);
+                i = take_decommitted();
+            }
 
-                    return sb_addr;
+            if (i < m_num_superblocks) {
+                if (recommit_superblock(i)) {
+                    return static_cast<char *>(m_base) + i * kSuperblockSize;
                 }
+
+                // Recommit failed: keep it available and try fresh address space
+                std::lock_guard<std::mutex> lock(m_decommit_mutex);
+                mark_decommitted(i);
             }
         }
 
@@ -306,8 +674,12 @@ namespace Cell {
         } while (!m_committed_end.compare_exchange_weak(
             current_end, new_end, std::memory_order_acq_rel, std::memory_order_relaxed));
 
-        sb_idx = current_end / kSuperblockSize;
+        size_t sb_idx = current_end / kSuperblockSize;
         void *superblock_start = static_cast<char *>(m_base) + current_end;
+        if (m_commit_hook && !m_commit_hook(m_hook_data, superblock_start)) {
+            return nullptr;
+        }
+        m_os_calls.fetch_add(1, std::memory_order_relaxed);
 
 #if defined(_WIN32)
         if (!VirtualAlloc(superblock_start, kSuperblockSize, MEM_COMMIT, PAGE_READWRITE)) {
@@ -321,37 +693,103 @@ namespace Cell {
 
         // Mark superblock as in-use
         m_superblock_states[sb_idx].store(SuperblockState::kInUse, std::memory_order_relaxed);
-        m_free_cells[sb_idx].store(kCellsPerSuperblock - 1, std::memory_order_relaxed);
+        m_committed_bytes.fetch_add(kSuperblockSize, std::memory_order_relaxed);
+        m_superblock_commits.fetch_add(1, std::memory_order_relaxed);
 
-        // Carve superblock into cells, push all but one to global pool
-        auto *base_ptr = static_cast<char *>(superblock_start);
+        return static_cast<char *>(superblock_start);
+    }
+
+    void Allocator::push_superblock_cells(char *superblock, size_t first_cell) {
+        if (first_cell >= m_cells_per_superblock)
+            return;
 
-        for (size_t i = 1; i < kCellsPerSuperblock; ++i) {
-            auto *cell = reinterpret_cast<FreeCell *>(base_ptr + i * kCellSize);
-            push_global(cell);
+        // Link the cells into magazines privately, then publish them with one CAS
+        FreeCell *first = nullptr;
+        FreeCell *last = nullptr;
+        for (size_t i = first_cell; i < m_cells_per_superblock; i += m_magazine_size) {
+            size_t end = i + m_magazine_size;
+            if (end > m_cells_per_superblock) {
+                end = m_cells_per_superblock;
+            }
+
+            auto *magazine = reinterpret_cast<FreeCell *>(superblock + i * m_cell_size);
+            FreeCell *tail = magazine;
+            for (size_t j = i + 1; j < end; ++j) {
+                auto *cell = reinterpret_cast<FreeCell *>(superblock + j * m_cell_size);
+                tail->next = cell;
+                tail = cell;
+            }
+            tail->next = nullptr;
+            magazine->count = end - i;
+            magazine->next_magazine = nullptr;
+
+            if (last) {
+                last->next_magazine = magazine;
+            } else {
+                first = magazine;
+            }
+            last = magazine;
         }
 
-        return superblock_start;
+        push_magazines(first, last);
     }
 
-    void Allocator::push_global(FreeCell *c) {
-        FreeCell *old_head = m_global_head.load(std::memory_order_relaxed);
+
+    // =========================================================================
+    // Magazine Depot
+    // =========================================================================
+
+    uint64_t Allocator::encode_depot_head(FreeCell *magazine, uint64_t tag) const {
+        uint64_t slot = 0;
+        if (magazine) {
+            auto addr = reinterpret_cast<uintptr_t>(magazine);
+            auto base_addr = reinterpret_cast<uintptr_t>(m_base);
+            slot = static_cast<uint64_t>((addr - base_addr) >> m_cell_size_log2) + 1;
+        }
+        return (tag << 32) | slot;
+    }
+
+    FreeCell *Allocator::decode_depot_head(uint64_t head) const {
+        uint64_t slot = head & 0xFFFFFFFFu;
+        if (slot == 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<FreeCell *>(static_cast<char *>(m_base) +
+                                            ((slot - 1) << m_cell_size_log2));
+    }
+
+    void Allocator::push_magazines(FreeCell *first, FreeCell *last) {
+        assert(in_reservation(first) && in_reservation(last) && "Magazine from another Allocator");
+        uint64_t old_head = m_depot_head.load(std::memory_order_relaxed);
+        uint64_t new_head;
         do {
-            c->next = old_head;
-        } while (!m_global_head.compare_exchange_weak(old_head, c, std::memory_order_release,
-                                                      std::memory_order_relaxed));
+            last->next_magazine = decode_depot_head(old_head);
+            new_head = encode_depot_head(first, (old_head >> 32) + 1);
+        } while (!m_depot_head.compare_exchange_weak(old_head, new_head, std::memory_order_release,
+                                                     std::memory_order_relaxed));
     }
 
-    FreeCell *Allocator::pop_global() {
-        FreeCell *old_head = m_global_head.load(std::memory_order_acquire);
-        while (old_head) {
-            FreeCell *new_head = old_head->next;
-            if (m_global_head.compare_exchange_weak(old_head, new_head, std::memory_order_acq_rel,
-                                                    std::memory_order_acquire)) {
-                return old_head;
+    FreeCell *Allocator::pop_magazine() {
+        uint64_t old_head = m_depot_head.load(std::memory_order_acquire);
+        while (FreeCell *magazine = decode_depot_head(old_head)) {
+            // The tag changes on every update, so a magazine popped and pushed
+            // back between our load and CAS cannot be mistaken for this head.
+            uint64_t new_head = encode_depot_head(magazine->next_magazine, (old_head >> 32) + 1);
+            if (m_depot_head.compare_exchange_weak(old_head, new_head, std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+                return magazine;
             }
         }
         return nullptr;
     }
 
+    FreeCell *Allocator::take_all_magazines() {
+        uint64_t old_head = m_depot_head.load(std::memory_order_acquire);
+        while (!m_depot_head.compare_exchange_weak(old_head, ((old_head >> 32) + 1) << 32,
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+        }
+        return decode_depot_head(old_head);
+    }
+
 }
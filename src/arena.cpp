@@ -9,7 +9,9 @@ namespace Cell {
     // Construction / Destruction
     // =========================================================================
 
-    Arena::Arena(Context &ctx, uint8_t tag) : m_ctx(ctx), m_tag(tag) {}
+    Arena::Arena(Context &ctx, uint8_t tag)
+        : m_ctx(ctx), m_tag(tag),
+          m_usable_per_cell(ctx.cell_size() - kBlockStartOffset - sizeof(CellLink)) {}
 
     Arena::~Arena() { release(); }
 
@@ -23,7 +25,7 @@ namespace Cell {
         }
 
         // Handle large allocations (> cell capacity)
-        if (size > kUsablePerCell) {
+        if (size > m_usable_per_cell) {
             // Route to full-cell allocation from context
             // For very large allocations, this will use multiple cells or direct OS
             return m_ctx.alloc_bytes(size, m_tag, alignment);
@@ -45,7 +47,7 @@ namespace Cell {
         size_t aligned_offset = m_offset + padding;
 
         // Check if current cell has enough space
-        if (aligned_offset + size > kUsablePerCell) {
+        if (aligned_offset + size > m_usable_per_cell) {
             // Need a new cell
             if (!grow()) {
                 return nullptr;
@@ -168,7 +170,7 @@ namespace Cell {
     size_t Arena::bytes_remaining() const {
         if (!m_head)
             return 0;
-        return kUsablePerCell - m_offset;
+        return m_usable_per_cell - m_offset;
     }
 
     size_t Arena::cell_count() const { return m_cell_count; }
@@ -211,7 +213,7 @@ namespace Cell {
     size_t Arena::available() const {
         if (!m_head)
             return 0;
-        return kUsablePerCell - m_offset;
+        return m_usable_per_cell - m_offset;
     }
 
     size_t Arena::align_offset(size_t offset, size_t alignment) {
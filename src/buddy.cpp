@@ -1,5 +1,7 @@
 #include "cell/buddy.h"
 
+#include "prefault.h"
+
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -19,10 +21,11 @@ namespace Cell {
     // Construction / Destruction
     // =========================================================================
 
-    BuddyAllocator::BuddyAllocator(void *base, size_t reserved_size)
-        : m_base(base), m_reserved_size(reserved_size) {
+    BuddyAllocator::BuddyAllocator(void *base, size_t reserved_size, size_t max_order)
+        : m_base(base), m_reserved_size(reserved_size),
+          m_max_order(std::clamp(max_order, kMinOrder, kMaxSupportedOrder)) {
         // Initialize free lists
-        for (size_t i = 0; i < kNumOrders; ++i) {
+        for (size_t i = 0; i < kMaxNumOrders; ++i) {
             m_free_lists[i] = nullptr;
         }
     }
@@ -36,15 +39,15 @@ namespace Cell {
     // Allocation
     // =========================================================================
 
-    void *BuddyAllocator::alloc(size_t size) {
-        if (size == 0)
+    void *BuddyAllocator::alloc(size_t size, uint8_t tag) {
+        if (size == 0 || size > max_block_size() - sizeof(BlockHeader))
             return nullptr;
 
         // Account for header
         size_t total_size = size + sizeof(BlockHeader);
         size_t order = size_to_order(total_size);
 
-        if (order > kMaxOrder) {
+        if (order > m_max_order) {
             return nullptr; // Too large for buddy
         }
 
@@ -52,7 +55,7 @@ namespace Cell {
             std::lock_guard<std::mutex> lock(m_lock);
 
             // Find smallest order with a free block
-            for (size_t o = order; o <= kMaxOrder; ++o) {
+            for (size_t o = order; o <= m_max_order; ++o) {
                 size_t list_idx = o - kMinOrder;
 
                 if (m_free_lists[list_idx]) {
@@ -73,6 +76,7 @@ namespace Cell {
                     // Set up header and return user pointer
                     BlockHeader *header = static_cast<BlockHeader *>(static_cast<void *>(block));
                     header->order = static_cast<uint8_t>(order);
+                    header->tag = tag;
                     std::memset(header->reserved, 0, sizeof(header->reserved));
 
                     size_t alloc_size = size_t{1} << order;
@@ -100,7 +104,7 @@ namespace Cell {
         BlockHeader *header = get_block_header(user_ptr);
         size_t order = header->order;
 
-        assert(order >= kMinOrder && order <= kMaxOrder && "Invalid block order");
+        assert(order >= kMinOrder && order <= m_max_order && "Invalid block order");
 
         size_t block_size = size_t{1} << order;
         m_allocated -= block_size;
@@ -110,7 +114,7 @@ namespace Cell {
         void *ptr = internal_ptr;
 
         // Try to merge with buddy
-        while (order < kMaxOrder) {
+        while (order < m_max_order) {
             void *buddy = get_buddy(ptr, order);
 
             // Check if buddy is in our committed range
@@ -161,16 +165,18 @@ namespace Cell {
         // Get block info
         BlockHeader *header = get_block_header(ptr);
         size_t old_order = header->order;
-
-        // Calculate new requirements
-        size_t total_new_size = new_size + sizeof(BlockHeader);
-        size_t new_order = size_to_order(total_new_size);
+        uint8_t tag = header->tag;
 
         // If new size is too large for buddy allocator, we can't handle it here
-        if (new_order > kMaxOrder) {
+        // (checked before adding the header so huge sizes cannot wrap)
+        if (new_size > max_block_size() - sizeof(BlockHeader)) {
             return nullptr;
         }
 
+        // Calculate new requirements
+        size_t total_new_size = new_size + sizeof(BlockHeader);
+        size_t new_order = size_to_order(total_new_size);
+
         // Optimization 1: In-place expansion (same order)
         if (new_order == old_order) {
             return ptr;
@@ -207,6 +213,7 @@ namespace Cell {
 
                     BlockHeader *new_header = static_cast<BlockHeader *>(merged_internal);
                     new_header->order = static_cast<uint8_t>(new_order);
+                    new_header->tag = tag;
                     std::memset(new_header->reserved, 0, sizeof(new_header->reserved));
 
                     void *new_user_ptr = to_user_ptr(merged_internal);
@@ -222,7 +229,7 @@ namespace Cell {
         }
 
         // Fallback: Allocate + Copy + Free
-        void *new_ptr = alloc(new_size);
+        void *new_ptr = alloc(new_size, tag);
         if (!new_ptr) {
             return nullptr;
         }
@@ -237,6 +244,21 @@ namespace Cell {
         return new_ptr;
     }
 
+    size_t BuddyAllocator::prewarm(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        size_t warmed = 0;
+        while (m_committed < bytes) {
+            void *superblock = static_cast<char *>(m_base) + m_committed;
+            if (!grow()) {
+                break;
+            }
+            prefault_pages(superblock, max_block_size());
+            warmed += max_block_size();
+        }
+        return warmed;
+    }
+
     // =========================================================================
     // Introspection
     // =========================================================================
@@ -263,26 +285,49 @@ namespace Cell {
         return size_t{1} << header->order;
     }
 
+    uint8_t BuddyAllocator::get_alloc_tag(void *ptr) const {
+        if (!owns(ptr)) {
+            return 0;
+        }
+        return get_block_header(ptr)->tag;
+    }
+
     // =========================================================================
     // Internal Methods
     // =========================================================================
 
+    size_t BuddyAllocator::block_size_for(size_t size) const {
+        if (size > max_block_size() - sizeof(BlockHeader)) {
+            return 0; // Also keeps size + header from wrapping
+        }
+        return size_t{1} << size_to_order(size + sizeof(BlockHeader));
+    }
+
     size_t BuddyAllocator::size_to_order(size_t size) {
         if (size <= kMinBlockSize)
             return kMinOrder;
 
-        // Find smallest power of 2 >= size
-        size_t order = kMinOrder;
-        size_t block_size = kMinBlockSize;
-        while (block_size < size && order < kMaxOrder) {
-            block_size <<= 1;
+        // Smallest power of 2 >= size: ceil(log2(size)) in O(1)
+        size_t v = size - 1;
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(64 - __builtin_clzll(v));
+#elif defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<size_t>(idx) + 1;
+#else
+        size_t order = 0;
+        while (v) {
+            v >>= 1;
             ++order;
         }
         return order;
+#endif
     }
 
     bool BuddyAllocator::grow() {
-        size_t new_end = m_committed + kMaxBlockSize;
+        size_t superblock_size = max_block_size();
+        size_t new_end = m_committed + superblock_size;
         if (new_end > m_reserved_size) {
             return false; // No more reserved space
         }
@@ -290,22 +335,22 @@ namespace Cell {
         void *commit_addr = static_cast<char *>(m_base) + m_committed;
 
 #ifdef _WIN32
-        void *result = VirtualAlloc(commit_addr, kMaxBlockSize, MEM_COMMIT, PAGE_READWRITE);
+        void *result = VirtualAlloc(commit_addr, superblock_size, MEM_COMMIT, PAGE_READWRITE);
         if (!result)
             return false;
 #else
-        // On Linux, we use mmap with MAP_FIXED to commit already-reserved pages
-        // Or if using overcommit, the pages are committed on first touch
-        // For now, assume the memory is already accessible (reserved with PROT_READ|PROT_WRITE)
-        // Just touch the first page to ensure it's committed
-        static_cast<volatile char *>(commit_addr)[0] = 0;
+        // The region is reserved PROT_NONE | MAP_NORESERVE; making a superblock
+        // writable is what charges it against the commit limit.
+        if (mprotect(commit_addr, superblock_size, PROT_READ | PROT_WRITE) != 0) {
+            return false;
+        }
 #endif
 
-        m_committed += kMaxBlockSize;
+        m_committed += superblock_size;
         ++m_superblock_count;
 
-        // Add the new 2MB block to the max-order free list
-        add_to_free_list(commit_addr, kMaxOrder);
+        // Add the new superblock to the max-order free list
+        add_to_free_list(commit_addr, m_max_order);
 
         return true;
     }
@@ -1,9 +1,11 @@
 #include "cell/context.h"
+#include "cell/stack_depot.h"
 
-#include "tls_bin_cache.h"
 #include "tls_cache.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 
@@ -28,49 +30,74 @@
 
 namespace Cell {
 
-    // =========================================================================
-    // Bit Manipulation Helpers
-    // =========================================================================
+#if defined(CELL_ENABLE_BUDGET) || defined(CELL_ENABLE_INSTRUMENTATION)
+    namespace {
+        /** @brief Source of Context::m_context_id; 0 is never issued. */
+        std::atomic<uint64_t> s_next_context_id{1};
+    } // namespace
+#endif
 
-    /**
-     * @brief Rounds up to the next power of 2 using O(1) bit manipulation.
-     * @param v Value to round up (must be > 0).
-     * @return Next power of 2 >= v.
-     */
-    CELL_FORCE_INLINE size_t next_power_of_2(size_t v) {
-        if (v == 0)
-            return 1;
-        --v;
-#if defined(__GNUC__) || defined(__clang__)
-        // Use count-leading-zeros for O(1) computation
-        return 1ULL << (64 - __builtin_clzll(v | 1));
-#elif defined(_MSC_VER)
-        unsigned long idx;
-        _BitScanReverse64(&idx, v | 1);
-        return 1ULL << (idx + 1);
-#else
-        // Fallback: bit smearing
-        v |= v >> 1;
-        v |= v >> 2;
-        v |= v >> 4;
-        v |= v >> 8;
-        v |= v >> 16;
-        v |= v >> 32;
-        return v + 1;
+#ifdef CELL_ENABLE_BUDGET
+    namespace {
+        /**
+         * @brief Keeps t_budget_credit's credit alive.
+         *
+         * Shared with the Context's registry, so the credit outlives whichever
+         * of the thread and the Context goes first.
+         */
+        thread_local std::shared_ptr<BudgetCredit> t_budget_credit_owner;
+    } // namespace
 #endif
-    }
 
-    Context::Context(const Config &config) : m_reserved_size(config.reserve_size) {
+#ifdef CELL_ENABLE_INSTRUMENTATION
+    namespace {
+        /**
+         * @brief One of the calling thread's event rings and the Context it belongs to.
+         *
+         * Shared with the Context's registry, so the ring outlives whichever of
+         * the thread and the Context goes first.
+         */
+        struct ThreadEventRing {
+            std::shared_ptr<EventRing> ring;
+            uint64_t context_id = 0;
+        };
+
+        /** @brief The calling thread's rings, one per Context it has recorded events for. */
+        struct ThreadEventRings {
+            std::vector<ThreadEventRing> rings;
+            size_t last = 0; ///< Index of the most recently used ring.
+        };
+
+        thread_local ThreadEventRings t_event_rings;
+    } // namespace
+#endif
+
+    Context::Context(const Config &config)
+        : m_reserved_size(config.reserve_size),
+          m_cell_size_log2(std::clamp(config.cell_size_log2, kMinCellSizeLog2, kMaxCellSizeLog2)),
+          m_cell_size(size_t{1} << m_cell_size_log2),
+          m_cell_mask(~static_cast<uintptr_t>(m_cell_size - 1)),
+          m_num_bins(size_class_count(m_cell_size_log2)),
+          m_max_subcell_size(kSizeClasses[m_num_bins - 1]),
+          m_tls_bin_count(std::min({config.tls_bin_cache_count, kTlsBinCacheCount, m_num_bins})),
+          m_tls_bin_capacity(
+              std::clamp(config.tls_bin_cache_capacity, size_t{1}, kTlsBinCacheCapacity)),
+          m_tls_bin_refill(std::clamp(config.tls_bin_batch_refill, size_t{1}, m_tls_bin_capacity)),
+          m_warm_cells_per_bin(config.warm_cells_per_bin) {
         // Split reserved space: half for cells, half for buddy
         // Both need to be reasonably sized for their use cases
         size_t cell_reserve = m_reserved_size / 2;
         size_t buddy_reserve = m_reserved_size / 2;
 
+        // Buddy superblocks are one max-order block each
+        size_t buddy_max_order = std::clamp(config.buddy_max_order, BuddyAllocator::kMinOrder,
+                                            BuddyAllocator::kMaxSupportedOrder);
+        size_t buddy_superblock = size_t{1} << buddy_max_order;
+
         // Round down to superblock alignment for cell region
         cell_reserve = (cell_reserve / kSuperblockSize) * kSuperblockSize;
-        // Round down to 2MB alignment for buddy region
-        buddy_reserve =
-            (buddy_reserve / BuddyAllocator::kMaxBlockSize) * BuddyAllocator::kMaxBlockSize;
+        // Round down to buddy superblock alignment for buddy region
+        buddy_reserve = (buddy_reserve / buddy_superblock) * buddy_superblock;
 
 #if defined(_WIN32)
         m_base = VirtualAlloc(nullptr, cell_reserve, MEM_RESERVE, PAGE_NOACCESS);
@@ -84,34 +111,86 @@ namespace Cell {
             m_base = nullptr;
         }
         if (m_base) {
-            m_buddy_base = mmap(nullptr, buddy_reserve, PROT_READ | PROT_WRITE,
-                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            // Reserved like the cell region; BuddyAllocator::grow() commits superblocks
+            m_buddy_base = mmap(nullptr, buddy_reserve, PROT_NONE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
             if (m_buddy_base == MAP_FAILED) {
                 m_buddy_base = nullptr;
             }
         }
 #endif
 
+#ifdef CELL_ENABLE_BUDGET
+        if (m_base) {
+            // One tag byte per 16 bytes of cell region, backed as blocks under it are used
+            m_block_tags_size = cell_reserve >> kBlockTagShift;
+            // Reserved only: commit_block_tags() commits each superblock's tags with it
+#if defined(_WIN32)
+            m_block_tags = static_cast<uint8_t *>(
+                VirtualAlloc(nullptr, m_block_tags_size, MEM_RESERVE, PAGE_NOACCESS));
+            if (!m_block_tags) {
+                VirtualFree(m_base, 0, MEM_RELEASE);
+                m_base = nullptr;
+            }
+#else
+            void *tags = mmap(nullptr, m_block_tags_size, PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (tags != MAP_FAILED) {
+                m_block_tags = static_cast<uint8_t *>(tags);
+            } else {
+                // Budgets need block tags, so the cell tiers stay unavailable
+                munmap(m_base, cell_reserve);
+                m_base = nullptr;
+            }
+#endif
+        }
+#endif
+
         if (m_base) {
             m_reserved_size = cell_reserve;
-            m_allocator = std::make_unique<Allocator>(m_base, cell_reserve);
+            // Two magazines per thread; at least one cell each
+            size_t tls_cache_capacity = std::clamp(config.tls_cache_capacity, size_t{2},
+                                                   kTlsCacheCapacity);
+            m_allocator = std::make_unique<Allocator>(m_base, cell_reserve, config.release_policy,
+                                                      tls_cache_capacity / 2, m_cell_size_log2);
+#ifdef CELL_ENABLE_BUDGET
+            m_allocator->set_superblock_hooks(&Context::commit_block_tags,
+                                              &Context::release_block_tags, this);
+#endif
         }
 
         if (m_buddy_base) {
             m_buddy_reserved_size = buddy_reserve;
-            m_buddy = std::make_unique<BuddyAllocator>(m_buddy_base, buddy_reserve);
+            m_buddy = std::make_unique<BuddyAllocator>(m_buddy_base, buddy_reserve,
+                                                       buddy_max_order);
         }
 
         // Initialize bins (already zero-initialized, but be explicit)
         for (size_t i = 0; i < kNumSizeBins; ++i) {
+            m_blocks_per_cell[i] =
+                i < m_num_bins ? static_cast<uint16_t>(blocks_per_cell(i, m_cell_size)) : 0;
             m_bins[i].partial_head = nullptr;
             m_bins[i].warm_cell_count = 0;
             m_bins[i].total_allocated = 0;
             m_bins[i].current_allocated = 0;
         }
 
+        if (config.page_guard_sample_rate != 0) {
+            set_page_guard_sample_rate(config.page_guard_sample_rate);
+        }
+#if defined(CELL_ENABLE_BUDGET) || defined(CELL_ENABLE_INSTRUMENTATION)
+        m_context_id = s_next_context_id.fetch_add(1, std::memory_order_relaxed);
+#endif
 #ifdef CELL_ENABLE_BUDGET
         m_budget = config.memory_budget;
+        m_budget_slack = config.budget_slack;
+        m_soft_budget = config.soft_memory_budget;
+#endif
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        m_heap_profiler.set_sample_interval(config.heap_sample_interval);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        m_event_ring_capacity = std::max(config.event_ring_capacity, size_t{2});
 #endif
     }
 
@@ -120,26 +199,291 @@ namespace Cell {
     // =========================================================================
 
 #ifdef CELL_ENABLE_BUDGET
-    bool Context::check_budget(size_t size) {
-        if (m_budget == 0) {
-            return true; // Unlimited
+    bool Context::commit_block_tags(void *user_data, void *superblock) {
+        auto *self = static_cast<Context *>(user_data);
+        size_t page_size = LargeAllocRegistry::rounded_size(1);
+        auto start = reinterpret_cast<uintptr_t>(self->m_block_tags) +
+                     self->block_tag_index(superblock);
+        uintptr_t end = start + (kSuperblockSize >> kBlockTagShift);
+
+        // Round outwards: a neighbouring superblock's tags may share the end pages
+        start &= ~(page_size - 1);
+        end = (end + page_size - 1) & ~(page_size - 1);
+        auto *tags = reinterpret_cast<void *>(start);
+#if defined(_WIN32)
+        return VirtualAlloc(tags, end - start, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+        return mprotect(tags, end - start, PROT_READ | PROT_WRITE) == 0;
+#endif
+    }
+
+    void Context::release_block_tags(void *user_data, void *superblock) {
+        auto *self = static_cast<Context *>(user_data);
+        size_t page_size = LargeAllocRegistry::rounded_size(1);
+        auto start = reinterpret_cast<uintptr_t>(self->m_block_tags) +
+                     self->block_tag_index(superblock);
+        uintptr_t end = start + (kSuperblockSize >> kBlockTagShift);
+
+        // Round inwards, leaving pages shared with a neighbour's tags resident.
+        // The pages stay writable: tags are rewritten before they are read again.
+        start = (start + page_size - 1) & ~(page_size - 1);
+        end &= ~(page_size - 1);
+        if (start >= end) {
+            return;
         }
+        auto *tags = reinterpret_cast<void *>(start);
+#if defined(_WIN32)
+        VirtualAlloc(tags, end - start, MEM_RESET, PAGE_READWRITE);
+#else
+        madvise(tags, end - start, MADV_DONTNEED);
+#endif
+    }
+
+    bool Context::check_budget(size_t size, uint8_t tag) {
         size_t current = m_budget_current.load(std::memory_order_relaxed);
-        if (current + size > m_budget) {
+        if (m_budget != 0 && current + size > m_budget && m_soft_budget != 0 &&
+            relieve_budget_pressure()) {
+            current = m_budget_current.load(std::memory_order_relaxed);
+        }
+        if (m_budget != 0 && current + size > m_budget) {
             if (m_budget_callback) {
                 m_budget_callback(size, m_budget, current);
             }
             return false;
         }
+        size_t tag_budget = m_tag_budget[tag];
+        size_t tag_current = m_tag_budget_current[tag].load(std::memory_order_relaxed);
+        if (tag_budget != 0 && tag_current + size > tag_budget) {
+            if (m_tag_budget_callbacks[tag]) {
+                m_tag_budget_callbacks[tag](tag, size, tag_budget, tag_current);
+            }
+            return false;
+        }
         return true;
     }
 
-    void Context::record_budget_alloc(size_t size) {
+    void Context::record_budget_alloc(size_t size, uint8_t tag) {
         m_budget_current.fetch_add(size, std::memory_order_relaxed);
+        m_tag_budget_current[tag].fetch_add(size, std::memory_order_relaxed);
+        if (m_soft_budget != 0) {
+            check_soft_budget();
+        }
     }
 
-    void Context::record_budget_free(size_t size) {
+    void Context::record_budget_free(size_t size, uint8_t tag) {
         m_budget_current.fetch_sub(size, std::memory_order_relaxed);
+        m_tag_budget_current[tag].fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    bool Context::charge_budget(size_t size, uint8_t tag, bool notify) {
+        if (take_budget_credit(size, tag)) {
+            return true;
+        }
+
+        BudgetCredit *credit = thread_budget_credit();
+        std::atomic<size_t> &tag_credit = credit->tag_bytes[tag];
+        auto refill = [&]() {
+            return refill_budget_credit(credit->bytes, m_budget_current, m_budget, size) &&
+                   refill_budget_credit(tag_credit, m_tag_budget_current[tag], m_tag_budget[tag],
+                                        size);
+        };
+
+        if (!refill()) {
+            {
+                std::lock_guard<std::mutex> lock(m_budget_credits_lock);
+                reclaim_budget_credits();
+            }
+            if (!refill()) {
+                if (!notify) {
+                    return false;
+                }
+                bool over_budget = credit->bytes.load(std::memory_order_relaxed) < size;
+                // At the hard limit, the pressure pipeline gets one chance to make room
+                bool relieved = over_budget && m_soft_budget != 0 && relieve_budget_pressure();
+                if (!relieved || !refill()) {
+                    if (over_budget) {
+                        if (m_budget_callback) {
+                            m_budget_callback(size, m_budget, get_budget_current());
+                        }
+                    } else if (m_tag_budget_callbacks[tag]) {
+                        m_tag_budget_callbacks[tag](tag, size, m_tag_budget[tag],
+                                                    get_tag_budget_current(tag));
+                    }
+                    return false;
+                }
+            }
+        }
+
+        credit->bytes.store(credit->bytes.load(std::memory_order_relaxed) - size,
+                            std::memory_order_relaxed);
+        tag_credit.store(tag_credit.load(std::memory_order_relaxed) - size,
+                         std::memory_order_relaxed);
+        if (m_soft_budget != 0) {
+            check_soft_budget();
+        }
+        return true;
+    }
+
+    void Context::check_soft_budget() {
+        if (m_budget_current.load(std::memory_order_relaxed) <= m_soft_budget) {
+            if (m_soft_budget_crossed.load(std::memory_order_relaxed)) {
+                m_soft_budget_crossed.store(false, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (!m_soft_budget_crossed.exchange(true, std::memory_order_relaxed)) {
+            relieve_budget_pressure();
+        }
+    }
+
+    bool Context::relieve_budget_pressure() {
+        std::unique_lock<std::mutex> lock(m_budget_pressure_lock, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> credits_lock(m_budget_credits_lock);
+            reclaim_budget_credits();
+        }
+        // Warm cells, this thread's caches and credit, then unused cell pages.
+        // Large blocks are unmapped as they are freed, so there is no large cache.
+        trim(PressureLevel::kModerate);
+
+        if (m_budget_pressure_callback) {
+            m_budget_pressure_callback(m_soft_budget, m_budget, get_budget_current());
+        }
+        return true;
+    }
+
+    void Context::refund_budget(size_t size, uint8_t tag) {
+        if (give_budget_credit(size, tag)) {
+            return;
+        }
+
+        ThreadBudgetCredit &local = t_budget_credit;
+        if (local.context_id != m_context_id) {
+            // Freed by a thread without credit here: return the bytes directly
+            record_budget_free(size, tag);
+            return;
+        }
+
+        BudgetCredit &credit = *local.credit;
+        credit.bytes.store(credit.bytes.load(std::memory_order_relaxed) + size,
+                           std::memory_order_relaxed);
+        credit.tag_bytes[tag].store(credit.tag_bytes[tag].load(std::memory_order_relaxed) + size,
+                                    std::memory_order_relaxed);
+        return_budget_credit(credit.bytes, m_budget_current);
+        return_budget_credit(credit.tag_bytes[tag], m_tag_budget_current[tag]);
+    }
+
+    bool Context::refill_budget_credit(std::atomic<size_t> &credit, std::atomic<size_t> &counter,
+                                       size_t limit, size_t size) {
+        size_t held = credit.load(std::memory_order_relaxed);
+        if (held >= size) {
+            return true;
+        }
+
+        // Reserve the shortfall plus a refill when it fits; near the limit, only
+        // the shortfall. The CAS keeps concurrent refills from passing the limit.
+        auto reserve = [&counter, limit](size_t bytes) {
+            size_t current = counter.load(std::memory_order_relaxed);
+            do {
+                if (limit != 0 && current + bytes > limit) {
+                    return false;
+                }
+            } while (!counter.compare_exchange_weak(current, current + bytes,
+                                                    std::memory_order_relaxed));
+            return true;
+        };
+
+        size_t need = size - held;
+        size_t extra = m_budget_slack / 2;
+        if (!reserve(need + extra)) {
+            extra = 0;
+            if (!reserve(need)) {
+                return false;
+            }
+        }
+        credit.store(held + need + extra, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Context::return_budget_credit(std::atomic<size_t> &credit,
+                                       std::atomic<size_t> &counter) {
+        size_t held = credit.load(std::memory_order_relaxed);
+        if (held <= m_budget_slack) {
+            return;
+        }
+        // Keep half the slack for this thread's next allocations
+        size_t keep = m_budget_slack / 2;
+        credit.store(keep, std::memory_order_relaxed);
+        counter.fetch_sub(held - keep, std::memory_order_relaxed);
+    }
+
+    BudgetCredit *Context::thread_budget_credit() {
+        ThreadBudgetCredit &local = t_budget_credit;
+        if (CELL_LIKELY(local.context_id == m_context_id)) {
+            return local.credit;
+        }
+
+        auto credit = std::make_shared<BudgetCredit>();
+        {
+            std::lock_guard<std::mutex> lock(m_budget_credits_lock);
+            reclaim_budget_credits();
+            m_budget_credits.push_back(credit);
+        }
+        // Any credit held for another Context stays with it until reclaimed there
+        local.credit = credit.get();
+        local.context_id = m_context_id;
+        t_budget_credit_owner = std::move(credit);
+        return local.credit;
+    }
+
+    void Context::release_budget_credit(BudgetCredit &credit) {
+        m_budget_current.fetch_sub(credit.bytes.exchange(0, std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+        for (size_t tag = 0; tag < kNumBudgetTags; ++tag) {
+            size_t held = credit.tag_bytes[tag].exchange(0, std::memory_order_relaxed);
+            if (held != 0) {
+                m_tag_budget_current[tag].fetch_sub(held, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Context::reclaim_budget_credits() {
+        for (size_t i = 0; i < m_budget_credits.size();) {
+            // Only the registry holds the credit once its thread has exited or moved on
+            if (m_budget_credits[i].use_count() == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                release_budget_credit(*m_budget_credits[i]);
+                m_budget_credits[i] = std::move(m_budget_credits.back());
+                m_budget_credits.pop_back();
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    size_t Context::get_budget_current() const {
+        std::lock_guard<std::mutex> lock(m_budget_credits_lock);
+        size_t held = 0;
+        for (const auto &credit : m_budget_credits) {
+            held += credit->bytes.load(std::memory_order_relaxed);
+        }
+        // Threads may move bytes between their credit and the counter meanwhile
+        size_t reserved = m_budget_current.load(std::memory_order_relaxed);
+        return reserved > held ? reserved - held : 0;
+    }
+
+    size_t Context::get_tag_budget_current(uint8_t tag) const {
+        std::lock_guard<std::mutex> lock(m_budget_credits_lock);
+        size_t held = 0;
+        for (const auto &credit : m_budget_credits) {
+            held += credit->tag_bytes[tag].load(std::memory_order_relaxed);
+        }
+        size_t reserved = m_tag_budget_current[tag].load(std::memory_order_relaxed);
+        return reserved > held ? reserved - held : 0;
     }
 #endif
 
@@ -148,34 +492,112 @@ namespace Cell {
     // =========================================================================
 
 #ifdef CELL_ENABLE_INSTRUMENTATION
-    void Context::invoke_alloc_callback(void *ptr, size_t size, uint8_t tag, bool is_alloc) {
+    void Context::record_event(void *ptr, size_t size, uint8_t size_class, uint8_t tag,
+                               bool is_alloc) {
         if (m_alloc_callback) {
             m_alloc_callback(ptr, size, tag, is_alloc);
         }
+        if (m_event_stream.load(std::memory_order_relaxed)) {
+            EventRing *ring = thread_event_ring();
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            ring->push(AllocEvent{
+                static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+                ptr, size, size_class, tag, is_alloc ? AllocEventOp::kAlloc : AllocEventOp::kFree});
+        }
+    }
+
+    EventRing *Context::thread_event_ring() {
+        ThreadEventRings &local = t_event_rings;
+        std::vector<ThreadEventRing> &rings = local.rings;
+        if (CELL_LIKELY(local.last < rings.size() &&
+                        rings[local.last].context_id == m_context_id)) {
+            return rings[local.last].ring.get();
+        }
+        for (size_t i = 0; i < rings.size(); ++i) {
+            if (rings[i].context_id == m_context_id) {
+                local.last = i;
+                return rings[i].ring.get();
+            }
+        }
+
+        // Rings only this thread still holds belong to destroyed Contexts
+        rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                   [](const ThreadEventRing &r) { return r.ring.use_count() == 1; }),
+                    rings.end());
+
+        auto ring = std::make_shared<EventRing>(m_event_ring_capacity);
+        {
+            std::lock_guard<std::mutex> lock(m_event_rings_lock);
+            m_event_rings.push_back(ring);
+        }
+        rings.push_back(ThreadEventRing{std::move(ring), m_context_id});
+        local.last = rings.size() - 1;
+        return rings.back().ring.get();
+    }
+
+    size_t Context::drain_events(AllocEvent *out, size_t max_events) {
+        std::lock_guard<std::mutex> lock(m_event_rings_lock);
+
+        size_t drained = 0;
+        for (size_t i = 0; i < m_event_rings.size();) {
+            EventRing &ring = *m_event_rings[i];
+            drained += ring.pop(out + drained, max_events - drained);
+
+            // Only the registry holds the ring once its thread has exited
+            if (m_event_rings[i].use_count() == 1 && ring.empty()) {
+                m_retired_dropped_events += ring.dropped();
+                m_event_rings[i] = std::move(m_event_rings.back());
+                m_event_rings.pop_back();
+                continue;
+            }
+            ++i;
+        }
+        return drained;
+    }
+
+    size_t Context::dropped_events() const {
+        std::lock_guard<std::mutex> lock(m_event_rings_lock);
+        size_t dropped = m_retired_dropped_events;
+        for (const auto &ring : m_event_rings) {
+            dropped += ring->dropped();
+        }
+        return dropped;
     }
 #endif
 
     Context::~Context() {
 #ifdef CELL_DEBUG_LEAKS
         // Report any leaked allocations before cleanup
-        if (!m_live_allocs.empty()) {
+        if (m_live_allocs.size() != 0) {
             std::fprintf(stderr, "\n[CELL] WARNING: %zu allocation(s) leaked:\n",
                          m_live_allocs.size());
             report_leaks();
         }
 #endif
 
-        // Clear TLS bin caches to prevent stale pointers for future Contexts.
-        // The cached blocks will be freed when the memory region is unmapped.
-        // Note: This only clears the current thread's caches.
-        for (size_t i = 0; i < kTlsBinCacheCount; ++i) {
-            t_bin_cache[i].count = 0;
+        // Clear TLS bin caches to prevent stale pointers for future Contexts, if
+        // they hold our blocks. The cached blocks will be freed when the memory
+        // region is unmapped. Note: This only clears the current thread's caches.
+        if (t_bin_cache_owner == this) {
+            for (size_t i = 0; i < kTlsBinCacheCount; ++i) {
+                t_bin_cache[i].count = 0;
+            }
+            t_bin_cache_owner = nullptr;
         }
 
-        // Also clear the cell-level TLS cache (don't flush, just clear)
-        // The cached cells will be freed when the memory region is unmapped
+        // Also clear the cell-level TLS cache (don't flush, just clear) if it holds
+        // our cells. The cached cells will be freed when the memory region is unmapped
         // Flushing would push them to the global pool which is about to be unmapped
-        t_cache.count = 0;
+        if (t_cache.owner == m_allocator.get()) {
+            t_cache.clear();
+        }
+
+#ifdef CELL_ENABLE_BUDGET
+        if (t_budget_credit.context_id == m_context_id) {
+            t_budget_credit = ThreadBudgetCredit{};
+        }
+#endif
 
         // Buddy allocator destructor handles its cleanup
         m_buddy.reset();
@@ -195,6 +617,15 @@ namespace Cell {
             munmap(m_buddy_base, m_buddy_reserved_size);
 #endif
         }
+#ifdef CELL_ENABLE_BUDGET
+        if (m_block_tags) {
+#if defined(_WIN32)
+            VirtualFree(m_block_tags, 0, MEM_RELEASE);
+#else
+            munmap(m_block_tags, m_block_tags_size);
+#endif
+        }
+#endif
     }
 
     // =========================================================================
@@ -206,24 +637,39 @@ namespace Cell {
             return nullptr;
         }
 
-        if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > 16) {
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0 ||
+            (alignment > 16 && !fits_aligned_bin(size, alignment))) {
             return nullptr;
         }
 
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        if (heap_sample_tick(size)) {
+            return alloc_sampled(size, tag, alignment);
+        }
+#endif
+
+        // Bin alignments beyond a page stay unguarded, as in alloc_aligned()
+        if (CELL_UNLIKELY(m_page_guard_active.load(std::memory_order_relaxed)) &&
+            (alignment <= 16 || alignment <= LargeAllocRegistry::rounded_size(1)) &&
+            should_page_guard(tag)) {
+            return alloc_page_guarded(size, tag, alignment);
+        }
+
         // Size routing:
         // <= 8KB: sub-cell bins
         // <= 16KB (usable cell space): full cell
-        // <= 2MB: buddy allocator
-        // > 2MB: direct OS (large allocation)
+        // fits buddy max block: buddy allocator
+        // larger: direct OS (large allocation)
 
-        size_t usable_cell_size = kCellSize - kBlockStartOffset;
+        size_t usable_cell_size = m_cell_size - kBlockStartOffset;
         void *result = nullptr;
 
 #ifdef CELL_DEBUG_GUARDS
         // For sub-cell allocations that fit with guards, add space for guard bytes
+        // (compared as a subtraction so sizes near SIZE_MAX cannot wrap)
         size_t alloc_size = size;
         bool will_have_guards = false;
-        if (size + (2 * kGuardSize) <= kMaxSubCellSize) {
+        if (size <= m_max_subcell_size - (2 * kGuardSize)) {
             alloc_size = size + (2 * kGuardSize);
             will_have_guards = true;
         }
@@ -232,51 +678,51 @@ namespace Cell {
 #endif
 
 #ifdef CELL_ENABLE_BUDGET
-        // Calculate budget_size upfront so check_budget uses the same rounded size
-        // that record_budget_alloc will use, preventing budget overruns from rounding
+        // Rounded size charged against the budget, so the charge and the refund
+        // on free agree. alloc_large() charges buddy and large allocations itself.
         size_t budget_size = 0;
-        if (alloc_size <= kMaxSubCellSize) {
-            uint8_t bin_index = get_size_class(alloc_size, alignment);
-            if (bin_index == kFullCellMarker) {
-                budget_size = kCellSize;
-            } else {
-                budget_size = kSizeClasses[bin_index];
-            }
-        } else if (size <= usable_cell_size) {
-            budget_size = kCellSize;
-        } else {
-            // Large allocation - alloc_large handles its own budget check
-            budget_size = 0;
-        }
-
-        // Check budget with actual rounded size (skip if alloc_large will handle it)
-        if (budget_size > 0 && !check_budget(budget_size)) {
-            return nullptr;
-        }
 #endif
 
-        if (CELL_LIKELY(alloc_size <= kMaxSubCellSize)) {
+        if (CELL_LIKELY(alloc_size <= m_max_subcell_size)) {
             // Sub-cell allocation - hot path
             if (CELL_UNLIKELY(!m_allocator))
                 return nullptr;
 
             // Fast path: common sizes with default alignment go through TLS cache
             // directly, avoiding function call overhead (bins 0-8: 16B to 4KB)
-#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS) && !defined(CELL_ENABLE_BUDGET)
+#ifndef CELL_DEBUG_GUARDS
             if (CELL_LIKELY(alignment <= 8 && alloc_size <= 4096)) {
                 // Use O(1) size class lookup
                 uint8_t bin_index = get_size_class_fast(alloc_size);
 
                 // Inline TLS cache check for maximum speed
+                claim_bin_cache();
                 TlsBinCache &cache = t_bin_cache[bin_index];
-                if (CELL_LIKELY(cache.count > 0)) {
+#ifdef CELL_ENABLE_BUDGET
+                bool hit = cache.count > 0 && take_budget_credit(kSizeClasses[bin_index], tag);
+#else
+                bool hit = cache.count > 0;
+#endif
+                if (CELL_LIKELY(hit)) {
                     result = cache.blocks[--cache.count];
+#ifdef CELL_ENABLE_BUDGET
+                    set_block_tag(result, tag);
+#endif
 #ifdef CELL_ENABLE_STATS
-                    m_stats.record_alloc(kSizeClasses[bin_index], tag);
-                    m_stats.subcell_allocs.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_subcell_alloc(size, bin_index, tag, 1, 1);
 #endif
 #ifdef CELL_ENABLE_INSTRUMENTATION
-                    invoke_alloc_callback(result, size, tag, true);
+                    record_event(result, size, bin_index, tag, true);
+#endif
+#ifdef CELL_DEBUG_LEAKS
+                    DebugAllocation alloc{};
+                    alloc.ptr = result;
+                    alloc.size = size;
+                    alloc.tag = tag;
+#ifdef CELL_DEBUG_STACKTRACE
+                    alloc.stack_id = capture_stack_id(2);
+#endif
+                    m_live_allocs.insert(alloc);
 #endif
                     return result;
                 }
@@ -285,6 +731,12 @@ namespace Cell {
 #endif
 
             uint8_t bin_index = get_size_class(alloc_size, alignment);
+#ifdef CELL_ENABLE_BUDGET
+            budget_size = bin_index == kFullCellMarker ? m_cell_size : kSizeClasses[bin_index];
+            if (!charge_budget(budget_size, tag)) {
+                return nullptr;
+            }
+#endif
             if (CELL_UNLIKELY(bin_index == kFullCellMarker)) {
                 // Rare edge case: alignment pushes us to full cell
                 CellData *cell = alloc_cell(tag);
@@ -298,16 +750,14 @@ namespace Cell {
 #endif
 #ifdef CELL_ENABLE_STATS
                 if (result) {
-                    m_stats.record_alloc(kCellSize, tag);
-                    m_stats.cell_allocs.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_alloc(m_cell_size, tag, StatsTier::kCell);
                 }
 #endif
             } else {
                 result = alloc_from_bin(bin_index, tag);
 #ifdef CELL_ENABLE_STATS
                 if (result) {
-                    m_stats.record_alloc(kSizeClasses[bin_index], tag);
-                    m_stats.subcell_allocs.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_subcell_alloc(size, bin_index, tag);
                 }
 #endif
             }
@@ -315,6 +765,12 @@ namespace Cell {
             // Full cell allocation (up to ~16KB)
             if (!m_allocator)
                 return nullptr;
+#ifdef CELL_ENABLE_BUDGET
+            budget_size = m_cell_size;
+            if (!charge_budget(budget_size, tag)) {
+                return nullptr;
+            }
+#endif
             CellData *cell = alloc_cell(tag);
             if (cell) {
                 cell->header.size_class = kFullCellMarker;
@@ -326,8 +782,7 @@ namespace Cell {
 #endif
 #ifdef CELL_ENABLE_STATS
             if (result) {
-                m_stats.record_alloc(kCellSize, tag);
-                m_stats.cell_allocs.fetch_add(1, std::memory_order_relaxed);
+                m_stats.record_alloc(m_cell_size, tag, StatsTier::kCell);
             }
 #endif
         } else {
@@ -340,6 +795,11 @@ namespace Cell {
         }
 
         if (!result) {
+#ifdef CELL_ENABLE_BUDGET
+            if (budget_size > 0) {
+                refund_budget(budget_size, tag);
+            }
+#endif
             return nullptr;
         }
 
@@ -363,31 +823,45 @@ namespace Cell {
 #ifdef CELL_DEBUG_LEAKS
         // Track this allocation
         {
-            std::lock_guard<std::mutex> lock(m_debug_mutex);
             DebugAllocation alloc{};
             alloc.ptr = result;
             alloc.size = size;
             alloc.tag = tag;
 #ifdef CELL_DEBUG_STACKTRACE
-            alloc.stack_depth = capture_stack(alloc.stack, kMaxStackDepth, 2);
+            alloc.stack_id = capture_stack_id(2);
 #endif
-            m_live_allocs[result] = alloc;
+            m_live_allocs.insert(alloc);
         }
 #endif
 
 #ifdef CELL_ENABLE_BUDGET
         if (budget_size > 0) {
-            record_budget_alloc(budget_size);
+            set_block_tag(result, tag);
         }
 #endif
 
 #ifdef CELL_ENABLE_INSTRUMENTATION
-        invoke_alloc_callback(result, size, tag, true);
+        // Buddy and large results were reported by alloc_large()
+        if (size <= usable_cell_size) {
+            record_event(result, size, get_header(result, m_cell_mask)->size_class, tag, true);
+        }
 #endif
 
         return result;
     }
 
+#ifdef CELL_ENABLE_HEAP_PROFILER
+    void *Context::alloc_sampled(size_t size, uint8_t tag, size_t alignment) {
+        // The re-armed countdown absorbs the size alloc_bytes() charges again
+        bool record = m_heap_profiler.rearm(size);
+        void *result = alloc_bytes(size, tag, alignment);
+        if (record && result) {
+            m_heap_profiler.record_alloc(result, size);
+        }
+        return result;
+    }
+#endif
+
     // =========================================================================
     // Batch Allocation API (SIMD-optimized)
     // =========================================================================
@@ -397,9 +871,10 @@ namespace Cell {
             return 0;
         }
 
-        // Only sub-cell sizes benefit from TLS fast path
-        if (CELL_UNLIKELY(size > kMaxSubCellSize || !m_allocator)) {
-            // Fall back to individual allocations for large sizes
+        // Only sub-cell sizes benefit from TLS fast path; page guards decide per block
+        if (CELL_UNLIKELY(size > m_max_subcell_size || !m_allocator ||
+                          m_page_guard_active.load(std::memory_order_relaxed))) {
+            // Fall back to individual allocations
             size_t allocated = 0;
             for (size_t i = 0; i < count; ++i) {
                 void *ptr = alloc_bytes(size, tag);
@@ -414,9 +889,22 @@ namespace Cell {
         uint8_t bin_index = get_size_class_fast(size);
         size_t allocated = 0;
 
-#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS) && !defined(CELL_ENABLE_BUDGET)
+#ifdef CELL_ENABLE_BUDGET
+        // Charge the whole batch at once so the drain needs no per-block accounting.
+        // Near the limit, the slow path below charges block by block instead.
+        size_t block_size = kSizeClasses[bin_index];
+        bool batch_charged = charge_budget(block_size * count, tag, false);
+#endif
+
+#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS)
+#ifdef CELL_ENABLE_BUDGET
+        bool tls_drain = batch_charged && bin_index < m_tls_bin_count;
+#else
+        bool tls_drain = bin_index < m_tls_bin_count;
+#endif
         // SIMD-optimized TLS cache drain for supported bins
-        if (CELL_LIKELY(bin_index < kTlsBinCacheCount)) {
+        if (CELL_LIKELY(tls_drain)) {
+            claim_bin_cache();
             TlsBinCache &cache = t_bin_cache[bin_index];
 
             // Fast path: drain TLS cache in batches
@@ -464,28 +952,58 @@ namespace Cell {
                     batch_refill_tls_bin(bin_index, tag);
                 }
             }
-
-#ifdef CELL_ENABLE_STATS
-            m_stats.subcell_allocs.fetch_add(allocated, std::memory_order_relaxed);
-            for (size_t i = 0; i < allocated; ++i) {
-                m_stats.record_alloc(kSizeClasses[bin_index], tag);
-            }
-#endif
         }
 #endif
+#ifdef CELL_ENABLE_STATS
+        size_t tls_hits = allocated;
+#endif
 
         // Slow path: allocate remaining individually
         while (allocated < count) {
+#ifdef CELL_ENABLE_BUDGET
+            if (!batch_charged && !charge_budget(block_size, tag)) {
+                break;
+            }
+#endif
             void *ptr = alloc_from_bin(bin_index, tag);
-            if (!ptr)
+            if (!ptr) {
+#ifdef CELL_ENABLE_BUDGET
+                if (!batch_charged) {
+                    refund_budget(block_size, tag);
+                }
+#endif
                 break;
+            }
             out_ptrs[allocated++] = ptr;
+        }
+#ifdef CELL_ENABLE_BUDGET
+        if (batch_charged && allocated < count) {
+            refund_budget(block_size * (count - allocated), tag);
+        }
+        for (size_t i = 0; i < allocated; ++i) {
+            set_block_tag(out_ptrs[i], tag);
+        }
+#endif
 
 #ifdef CELL_ENABLE_STATS
-            m_stats.record_alloc(kSizeClasses[bin_index], tag);
-            m_stats.subcell_allocs.fetch_add(1, std::memory_order_relaxed);
+        // One update for the whole batch
+        if (allocated > 0) {
+            m_stats.record_subcell_alloc(size * allocated, bin_index, tag, allocated, tls_hits);
+        }
 #endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        for (size_t i = 0; i < allocated; ++i) {
+            record_event(out_ptrs[i], size, bin_index, tag, true);
+        }
+#endif
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        // Charge each block separately so batches sample like single allocations
+        for (size_t i = 0; i < allocated; ++i) {
+            if (heap_sample_tick(size) && m_heap_profiler.rearm(0)) {
+                m_heap_profiler.record_alloc(out_ptrs[i], size);
+            }
         }
+#endif
 
         return allocated;
     }
@@ -495,14 +1013,28 @@ namespace Cell {
             return;
         }
 
-#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS) && !defined(CELL_ENABLE_BUDGET)
+        if (CELL_UNLIKELY(m_page_guards.has_allocations())) {
+            // The batch may mix page-guarded and cell blocks
+            for (size_t i = 0; i < count; ++i) {
+                free_bytes(ptrs[i]);
+            }
+            return;
+        }
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        for (size_t i = 0; i < count; ++i) {
+            m_heap_profiler.record_free(ptrs[i]);
+        }
+#endif
+
+#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS)
         // Fast path: check if first pointer is in cell region
         auto uptr = reinterpret_cast<uintptr_t>(ptrs[0]);
         auto base = reinterpret_cast<uintptr_t>(m_base);
 
         if (CELL_LIKELY(uptr >= base && uptr < base + m_reserved_size)) {
             // Get size class from first pointer
-            CellHeader *first_header = get_header(ptrs[0]);
+            CellHeader *first_header = get_header(ptrs[0], m_cell_mask);
             uint8_t size_class = first_header->size_class;
 
 #ifndef NDEBUG
@@ -511,19 +1043,20 @@ namespace Cell {
                 auto iptr = reinterpret_cast<uintptr_t>(ptrs[i]);
                 assert(iptr >= base && iptr < base + m_reserved_size &&
                        "free_batch requires all pointers in cell region");
-                CellHeader *h = get_header(ptrs[i]);
+                CellHeader *h = get_header(ptrs[i], m_cell_mask);
                 assert(h->size_class == size_class &&
                        "free_batch requires all pointers to have same size class");
             }
 #endif
 
-            if (CELL_LIKELY(size_class < kTlsBinCacheCount)) {
+            if (CELL_LIKELY(size_class < m_tls_bin_count)) {
+                claim_bin_cache();
                 TlsBinCache &cache = t_bin_cache[size_class];
                 size_t freed = 0;
 
                 // SIMD-optimized TLS cache fill
-                while (freed < count && cache.count < kTlsBinCacheCapacity) {
-                    size_t space = kTlsBinCacheCapacity - cache.count;
+                while (freed < count && cache.count < m_tls_bin_capacity) {
+                    size_t space = m_tls_bin_capacity - cache.count;
                     size_t push = std::min(count - freed, space);
 
 #if defined(__AVX2__) && defined(__x86_64__)
@@ -557,7 +1090,25 @@ namespace Cell {
                 }
 
 #ifdef CELL_ENABLE_STATS
-                m_stats.subcell_frees.fetch_add(freed, std::memory_order_relaxed);
+                m_stats.record_free_count(StatsTier::kSubCell, freed);
+#endif
+#ifdef CELL_ENABLE_BUDGET
+                // One refund per run of blocks sharing a tag
+                for (size_t i = 0; i < freed;) {
+                    uint8_t tag = block_tag(ptrs[i]);
+                    size_t run = 1;
+                    while (i + run < freed && block_tag(ptrs[i + run]) == tag) {
+                        ++run;
+                    }
+                    refund_budget(kSizeClasses[size_class] * run, tag);
+                    i += run;
+                }
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+                for (size_t i = 0; i < freed; ++i) {
+                    record_event(ptrs[i], kSizeClasses[size_class], size_class,
+                                 get_header(ptrs[i], m_cell_mask)->tag, false);
+                }
 #endif
 
                 // Fall through to free remaining
@@ -585,33 +1136,28 @@ namespace Cell {
             return;
         }
 
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        m_heap_profiler.record_free(ptr);
+#endif
+
 #ifdef CELL_ENABLE_INSTRUMENTATION
-        // For instrumentation, we need the size before we lose it
-        // The callback will receive the originally requested size if available,
-        // otherwise 0 (for non-tracked tiers)
-        size_t callback_size = 0;
-        uint8_t callback_tag = 0;
+        // Free events report the caller's pointer with the size and tag from block metadata
+        void *event_ptr = ptr;
 #endif
 
 #ifdef CELL_DEBUG_LEAKS
-        // Remove from tracking and get allocation size
+#ifdef CELL_DEBUG_GUARDS
+        // Remove from tracking and get allocation size for the guard check
         size_t alloc_size = 0;
         {
-            std::lock_guard<std::mutex> lock(m_debug_mutex);
-            auto it = m_live_allocs.find(ptr);
-            if (it != m_live_allocs.end()) {
-                alloc_size = it->second.size;
-#ifdef CELL_ENABLE_INSTRUMENTATION
-                callback_size = it->second.size;
-                callback_tag = it->second.tag;
-#endif
-                m_live_allocs.erase(it);
+            DebugAllocation alloc;
+            if (m_live_allocs.erase(ptr, &alloc)) {
+                alloc_size = alloc.size;
             }
         }
+#else
+        m_live_allocs.erase(ptr);
 #endif
-
-#ifdef CELL_ENABLE_INSTRUMENTATION
-        invoke_alloc_callback(ptr, callback_size, callback_tag, false);
 #endif
 
         // Fast path: check if pointer is in cell region (most common case)
@@ -621,21 +1167,31 @@ namespace Cell {
 
         if (CELL_LIKELY(uptr >= base && uptr < base + m_reserved_size)) {
             // Cell/sub-cell allocation - this is the hot path
-#if !defined(CELL_DEBUG_GUARDS) && !defined(CELL_DEBUG_LEAKS) && !defined(CELL_ENABLE_BUDGET)
+#ifndef CELL_DEBUG_GUARDS
             // Ultra-fast path: inline TLS free for hot bins
-            CellHeader *header = get_header(ptr);
+            CellHeader *header = get_header(ptr, m_cell_mask);
             uint8_t size_class = header->size_class;
 
-            if (CELL_LIKELY(size_class < kTlsBinCacheCount)) {
+            if (CELL_LIKELY(size_class < m_tls_bin_count)) {
                 // Hot bin - try TLS cache first
+                claim_bin_cache();
                 TlsBinCache &cache = t_bin_cache[size_class];
-                if (CELL_LIKELY(cache.count < kTlsBinCacheCapacity)) {
+#ifdef CELL_ENABLE_BUDGET
+                bool room = cache.count < m_tls_bin_capacity &&
+                            give_budget_credit(kSizeClasses[size_class], block_tag(ptr));
+#else
+                bool room = cache.count < m_tls_bin_capacity;
+#endif
+                if (CELL_LIKELY(room)) {
 #ifndef NDEBUG
                     std::memset(ptr, kPoisonByte, kSizeClasses[size_class]);
 #endif
 #ifdef CELL_ENABLE_STATS
-                    m_stats.record_free(kSizeClasses[size_class], header->tag);
-                    m_stats.subcell_frees.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_free(kSizeClasses[size_class], header->tag,
+                                        StatsTier::kSubCell);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+                    record_event(ptr, kSizeClasses[size_class], size_class, header->tag, false);
 #endif
                     cache.blocks[cache.count++] = static_cast<FreeBlock *>(ptr);
                     return;
@@ -646,13 +1202,22 @@ namespace Cell {
             goto handle_cell_subcell;
         }
 
-        // Slower path: check buddy and large allocations
+        // Slower path: check page-guarded, buddy and large allocations
+        if (CELL_UNLIKELY(m_page_guards.has_allocations()) && m_page_guards.owns(ptr)) {
+            free_page_guarded(ptr);
+            return;
+        }
+
         if (m_buddy && m_buddy->owns(ptr)) {
 #ifdef CELL_ENABLE_STATS
-            m_stats.buddy_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free_count(StatsTier::kBuddy);
 #endif
 #ifdef CELL_ENABLE_BUDGET
-            record_budget_free(m_buddy->get_alloc_size(ptr));
+            record_budget_free(m_buddy->get_alloc_size(ptr), m_buddy->get_alloc_tag(ptr));
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+            record_event(ptr, m_buddy->get_alloc_size(ptr), kEventClassBuddy,
+                         m_buddy->get_alloc_tag(ptr), false);
 #endif
             m_buddy->free(ptr);
             return;
@@ -660,10 +1225,15 @@ namespace Cell {
 
         if (m_large_allocs.owns(ptr)) {
 #ifdef CELL_ENABLE_STATS
-            m_stats.large_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free_count(StatsTier::kLarge);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+            record_event(ptr, m_large_allocs.get_alloc_size(ptr), kEventClassLarge,
+                         m_large_allocs.get_alloc_tag(ptr), false);
 #endif
 #ifdef CELL_ENABLE_BUDGET
-            record_budget_free(m_large_allocs.get_alloc_size(ptr));
+            record_budget_free(m_large_allocs.get_alloc_size(ptr),
+                               m_large_allocs.get_alloc_tag(ptr));
 #endif
             m_large_allocs.free(ptr);
             return;
@@ -674,15 +1244,20 @@ namespace Cell {
 
     handle_cell_subcell:
 
+#ifdef CELL_ENABLE_BUDGET
+        // Recorded under the caller's pointer, before any guard adjustment
+        uint8_t budget_tag = block_tag(ptr);
+#endif
+
         // Must be cell/sub-cell allocation
         // For sub-cell (bin) allocations with small enough sizes, guards were applied
         // For full-cell allocations or large sub-cell allocations, no guards
 
 #if defined(CELL_DEBUG_GUARDS) && defined(CELL_DEBUG_LEAKS)
         // Determine if guards were applied based on allocation size
-        // Guards are only applied when: size + 2*kGuardSize <= kMaxSubCellSize
+        // Guards are only applied when: size + 2*kGuardSize <= m_max_subcell_size
         // Since alloc_size stores the original requested size, check that
-        bool has_guards = (alloc_size > 0 && (alloc_size + 2 * kGuardSize) <= kMaxSubCellSize);
+        bool has_guards = (alloc_size > 0 && (alloc_size + 2 * kGuardSize) <= m_max_subcell_size);
 
         if (has_guards) {
             auto *user_ptr = static_cast<uint8_t *>(ptr);
@@ -718,32 +1293,35 @@ namespace Cell {
         }
 #endif
 
-        CellHeader *header = get_header(ptr);
+        CellHeader *header = get_header(ptr, m_cell_mask);
 
 #ifdef CELL_ENABLE_STATS
         uint8_t tag = header->tag;
 #endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        record_event(event_ptr,
+                     header->size_class == kFullCellMarker ? m_cell_size
+                                                           : kSizeClasses[header->size_class],
+                     header->size_class, header->tag, false);
+#endif
 
         if (header->size_class == kFullCellMarker) {
             // Full-cell allocation
 #ifdef CELL_ENABLE_STATS
-            m_stats.record_free(kCellSize, tag);
-            m_stats.cell_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free(m_cell_size, tag, StatsTier::kCell);
 #endif
 #ifdef CELL_ENABLE_BUDGET
-            record_budget_free(kCellSize);
+            refund_budget(m_cell_size, budget_tag);
 #endif
             free_cell(reinterpret_cast<CellData *>(header));
         } else {
             // Sub-cell allocation
 #ifdef CELL_ENABLE_STATS
             size_t block_size = kSizeClasses[header->size_class];
-            m_stats.record_free(block_size, tag);
-            m_stats.subcell_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free(block_size, tag, StatsTier::kSubCell);
 #endif
 #ifdef CELL_ENABLE_BUDGET
-            size_t budget_block_size = kSizeClasses[header->size_class];
-            record_budget_free(budget_block_size);
+            refund_budget(kSizeClasses[header->size_class], budget_tag);
 #endif
             free_to_bin(ptr, header);
         }
@@ -761,46 +1339,49 @@ namespace Cell {
             return nullptr;
         }
 
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        // A sampled block leaves the profile; only a moving realloc can be sampled again
+        m_heap_profiler.record_free(ptr);
+#endif
+
+        // Page-guarded blocks always move, so the new block gets its own guard decision
+        if (CELL_UNLIKELY(m_page_guards.has_allocations()) && m_page_guards.owns(ptr)) {
+            void *new_ptr = alloc_bytes(new_size, tag);
+            if (!new_ptr) {
+                return nullptr;
+            }
+            std::memcpy(new_ptr, ptr, std::min(m_page_guards.get_alloc_size(ptr), new_size));
+            free_bytes(ptr);
+            return new_ptr;
+        }
+
         // Check buddy tier first
         if (m_buddy && m_buddy->owns(ptr)) {
             // For buddy allocations, check if new size still fits in buddy range
-            if (new_size <= BuddyAllocator::kMaxBlockSize &&
-                new_size >= BuddyAllocator::kMinBlockSize) {
+            if (fits_buddy(new_size) && new_size >= BuddyAllocator::kMinBlockSize) {
                 // Stay in buddy tier - delegate to buddy realloc
                 // Note: buddy realloc doesn't know about leak tracking, so we handle it here
 #ifdef CELL_DEBUG_LEAKS
-                size_t old_alloc_size = 0;
-                {
-                    std::lock_guard<std::mutex> lock(m_debug_mutex);
-                    auto it = m_live_allocs.find(ptr);
-                    if (it != m_live_allocs.end()) {
-                        old_alloc_size = it->second.size;
-                        m_live_allocs.erase(it);
-                    }
-                }
+                m_live_allocs.erase(ptr);
 #endif
                 void *result = m_buddy->realloc_bytes(ptr, new_size);
 #ifdef CELL_DEBUG_LEAKS
                 if (result) {
-                    std::lock_guard<std::mutex> lock(m_debug_mutex);
                     DebugAllocation alloc{};
                     alloc.ptr = result;
                     alloc.size = new_size;
                     alloc.tag = tag;
 #ifdef CELL_DEBUG_STACKTRACE
-                    alloc.stack_depth = capture_stack(alloc.stack, kMaxStackDepth, 2);
+                    alloc.stack_id = capture_stack_id(2);
 #endif
-                    m_live_allocs[result] = alloc;
+                    m_live_allocs.insert(alloc);
                 }
 #endif
                 return result;
             }
             // Cross-tier: buddy -> somewhere else
 #ifdef CELL_DEBUG_LEAKS
-            {
-                std::lock_guard<std::mutex> lock(m_debug_mutex);
-                m_live_allocs.erase(ptr);
-            }
+            m_live_allocs.erase(ptr);
 #endif
             void *new_ptr = alloc_bytes(new_size, tag);
             if (!new_ptr)
@@ -815,39 +1396,29 @@ namespace Cell {
         // Check large tier
         if (m_large_allocs.owns(ptr)) {
             // For large allocations, check if new size still needs large
-            if (new_size > BuddyAllocator::kMaxBlockSize) {
+            if (!fits_buddy(new_size)) {
                 // Stay in large tier
 #ifdef CELL_DEBUG_LEAKS
-                {
-                    std::lock_guard<std::mutex> lock(m_debug_mutex);
-                    auto it = m_live_allocs.find(ptr);
-                    if (it != m_live_allocs.end()) {
-                        m_live_allocs.erase(it);
-                    }
-                }
+                m_live_allocs.erase(ptr);
 #endif
                 void *result = m_large_allocs.realloc_bytes(ptr, new_size, tag);
 #ifdef CELL_DEBUG_LEAKS
                 if (result) {
-                    std::lock_guard<std::mutex> lock(m_debug_mutex);
                     DebugAllocation alloc{};
                     alloc.ptr = result;
                     alloc.size = new_size;
                     alloc.tag = tag;
 #ifdef CELL_DEBUG_STACKTRACE
-                    alloc.stack_depth = capture_stack(alloc.stack, kMaxStackDepth, 2);
+                    alloc.stack_id = capture_stack_id(2);
 #endif
-                    m_live_allocs[result] = alloc;
+                    m_live_allocs.insert(alloc);
                 }
 #endif
                 return result;
             }
             // Cross-tier: large -> smaller tier
 #ifdef CELL_DEBUG_LEAKS
-            {
-                std::lock_guard<std::mutex> lock(m_debug_mutex);
-                m_live_allocs.erase(ptr);
-            }
+            m_live_allocs.erase(ptr);
 #endif
             void *new_ptr = alloc_bytes(new_size, tag);
             if (!new_ptr)
@@ -860,12 +1431,12 @@ namespace Cell {
         }
 
         // Must be cell/sub-cell allocation
-        CellHeader *header = get_header(ptr);
+        CellHeader *header = get_header(ptr, m_cell_mask);
         size_t old_size;
 
         if (header->size_class == kFullCellMarker) {
             // Full cell allocation
-            old_size = kCellSize - kBlockStartOffset;
+            old_size = m_cell_size - kBlockStartOffset;
         } else {
             // Sub-cell allocation
             old_size = kSizeClasses[header->size_class];
@@ -874,7 +1445,7 @@ namespace Cell {
             // Must account for guards if enabled, to match what alloc_bytes does
 #ifdef CELL_DEBUG_GUARDS
             size_t alloc_size = new_size;
-            if (new_size + (2 * kGuardSize) <= kMaxSubCellSize) {
+            if (new_size <= m_max_subcell_size - (2 * kGuardSize)) {
                 alloc_size = new_size + (2 * kGuardSize);
             }
             uint8_t new_bin = get_size_class(alloc_size, 8);
@@ -902,6 +1473,21 @@ namespace Cell {
     // Large Allocation API
     // =========================================================================
 
+    bool Context::fits_buddy(size_t size) const {
+        return m_buddy && m_buddy->block_size_for(size) != 0;
+    }
+
+    bool Context::fits_aligned_bin(size_t size, size_t alignment) const {
+#ifdef CELL_DEBUG_GUARDS
+        // The front guard moves user pointers kGuardSize bytes past the block
+        if (alignment > kGuardSize) {
+            return false;
+        }
+#endif
+        return m_allocator && size <= m_max_subcell_size && alignment <= m_max_subcell_size &&
+               align_up(size, alignment) <= m_max_subcell_size;
+    }
+
     void *Context::alloc_large(size_t size, uint8_t tag, bool try_huge_pages) {
         if (size == 0) {
             return nullptr;
@@ -911,75 +1497,61 @@ namespace Cell {
 
 #ifdef CELL_ENABLE_BUDGET
         // Calculate budget size upfront for check_budget
-        // Buddy allocations round to power-of-2 including 8-byte header
+        // Buddy allocations round to power-of-2 including the block header
         // Large allocations get page-rounded sizes
         size_t budget_size = 0;
-        if (size <= BuddyAllocator::kMaxBlockSize && m_buddy) {
-            // Calculate buddy rounded size (power-of-2 >= size + 8 byte header)
-            size_t total = size + 8; // header
-            if (total < BuddyAllocator::kMinBlockSize) {
-                budget_size = BuddyAllocator::kMinBlockSize;
-            } else {
-                // O(1) power-of-2 rounding using bit manipulation
-                budget_size = next_power_of_2(total);
-                if (budget_size > BuddyAllocator::kMaxBlockSize) {
-                    budget_size = BuddyAllocator::kMaxBlockSize;
-                }
-            }
+        if (fits_buddy(size)) {
+            budget_size = m_buddy->block_size_for(size);
         } else {
-            // Large allocation - page-aligned, approximate as requested size
-            // (record_budget_alloc will use get_alloc_size for actual)
-            budget_size = size;
+            // Large allocation - page-rounded, matches get_alloc_size()
+            budget_size = LargeAllocRegistry::rounded_size(size);
         }
 
-        if (!check_budget(budget_size)) {
+        if (!check_budget(budget_size, tag)) {
             return nullptr;
         }
 #endif
 
-        // Route: <= 2MB to buddy, > 2MB to direct OS
-        if (size <= BuddyAllocator::kMaxBlockSize) {
-            if (m_buddy) {
-                result = m_buddy->alloc(size);
+        // Route: fits the buddy max order -> buddy, larger -> direct OS
+        if (fits_buddy(size)) {
+            {
+                result = m_buddy->alloc(size, tag);
 #ifdef CELL_ENABLE_STATS
                 if (result) {
                     // Buddy rounds up to power-of-2
-                    m_stats.record_alloc(size, tag);
-                    m_stats.buddy_allocs.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_alloc(size, tag, StatsTier::kBuddy);
                 }
 #endif
 #ifdef CELL_ENABLE_INSTRUMENTATION
                 if (result) {
-                    invoke_alloc_callback(result, size, tag, true);
+                    record_event(result, size, kEventClassBuddy, tag, true);
                 }
 #endif
 #ifdef CELL_ENABLE_BUDGET
                 if (result) {
                     // Use actual rounded size for budget
-                    record_budget_alloc(m_buddy->get_alloc_size(result));
+                    record_budget_alloc(m_buddy->get_alloc_size(result), tag);
                 }
 #endif
                 return result;
             }
-            // Fallback to large alloc if buddy not initialized
         }
 
-        // Direct OS allocation for > 2MB
+        // Direct OS allocation above the buddy max block size
         result = m_large_allocs.alloc(size, tag, try_huge_pages);
 #ifdef CELL_ENABLE_STATS
         if (result) {
-            m_stats.record_alloc(size, tag);
-            m_stats.large_allocs.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_alloc(size, tag, StatsTier::kLarge);
         }
 #endif
 #ifdef CELL_ENABLE_INSTRUMENTATION
         if (result) {
-            invoke_alloc_callback(result, size, tag, true);
+            record_event(result, size, kEventClassLarge, tag, true);
         }
 #endif
 #ifdef CELL_ENABLE_BUDGET
         if (result) {
-            record_budget_alloc(m_large_allocs.get_alloc_size(result));
+            record_budget_alloc(m_large_allocs.get_alloc_size(result), tag);
         }
 #endif
         return result;
@@ -989,25 +1561,41 @@ namespace Cell {
         if (!ptr)
             return;
 
-#ifdef CELL_ENABLE_INSTRUMENTATION
-        // Get size before freeing for callback
-        size_t freed_size = 0;
-        if (m_buddy && m_buddy->owns(ptr)) {
-            freed_size = m_buddy->get_alloc_size(ptr);
-        } else {
-            freed_size = m_large_allocs.get_alloc_size(ptr);
-        }
-        invoke_alloc_callback(ptr, freed_size, 0, false);
+#ifdef CELL_ENABLE_HEAP_PROFILER
+        m_heap_profiler.record_free(ptr);
 #endif
 
+        if (CELL_UNLIKELY(m_page_guards.has_allocations()) && m_page_guards.owns(ptr)) {
+#ifdef CELL_DEBUG_LEAKS
+            m_live_allocs.erase(ptr);
+#endif
+            free_page_guarded(ptr);
+            return;
+        }
+
         if (m_buddy && m_buddy->owns(ptr)) {
 #ifdef CELL_ENABLE_STATS
-            m_stats.buddy_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free_count(StatsTier::kBuddy);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+            record_event(ptr, m_buddy->get_alloc_size(ptr), kEventClassBuddy,
+                         m_buddy->get_alloc_tag(ptr), false);
+#endif
+#ifdef CELL_ENABLE_BUDGET
+            record_budget_free(m_buddy->get_alloc_size(ptr), m_buddy->get_alloc_tag(ptr));
 #endif
             m_buddy->free(ptr);
         } else {
 #ifdef CELL_ENABLE_STATS
-            m_stats.large_frees.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_free_count(StatsTier::kLarge);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+            record_event(ptr, m_large_allocs.get_alloc_size(ptr), kEventClassLarge,
+                         m_large_allocs.get_alloc_tag(ptr), false);
+#endif
+#ifdef CELL_ENABLE_BUDGET
+            record_budget_free(m_large_allocs.get_alloc_size(ptr),
+                               m_large_allocs.get_alloc_tag(ptr));
 #endif
             m_large_allocs.free(ptr);
         }
@@ -1023,47 +1611,38 @@ namespace Cell {
             return nullptr;
         }
 
+        // Sub-cell blocks are aligned to their size class and cell payloads to
+        // 16 bytes, so small requests never need a dedicated OS mapping
+        if (alignment <= 16 ? m_allocator && size <= m_cell_size - kBlockStartOffset
+                            : fits_aligned_bin(size, alignment)) {
+            return alloc_bytes(size, tag, alignment);
+        }
+
+        // alloc_bytes() made the page-guard decision for the requests above
+        if (CELL_UNLIKELY(m_page_guard_active.load(std::memory_order_relaxed)) &&
+            alignment <= LargeAllocRegistry::rounded_size(1) && should_page_guard(tag)) {
+            return alloc_page_guarded(size, tag, alignment);
+        }
+
 #ifdef CELL_ENABLE_BUDGET
         // Calculate budget size upfront for check_budget
         // Similar logic to alloc_large: buddy rounds to power-of-2, large is page-aligned
         size_t budget_size = 0;
-        if (size <= BuddyAllocator::kMaxBlockSize && m_buddy && alignment <= 8) {
-            // Will use buddy path - calculate power-of-2 rounded size
-            size_t total = size + 8; // header
-            if (total < BuddyAllocator::kMinBlockSize) {
-                budget_size = BuddyAllocator::kMinBlockSize;
-            } else {
-                // O(1) power-of-2 rounding using bit manipulation
-                budget_size = next_power_of_2(total);
-                if (budget_size > BuddyAllocator::kMaxBlockSize) {
-                    budget_size = BuddyAllocator::kMaxBlockSize;
-                }
-            }
+        if (fits_buddy(size) && alignment <= 8) {
+            // Will use buddy path - power-of-2 rounded size including header
+            budget_size = m_buddy->block_size_for(size);
         } else {
-            // Will use large allocation path - approximate as requested size
-            budget_size = size;
+            // Will use large allocation path - page-rounded, matches get_alloc_size()
+            budget_size = LargeAllocRegistry::rounded_size(size);
         }
 
-        if (!check_budget(budget_size)) {
+        if (!check_budget(budget_size, tag)) {
             return nullptr;
         }
 #endif
 
         // For buddy allocations: check if natural power-of-2 alignment is sufficient
-        if (size <= BuddyAllocator::kMaxBlockSize && m_buddy) {
-            // Calculate the order (and thus natural alignment) for this size
-            // Account for buddy header (8 bytes)
-            size_t total_size = size + 8;
-            if (total_size < BuddyAllocator::kMinBlockSize) {
-                total_size = BuddyAllocator::kMinBlockSize;
-            }
-
-            // O(1) power-of-2 rounding for block size
-            size_t block_size = next_power_of_2(total_size);
-            if (block_size > BuddyAllocator::kMaxBlockSize) {
-                block_size = BuddyAllocator::kMaxBlockSize;
-            }
-
+        if (fits_buddy(size)) {
             // Buddy blocks are naturally aligned to their size.
             // The user pointer is offset by 8 bytes (header), so actual alignment
             // is min(block_size, block_alignment_after_8_byte_offset).
@@ -1075,21 +1654,20 @@ namespace Cell {
             // Buddy user pointers are offset by 8-byte header from block start.
             // Only 8-byte alignment is guaranteed regardless of block size.
             if (alignment <= 8) {
-                void *result = m_buddy->alloc(size);
+                void *result = m_buddy->alloc(size, tag);
 #ifdef CELL_ENABLE_STATS
                 if (result) {
-                    m_stats.record_alloc(size, tag);
-                    m_stats.buddy_allocs.fetch_add(1, std::memory_order_relaxed);
+                    m_stats.record_alloc(size, tag, StatsTier::kBuddy);
                 }
 #endif
 #ifdef CELL_ENABLE_INSTRUMENTATION
                 if (result) {
-                    invoke_alloc_callback(result, size, tag, true);
+                    record_event(result, size, kEventClassBuddy, tag, true);
                 }
 #endif
 #ifdef CELL_ENABLE_BUDGET
                 if (result) {
-                    record_budget_alloc(m_buddy->get_alloc_size(result));
+                    record_budget_alloc(m_buddy->get_alloc_size(result), tag);
                 }
 #endif
                 return result;
@@ -1098,23 +1676,24 @@ namespace Cell {
         }
 
         // Use LargeAllocRegistry for:
-        // - Sizes > 2MB
-        // - Alignments exceeding buddy's natural block alignment
+        // - Sizes above the buddy max block size
+        // - Alignments beyond the bins' that exceed buddy's 8-byte alignment
+        // The registry serves these from dedicated OS mappings (over-reserved and
+        // trimmed to the alignment), never from the system heap.
         void *result = m_large_allocs.alloc_aligned(size, alignment, tag);
 #ifdef CELL_ENABLE_STATS
         if (result) {
-            m_stats.record_alloc(size, tag);
-            m_stats.large_allocs.fetch_add(1, std::memory_order_relaxed);
+            m_stats.record_alloc(size, tag, StatsTier::kLarge);
         }
 #endif
 #ifdef CELL_ENABLE_INSTRUMENTATION
         if (result) {
-            invoke_alloc_callback(result, size, tag, true);
+            record_event(result, size, kEventClassLarge, tag, true);
         }
 #endif
 #ifdef CELL_ENABLE_BUDGET
         if (result) {
-            record_budget_alloc(m_large_allocs.get_alloc_size(result));
+            record_budget_alloc(m_large_allocs.get_alloc_size(result), tag);
         }
 #endif
         return result;
@@ -1151,6 +1730,58 @@ namespace Cell {
     // Memory Management API
     // =========================================================================
 
+    size_t Context::prewarm(size_t bytes_per_tier, std::initializer_list<size_t> block_sizes) {
+        size_t total = 0;
+
+        if (m_allocator) {
+            total += m_allocator->prewarm(bytes_per_tier);
+        }
+        if (m_buddy) {
+            total += m_buddy->prewarm(bytes_per_tier);
+        }
+
+        // Carve a cell for each chosen bin that has nothing to allocate from
+        uint32_t mask = bin_mask_for(block_sizes);
+        for (size_t bin_index = 0; m_allocator && bin_index < m_num_bins; ++bin_index) {
+            if ((mask & (1u << bin_index)) == 0) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock = lock_bin(bin_index);
+            SizeBin &bin = m_bins[bin_index];
+            if (bin.partial_head) {
+                continue;
+            }
+
+            void *raw_cell = m_allocator->alloc();
+            if (!raw_cell) {
+                break;
+            }
+            init_cell_for_bin(raw_cell, bin_index, 0);
+            bin.partial_head = static_cast<CellHeader *>(raw_cell);
+            bin.warm_cell_count++;
+        }
+
+        return total;
+    }
+
+    void Context::warm_thread(std::initializer_list<size_t> block_sizes) {
+        if (!m_allocator) {
+            return;
+        }
+
+        uint32_t mask = bin_mask_for(block_sizes);
+        claim_bin_cache();
+        for (size_t bin_index = 0; bin_index < m_tls_bin_count; ++bin_index) {
+            if ((mask & (1u << bin_index)) != 0 && t_bin_cache[bin_index].is_empty()) {
+                batch_refill_tls_bin(bin_index, 0);
+            }
+        }
+
+        // Load cells last, so carving bin cells above does not drain them
+        m_allocator->warm_tls_cache();
+    }
+
     size_t Context::decommit_unused() {
         size_t total = 0;
 
@@ -1163,24 +1794,164 @@ namespace Cell {
         return total;
     }
 
+    size_t Context::trim(PressureLevel level) {
+        if (level == PressureLevel::kNone || !m_allocator) {
+            return 0;
+        }
+
+        // Return this thread's cached blocks first so their cells can empty
+        flush_tls_caches();
+
+        // Hand every empty bin cell back to the cell allocator
+        for (size_t bin_index = 0; bin_index < m_num_bins; ++bin_index) {
+            std::unique_lock<std::mutex> lock = lock_bin(bin_index);
+            SizeBin &bin = m_bins[bin_index];
+            size_t max_blocks = m_blocks_per_cell[bin_index];
+
+            CellHeader **pp = &bin.partial_head;
+            while (*pp) {
+                CellHeader *header = *pp;
+                CellMetadata *metadata = get_metadata(header);
+                if (header->free_count == max_blocks) {
+                    *pp = reinterpret_cast<CellHeader *>(metadata->next_partial);
+                    metadata->next_partial = nullptr;
+                    m_allocator->free(header);
+#ifdef CELL_ENABLE_STATS
+                    m_stats.record_bin_event(bin_index, BinEvent::kCellReturned);
+#endif
+                } else {
+                    pp = reinterpret_cast<CellHeader **>(&metadata->next_partial);
+                }
+            }
+            bin.warm_cell_count = 0;
+        }
+
+        // decommit_unused() also flushes the cells freed above from the TLS cache
+        size_t retained = level == PressureLevel::kCritical ? 0 : kRetainedCellMagazines;
+        return m_allocator->decommit_unused(retained);
+    }
+
     size_t Context::committed_bytes() const {
         size_t total = 0;
         if (m_allocator) {
             total += m_allocator->committed_bytes();
         }
-        // Could add buddy allocator committed bytes here
+        if (m_buddy) {
+            total += m_buddy->bytes_committed();
+        }
+        total += m_large_allocs.bytes_allocated();
         return total;
     }
 
+    // =========================================================================
+    // Page Guards
+    // =========================================================================
+
+    void Context::set_page_guard_tag(uint8_t tag, bool enabled) {
+        std::lock_guard<std::mutex> lock(m_page_guard_config_lock);
+        m_page_guard_tags[tag].store(enabled, std::memory_order_relaxed);
+        update_page_guard_active();
+    }
+
+    void Context::set_page_guard_sample_rate(size_t one_in) {
+        std::lock_guard<std::mutex> lock(m_page_guard_config_lock);
+        m_page_guard_sample_rate.store(one_in, std::memory_order_relaxed);
+        update_page_guard_active();
+    }
+
+    void Context::update_page_guard_active() {
+        bool active = m_page_guard_sample_rate.load(std::memory_order_relaxed) != 0;
+        for (size_t tag = 0; tag < 256 && !active; ++tag) {
+            active = m_page_guard_tags[tag].load(std::memory_order_relaxed);
+        }
+        m_page_guard_active.store(active, std::memory_order_relaxed);
+    }
+
+    bool Context::should_page_guard(uint8_t tag) {
+        if (m_page_guard_tags[tag].load(std::memory_order_relaxed)) {
+            return true;
+        }
+        size_t rate = m_page_guard_sample_rate.load(std::memory_order_relaxed);
+        if (rate == 0) {
+            return false;
+        }
+        size_t &countdown = t_page_guard_countdown;
+        if (countdown == 0 || countdown > rate) {
+            countdown = rate;
+        }
+        return --countdown == 0;
+    }
+
+    void *Context::alloc_page_guarded(size_t size, uint8_t tag, size_t alignment) {
+#ifdef CELL_ENABLE_BUDGET
+        size_t budget_size = PageGuardRegistry::mapping_size_for(size);
+        if (!check_budget(budget_size, tag)) {
+            return nullptr;
+        }
+#endif
+        void *result = m_page_guards.alloc(size, alignment, tag);
+        if (!result) {
+            return nullptr;
+        }
+#ifdef CELL_ENABLE_BUDGET
+        record_budget_alloc(budget_size, tag);
+#endif
+#ifdef CELL_ENABLE_STATS
+        m_stats.record_alloc(size, tag, StatsTier::kLarge);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        record_event(result, size, kEventClassLarge, tag, true);
+#endif
+#ifdef CELL_DEBUG_LEAKS
+        DebugAllocation alloc{};
+        alloc.ptr = result;
+        alloc.size = size;
+        alloc.tag = tag;
+#ifdef CELL_DEBUG_STACKTRACE
+        alloc.stack_id = capture_stack_id(2);
+#endif
+        m_live_allocs.insert(alloc);
+#endif
+        return result;
+    }
+
+    void Context::free_page_guarded(void *ptr) {
+#ifdef CELL_ENABLE_STATS
+        m_stats.record_free_count(StatsTier::kLarge);
+#endif
+#ifdef CELL_ENABLE_INSTRUMENTATION
+        record_event(ptr, m_page_guards.get_alloc_size(ptr), kEventClassLarge,
+                     m_page_guards.get_alloc_tag(ptr), false);
+#endif
+#ifdef CELL_ENABLE_BUDGET
+        record_budget_free(m_page_guards.get_mapping_size(ptr), m_page_guards.get_alloc_tag(ptr));
+#endif
+        m_page_guards.free(ptr);
+    }
+
     // =========================================================================
     // Sub-Cell Implementation
     // =========================================================================
 
+    std::unique_lock<std::mutex> Context::lock_bin(size_t bin_index) {
+#ifdef CELL_ENABLE_STATS
+        std::unique_lock<std::mutex> lock(m_bin_locks[bin_index], std::try_to_lock);
+        if (!lock.owns_lock()) {
+            m_stats.record_bin_event(bin_index, BinEvent::kLockContended);
+            lock.lock();
+        }
+        return lock;
+#else
+        return std::unique_lock<std::mutex>(m_bin_locks[bin_index]);
+#endif
+    }
+
     void *Context::alloc_from_bin(size_t bin_index, uint8_t tag) {
         assert(bin_index < kNumSizeBins);
 
         // TLS fast path for hot bins (0-3: 16B, 32B, 64B, 128B)
-        if (bin_index < kTlsBinCacheCount) {
+        if (bin_index < m_tls_bin_count) {
+            claim_bin_cache();
             TlsBinCache &cache = t_bin_cache[bin_index];
 
             // Try TLS cache first (no lock)
@@ -1196,7 +1967,7 @@ namespace Cell {
         }
 
         // Fallback: lock-based allocation from global bin
-        std::lock_guard<std::mutex> lock(m_bin_locks[bin_index]);
+        std::unique_lock<std::mutex> lock = lock_bin(bin_index);
         SizeBin &bin = m_bins[bin_index];
 
         // Try to allocate from a partial cell
@@ -1204,6 +1975,12 @@ namespace Cell {
             CellHeader *cell_header = bin.partial_head;
             CellMetadata *metadata = get_metadata(cell_header);
 
+            // An empty partial cell is a warm cell going back into use
+            if (cell_header->free_count == m_blocks_per_cell[bin_index] &&
+                bin.warm_cell_count > 0) {
+                bin.warm_cell_count--;
+            }
+
             // Pop a block from the free list
             FreeBlock *block = metadata->free_list;
             assert(block && "Partial cell should have free blocks");
@@ -1265,16 +2042,17 @@ namespace Cell {
 #endif
 
         // TLS fast path for hot bins (0-3: 16B, 32B, 64B, 128B)
-        if (CELL_LIKELY(bin_index < kTlsBinCacheCount)) {
+        if (CELL_LIKELY(bin_index < m_tls_bin_count)) {
+            claim_bin_cache();
             TlsBinCache &cache = t_bin_cache[bin_index];
-            if (CELL_LIKELY(cache.count < kTlsBinCacheCapacity)) {
+            if (CELL_LIKELY(cache.count < m_tls_bin_capacity)) {
                 cache.blocks[cache.count++] = static_cast<FreeBlock *>(ptr);
                 return;
             }
         }
 
         // Fallback: lock-based free to global bin
-        std::lock_guard<std::mutex> lock(m_bin_locks[bin_index]);
+        std::unique_lock<std::mutex> lock = lock_bin(bin_index);
         SizeBin &bin = m_bins[bin_index];
         CellMetadata *metadata = get_metadata(header);
 
@@ -1291,12 +2069,12 @@ namespace Cell {
         bin.current_allocated--;
 
         // Calculate max blocks for this bin
-        size_t max_blocks = blocks_per_cell(bin_index);
+        size_t max_blocks = m_blocks_per_cell[bin_index];
 
         // If cell is now completely empty
         if (header->free_count == max_blocks) {
             // Warm reserve policy: keep a few empty cells per bin
-            if (bin.warm_cell_count < kWarmCellsPerBin) {
+            if (bin.warm_cell_count < m_warm_cells_per_bin) {
                 // Keep as warm reserve, stays in partial list
                 bin.warm_cell_count++;
                 if (was_full) {
@@ -1318,6 +2096,9 @@ namespace Cell {
 
                 // Return to allocator
                 m_allocator->free(header);
+#ifdef CELL_ENABLE_STATS
+                m_stats.record_bin_event(bin_index, BinEvent::kCellReturned);
+#endif
             }
         } else if (was_full) {
             // Cell was full, now has space - add to partial list
@@ -1331,6 +2112,10 @@ namespace Cell {
         auto *header = static_cast<CellHeader *>(cell);
         CellMetadata *metadata = get_metadata(header);
 
+#ifdef CELL_ENABLE_STATS
+        m_stats.record_bin_event(bin_index, BinEvent::kCellCarved);
+#endif
+
         // Set up header
         header->tag = tag;
         header->size_class = static_cast<uint8_t>(bin_index);
@@ -1342,7 +2127,7 @@ namespace Cell {
 
         // Calculate block layout
         size_t block_size = kSizeClasses[bin_index];
-        size_t num_blocks = blocks_per_cell(bin_index);
+        size_t num_blocks = m_blocks_per_cell[bin_index];
         header->free_count = static_cast<uint16_t>(num_blocks);
 
         // Initialize metadata
@@ -1350,7 +2135,7 @@ namespace Cell {
         metadata->free_list = nullptr;
 
         // Build free list (all blocks are free initially)
-        char *block_start = static_cast<char *>(get_block_start(header));
+        char *block_start = reinterpret_cast<char *>(header) + bin_block_offset(bin_index);
         FreeBlock *prev = nullptr;
 
         for (size_t i = num_blocks; i > 0; --i) {
@@ -1362,21 +2147,48 @@ namespace Cell {
         metadata->free_list = prev;
     }
 
+    uint32_t Context::bin_mask_for(std::initializer_list<size_t> block_sizes) {
+        static_assert(kNumSizeBins <= 32, "Bin mask must fit in 32 bits");
+
+        if (block_sizes.size() == 0) {
+            return (kNumSizeBins == 32) ? ~0u : (1u << kNumSizeBins) - 1;
+        }
+
+        uint32_t mask = 0;
+        for (size_t size : block_sizes) {
+            uint8_t bin_index = get_size_class(size, 8);
+            if (bin_index < kNumSizeBins) {
+                mask |= 1u << bin_index;
+            }
+        }
+        return mask;
+    }
+
     void Context::batch_refill_tls_bin(size_t bin_index, uint8_t tag) {
-        assert(bin_index < kTlsBinCacheCount);
+        assert(bin_index < m_tls_bin_count);
+        assert(t_bin_cache_owner == this && "Caller claims the bin cache");
 
         TlsBinCache &cache = t_bin_cache[bin_index];
-        size_t to_refill = kTlsBinBatchRefill;
+        size_t to_refill = m_tls_bin_refill;
 
-        std::lock_guard<std::mutex> lock(m_bin_locks[bin_index]);
+        std::unique_lock<std::mutex> lock = lock_bin(bin_index);
         SizeBin &bin = m_bins[bin_index];
 
+#ifdef CELL_ENABLE_STATS
+        m_stats.record_bin_event(bin_index, BinEvent::kRefillBatch);
+#endif
+
         // Try to get blocks from partial cells
-        while (to_refill > 0 && !cache.is_full() && bin.partial_head) {
+        while (to_refill > 0 && !cache.is_full(m_tls_bin_capacity) && bin.partial_head) {
             CellHeader *cell_header = bin.partial_head;
             CellMetadata *metadata = get_metadata(cell_header);
 
-            while (to_refill > 0 && !cache.is_full() && metadata->free_list) {
+            if (cell_header->free_count == m_blocks_per_cell[bin_index] &&
+                bin.warm_cell_count > 0) {
+                bin.warm_cell_count--;
+            }
+
+            while (to_refill > 0 && !cache.is_full(m_tls_bin_capacity) && metadata->free_list) {
                 FreeBlock *block = metadata->free_list;
                 metadata->free_list = block->next;
                 cell_header->free_count--;
@@ -1395,7 +2207,7 @@ namespace Cell {
         }
 
         // If we still need more blocks, allocate a fresh cell
-        if (to_refill > 0 && !cache.is_full()) {
+        if (to_refill > 0 && !cache.is_full(m_tls_bin_capacity)) {
             void *raw_cell = m_allocator->alloc();
             if (raw_cell) {
                 init_cell_for_bin(raw_cell, bin_index, tag);
@@ -1404,7 +2216,7 @@ namespace Cell {
                 CellMetadata *metadata = get_metadata(cell_header);
 
                 // Take blocks from the new cell
-                while (to_refill > 0 && !cache.is_full() && metadata->free_list) {
+                while (to_refill > 0 && !cache.is_full(m_tls_bin_capacity) && metadata->free_list) {
                     FreeBlock *block = metadata->free_list;
                     metadata->free_list = block->next;
                     cell_header->free_count--;
@@ -1424,16 +2236,44 @@ namespace Cell {
         }
     }
 
+    void Context::take_bin_cache() {
+        // Another Context's blocks: give them back to its bins before this
+        // Context's cell mask is applied to them
+        if (t_bin_cache_owner) {
+            t_bin_cache_owner->flush_bin_cache();
+        }
+        t_bin_cache_owner = this;
+    }
+
     void Context::flush_tls_caches() {
+        if (t_bin_cache_owner == this) {
+            flush_bin_cache();
+            t_bin_cache_owner = nullptr;
+        }
+
+        // Also flush the cell-level TLS cache
+        if (m_allocator) {
+            m_allocator->flush_tls_cache();
+        }
+
+#ifdef CELL_ENABLE_BUDGET
+        // Return this thread's unspent budget credit
+        if (t_budget_credit.context_id == m_context_id) {
+            release_budget_credit(*t_budget_credit.credit);
+        }
+#endif
+    }
+
+    void Context::flush_bin_cache() {
         for (size_t bin_index = 0; bin_index < kTlsBinCacheCount; ++bin_index) {
             TlsBinCache &cache = t_bin_cache[bin_index];
 
             while (!cache.is_empty()) {
                 FreeBlock *block = cache.pop();
-                CellHeader *header = get_header(block);
+                CellHeader *header = get_header(block, m_cell_mask);
 
                 // Use the lock-based path for proper cell management
-                std::lock_guard<std::mutex> lock(m_bin_locks[bin_index]);
+                std::unique_lock<std::mutex> lock = lock_bin(bin_index);
                 SizeBin &bin = m_bins[bin_index];
                 CellMetadata *metadata = get_metadata(header);
 
@@ -1445,10 +2285,10 @@ namespace Cell {
 
                 bin.current_allocated--;
 
-                size_t max_blocks = blocks_per_cell(bin_index);
+                size_t max_blocks = m_blocks_per_cell[bin_index];
 
                 if (header->free_count == max_blocks) {
-                    if (bin.warm_cell_count < kWarmCellsPerBin) {
+                    if (bin.warm_cell_count < m_warm_cells_per_bin) {
                         bin.warm_cell_count++;
                         if (was_full) {
                             metadata->next_partial =
@@ -1465,6 +2305,9 @@ namespace Cell {
                         }
                         metadata->next_partial = nullptr;
                         m_allocator->free(header);
+#ifdef CELL_ENABLE_STATS
+                        m_stats.record_bin_event(bin_index, BinEvent::kCellReturned);
+#endif
                     }
                 } else if (was_full) {
                     metadata->next_partial = reinterpret_cast<CellHeader *>(bin.partial_head);
@@ -1472,12 +2315,31 @@ namespace Cell {
                 }
             }
         }
+    }
 
-        // Also flush the cell-level TLS cache
+    // =========================================================================
+    // Statistics
+    // =========================================================================
+
+#ifdef CELL_ENABLE_STATS
+    MemoryStats Context::get_stats() const {
+        MemoryStats stats = m_stats.snapshot();
         if (m_allocator) {
-            m_allocator->flush_tls_cache();
-        }
+            stats.superblock_commits += m_allocator->superblock_commits();
+            stats.os_calls += m_allocator->os_calls();
+        }
+        if (m_buddy) {
+            // One mprotect (VirtualAlloc) per buddy superblock
+            stats.superblock_commits += m_buddy->superblock_count();
+            stats.os_calls += m_buddy->superblock_count();
+            stats.buddy_committed_bytes = m_buddy->bytes_committed();
+        }
+        stats.reserved_bytes = m_reserved_size + m_buddy_reserved_size;
+        stats.cell_committed_bytes = m_allocator ? m_allocator->committed_bytes() : 0;
+        stats.large_committed_bytes = m_large_allocs.bytes_allocated();
+        return stats;
     }
+#endif
 
     // =========================================================================
     // Debug API Implementation
@@ -1488,6 +2350,9 @@ namespace Cell {
         if (!ptr) {
             return false;
         }
+        if (m_page_guards.has_allocations() && m_page_guards.owns(ptr)) {
+            return true; // No guard bytes; overflows fault on the guard page
+        }
 
         auto *user_ptr = static_cast<uint8_t *>(ptr);
         auto *front_guard = user_ptr - kGuardSize;
@@ -1502,10 +2367,9 @@ namespace Cell {
 #ifdef CELL_DEBUG_LEAKS
         // Check back guard if we have size info
         {
-            std::lock_guard<std::mutex> lock(m_debug_mutex);
-            auto it = m_live_allocs.find(ptr);
-            if (it != m_live_allocs.end()) {
-                auto *back_guard = user_ptr + it->second.size;
+            DebugAllocation alloc;
+            if (m_live_allocs.find(ptr, &alloc)) {
+                auto *back_guard = user_ptr + alloc.size;
                 for (size_t i = 0; i < kGuardSize; ++i) {
                     if (back_guard[i] != kGuardPattern) {
                         return false;
@@ -1521,22 +2385,18 @@ namespace Cell {
 
 #ifdef CELL_DEBUG_LEAKS
     void Context::report_leaks() const {
-        std::lock_guard<std::mutex> lock(m_debug_mutex);
-
-        for (const auto &[ptr, alloc] : m_live_allocs) {
+        m_live_allocs.for_each([](const DebugAllocation &alloc) {
             std::fprintf(stderr, "  Leak: %p, size=%zu, tag=%u\n", alloc.ptr, alloc.size,
                          alloc.tag);
 #ifdef CELL_DEBUG_STACKTRACE
-            if (alloc.stack_depth > 0) {
-                print_stack(alloc.stack, alloc.stack_depth);
+            if (alloc.stack_id != kInvalidStackId) {
+                StackDepot::StackTrace trace = StackDepot::instance().get(alloc.stack_id);
+                print_stack(trace.frames, trace.depth);
             }
 #endif
-        }
+        });
     }
 
-    size_t Context::live_allocation_count() const {
-        std::lock_guard<std::mutex> lock(m_debug_mutex);
-        return m_live_allocs.size();
-    }
+    size_t Context::live_allocation_count() const { return m_live_allocs.size(); }
 #endif
 }
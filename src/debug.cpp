@@ -1,6 +1,6 @@
 #include "cell/debug.h"
 
-#ifdef CELL_DEBUG_STACKTRACE
+#if defined(CELL_DEBUG_STACKTRACE) || defined(CELL_ENABLE_HEAP_PROFILER)
 
 #include <cstdio>
 
@@ -62,8 +62,96 @@ namespace Cell {
 #include <cstdlib>
 #include <execinfo.h>
 
+#if defined(CELL_FRAME_POINTER_UNWIND) && (defined(__x86_64__) || defined(__aarch64__))
+#define CELL_HAS_FRAME_POINTER_WALK 1
+#include <cstdint>
+#include <pthread.h>
+
+namespace {
+    /** @brief Address range of the calling thread's stack. */
+    struct StackBounds {
+        uintptr_t low = 0;
+        uintptr_t high = 0; ///< 0 until looked up (or if the lookup failed).
+    };
+
+    thread_local StackBounds t_stack_bounds;
+    thread_local bool t_stack_bounds_queried = false;
+
+    const StackBounds &current_stack_bounds() {
+        if (!t_stack_bounds_queried) {
+            t_stack_bounds_queried = true;
+#if defined(__APPLE__)
+            pthread_t self = pthread_self();
+            auto high = reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(self));
+            t_stack_bounds = {high - pthread_get_stacksize_np(self), high};
+#else
+            pthread_attr_t attr;
+            if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+                void *addr = nullptr;
+                size_t size = 0;
+                if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+                    auto low = reinterpret_cast<uintptr_t>(addr);
+                    t_stack_bounds = {low, low + size};
+                }
+                pthread_attr_destroy(&attr);
+            }
+#endif
+        }
+        return t_stack_bounds;
+    }
+
+    /**
+     * @brief Follows the saved frame-pointer chain starting at frame fp.
+     *
+     * On x86-64 and AArch64 each frame record is {saved fp, return address}.
+     * Every record must lie inside the thread's stack and sit above the
+     * previous one, so a frame built without frame pointers ends the walk
+     * instead of faulting. Costs a few loads per frame versus the DWARF
+     * unwinding behind backtrace().
+     */
+    size_t walk_frame_pointers(uintptr_t fp, const StackBounds &bounds, void **buffer,
+                               size_t max_depth, size_t skip_frames) {
+        size_t count = 0;
+        while (count < max_depth) {
+            if (fp < bounds.low || fp > bounds.high - 2 * sizeof(void *) ||
+                fp % sizeof(void *) != 0) {
+                break;
+            }
+            auto *frame = reinterpret_cast<void **>(fp);
+            void *return_address = frame[1];
+            if (return_address == nullptr) {
+                break;
+            }
+            if (skip_frames > 0) {
+                --skip_frames;
+            } else {
+                buffer[count++] = return_address;
+            }
+            auto next = reinterpret_cast<uintptr_t>(frame[0]);
+            if (next <= fp) {
+                break; // Callers' frames sit at higher addresses
+            }
+            fp = next;
+        }
+        return count;
+    }
+} // namespace
+#endif
+
 namespace Cell {
+#ifdef CELL_HAS_FRAME_POINTER_WALK
+    __attribute__((noinline))
+#endif
     size_t capture_stack(void **buffer, size_t max_depth, size_t skip_frames) {
+#ifdef CELL_HAS_FRAME_POINTER_WALK
+        const StackBounds &bounds = current_stack_bounds();
+        if (bounds.high != 0) {
+            // This frame's record holds the return address into our caller,
+            // which backtrace() would report second, after this function
+            auto fp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+            return walk_frame_pointers(fp, bounds, buffer, max_depth, skip_frames);
+        }
+#endif
         // Capture extra frames to account for skipping
         constexpr size_t kExtraFrames = 8;
         void *temp[128];
@@ -153,4 +241,4 @@ namespace Cell {
 
 #endif
 
-#endif // CELL_DEBUG_STACKTRACE
+#endif // CELL_DEBUG_STACKTRACE || CELL_ENABLE_HEAP_PROFILER
@@ -0,0 +1,33 @@
+#include "cell/event_ring.h"
+
+#ifdef CELL_ENABLE_INSTRUMENTATION
+
+#include <algorithm>
+
+namespace Cell {
+
+    EventRing::EventRing(size_t capacity) : m_capacity(2) {
+        while (m_capacity < capacity) {
+            m_capacity <<= 1;
+        }
+        m_events.reset(new AllocEvent[m_capacity]);
+    }
+
+    size_t EventRing::pop(AllocEvent *out, size_t max_events) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t count = std::min(head - tail, max_events);
+
+        // Copy in at most two runs: up to the end of the array, then from the start
+        size_t start = tail & (m_capacity - 1);
+        size_t first = std::min(count, m_capacity - start);
+        std::copy_n(&m_events[start], first, out);
+        std::copy_n(&m_events[0], count - first, out + first);
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+}
+
+#endif // CELL_ENABLE_INSTRUMENTATION
@@ -0,0 +1,234 @@
+#include "cell/heap_profiler.h"
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+
+#include "cell/debug.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Cell {
+
+    namespace {
+        /** @brief Appends printf-formatted text to out. */
+        template <typename... Args>
+        void append(std::string &out, const char *format, Args... args) {
+            char buffer[256];
+            int len = std::snprintf(buffer, sizeof(buffer), format, args...);
+            if (len > 0) {
+                out.append(buffer, static_cast<size_t>(len) < sizeof(buffer)
+                                       ? static_cast<size_t>(len)
+                                       : sizeof(buffer) - 1);
+            }
+        }
+
+        /** @brief xorshift64* step; state must be nonzero. */
+        uint64_t next_random(uint64_t &state) {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1DULL;
+        }
+
+        /** @brief Draws an exponentially distributed interval with the given mean. */
+        int64_t draw_interval(uint64_t &state, size_t mean) {
+            // 53 random bits give a uniform u in [0, 1); -log(1 - u) is Exp(1)
+            double u = static_cast<double>(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+            return static_cast<int64_t>(-std::log(1.0 - u) * static_cast<double>(mean));
+        }
+
+        uint64_t hash_stack(void *const *stack, size_t depth) {
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (size_t i = 0; i < depth; ++i) {
+                hash ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(stack[i]));
+                hash *= 0x100000001B3ULL;
+            }
+            return hash;
+        }
+
+        /** @brief Appends /proc/self/maps for pprof symbolization; no-op elsewhere. */
+        void append_mapped_libraries(std::string &out) {
+#if defined(__linux__)
+            std::FILE *maps = std::fopen("/proc/self/maps", "r");
+            if (!maps) {
+                return;
+            }
+            out += "\nMAPPED_LIBRARIES:\n";
+            char buffer[4096];
+            size_t n;
+            while ((n = std::fread(buffer, 1, sizeof(buffer), maps)) > 0) {
+                out.append(buffer, n);
+            }
+            std::fclose(maps);
+#else
+            (void)out;
+#endif
+        }
+    } // namespace
+
+    // =========================================================================
+    // Construction
+    // =========================================================================
+
+    HeapProfiler::HeapProfiler(size_t sample_interval)
+        : m_sample_interval(sample_interval),
+          m_filter(new std::atomic<uint16_t>[kHeapSampleFilterSlots]()) {}
+
+    // =========================================================================
+    // Sampling
+    // =========================================================================
+
+    bool HeapProfiler::rearm(size_t pending_size) {
+        HeapSampleState &state = t_heap_sample;
+        size_t interval = sample_interval();
+
+        bool first = state.rng == 0;
+        if (first) {
+            // Seed from the thread's state address and the clock; never zero
+            auto seed = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&state)) ^
+                        static_cast<uint64_t>(
+                            std::chrono::steady_clock::now().time_since_epoch().count());
+            state.rng = seed ? seed : 1;
+        }
+
+        int64_t next =
+            interval == 0 ? kHeapSampleDisabledRecheck : draw_interval(state.rng, interval);
+        state.bytes_until_sample = next + static_cast<int64_t>(pending_size);
+
+        // The first tick on a thread only starts its countdown
+        return !first && interval != 0;
+    }
+
+    void HeapProfiler::record_alloc(void *ptr, size_t size) {
+        void *stack[kHeapProfileMaxDepth];
+        // Skip this function and its Context helper; the API entry point stays on top
+        size_t depth = capture_stack(stack, kHeapProfileMaxDepth, 2);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Bucket *bucket = find_bucket(stack, depth);
+        bucket->inuse_count++;
+        bucket->inuse_bytes += size;
+        bucket->alloc_count++;
+        bucket->alloc_bytes += size;
+        ++m_sample_count;
+
+        // A sampled pointer freed through an untracked path may be handed out again
+        auto [it, inserted] = m_live.try_emplace(ptr, LiveSample{bucket, size});
+        if (!inserted) {
+            release_sample(ptr, it->second);
+            it->second = LiveSample{bucket, size};
+        }
+        m_filter[filter_slot(ptr)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void HeapProfiler::record_free_slow(void *ptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_live.find(ptr);
+        if (it == m_live.end()) {
+            return; // Filter collision with another sampled pointer
+        }
+        release_sample(ptr, it->second);
+        m_live.erase(it);
+    }
+
+    HeapProfiler::Bucket *HeapProfiler::find_bucket(void *const *stack, size_t depth) {
+        uint64_t hash = hash_stack(stack, depth);
+        auto range = m_buckets.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            Bucket &bucket = it->second;
+            if (bucket.depth == depth &&
+                std::memcmp(bucket.stack, stack, depth * sizeof(void *)) == 0) {
+                return &bucket;
+            }
+        }
+
+        Bucket &bucket = m_buckets.emplace(hash, Bucket{})->second;
+        std::memcpy(bucket.stack, stack, depth * sizeof(void *));
+        bucket.depth = depth;
+        return &bucket;
+    }
+
+    void HeapProfiler::release_sample(void *ptr, const LiveSample &sample) {
+        sample.bucket->inuse_count--;
+        sample.bucket->inuse_bytes -= sample.size;
+        m_filter[filter_slot(ptr)].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // =========================================================================
+    // Reporting
+    // =========================================================================
+
+    std::string HeapProfiler::profile() const {
+        std::string out;
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        size_t inuse_count = 0, inuse_bytes = 0, alloc_count = 0, alloc_bytes = 0;
+        for (const auto &entry : m_buckets) {
+            const Bucket &bucket = entry.second;
+            inuse_count += bucket.inuse_count;
+            inuse_bytes += bucket.inuse_bytes;
+            alloc_count += bucket.alloc_count;
+            alloc_bytes += bucket.alloc_bytes;
+        }
+
+        out.reserve(128 + m_buckets.size() * 192);
+        append(out, "heap profile: %zu: %zu [ %zu: %zu] @ heap_v2/%zu\n", inuse_count,
+               inuse_bytes, alloc_count, alloc_bytes, sample_interval());
+        for (const auto &entry : m_buckets) {
+            const Bucket &bucket = entry.second;
+            if (bucket.inuse_count == 0 && bucket.alloc_count == 0) {
+                continue;
+            }
+            append(out, "%6zu: %zu [%6zu: %zu] @", bucket.inuse_count, bucket.inuse_bytes,
+                   bucket.alloc_count, bucket.alloc_bytes);
+            for (size_t i = 0; i < bucket.depth; ++i) {
+                append(out, " 0x%" PRIxPTR, reinterpret_cast<uintptr_t>(bucket.stack[i]));
+            }
+            out += "\n";
+        }
+
+        append_mapped_libraries(out);
+        return out;
+    }
+
+    bool HeapProfiler::write_profile(const char *path) const {
+        std::string text = profile();
+        std::FILE *file = std::fopen(path, "w");
+        if (!file) {
+            return false;
+        }
+        bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        return (std::fclose(file) == 0) && ok;
+    }
+
+    void HeapProfiler::reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+            Bucket &bucket = it->second;
+            if (bucket.inuse_count == 0) {
+                it = m_buckets.erase(it); // No live sample points at it
+            } else {
+                bucket.alloc_count = 0;
+                bucket.alloc_bytes = 0;
+                ++it;
+            }
+        }
+        m_sample_count = 0;
+    }
+
+    size_t HeapProfiler::live_sample_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_live.size();
+    }
+
+    size_t HeapProfiler::sample_count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_sample_count;
+    }
+
+}
+
+#endif // CELL_ENABLE_HEAP_PROFILER
@@ -1,122 +1,220 @@
 #include "cell/large.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
 #ifdef _WIN32
-#include <malloc.h> // For _aligned_malloc, _aligned_free
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <windows.h>
 #else
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 namespace Cell {
 
     // =========================================================================
-    // Destruction
+    // OS Helpers
     // =========================================================================
 
-    LargeAllocRegistry::~LargeAllocRegistry() {
-        // Free all remaining allocations
-        std::lock_guard<std::mutex> lock(m_lock);
-        for (auto &[ptr, alloc] : m_allocs) {
+    namespace {
+        size_t os_page_size() {
 #ifdef _WIN32
-            VirtualFree(ptr, 0, MEM_RELEASE);
+            static const size_t page_size = [] {
+                SYSTEM_INFO info;
+                GetSystemInfo(&info);
+                return static_cast<size_t>(info.dwPageSize);
+            }();
 #else
-            munmap(ptr, alloc.size);
+            static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
 #endif
+            return page_size;
         }
-        m_allocs.clear();
+
+#ifdef _WIN32
+        size_t os_allocation_granularity() {
+            static const size_t granularity = [] {
+                SYSTEM_INFO info;
+                GetSystemInfo(&info);
+                return static_cast<size_t>(info.dwAllocationGranularity);
+            }();
+            return granularity;
+        }
+#endif
+
+        inline size_t round_up(size_t value, size_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    } // namespace
+
+    size_t LargeAllocRegistry::rounded_size(size_t size) {
+        size_t page_size = os_page_size();
+        if (size > SIZE_MAX - (page_size - 1)) {
+            return 0; // Rounding up would wrap
+        }
+        return round_up(size, page_size);
     }
 
-    // =========================================================================
-    // Allocation
-    // =========================================================================
+    void *LargeAllocRegistry::map_aligned(size_t size, size_t alignment, bool try_huge_pages,
+                                          size_t &out_mapping_size, bool &out_huge) {
+        out_huge = false;
+        out_mapping_size = 0;
 
-    void *LargeAllocRegistry::alloc(size_t size, uint8_t tag, bool try_huge_pages) {
-        if (size == 0)
+        // Huge-page round-ups and alignment slack below grow size by at most this much
+        size_t max_growth = alignment > kHugePageSize ? alignment : kHugePageSize;
+        if (size == 0 || size > SIZE_MAX - max_growth) {
             return nullptr;
-
-        void *ptr = nullptr;
-        bool used_huge = false;
+        }
 
 #ifdef _WIN32
-        // Windows: Try large pages first if requested
-        if (try_huge_pages && size >= kMinLargeSize) {
+        // Windows: Try large pages first if requested. Large-page allocations are
+        // aligned to the large page minimum, which covers any alignment up to it.
+        if (try_huge_pages && size >= kMinLargeSize && alignment <= GetLargePageMinimum()) {
             // Note: MEM_LARGE_PAGES requires SeLockMemoryPrivilege
-            ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES,
-                               PAGE_READWRITE);
+            size_t large_size = round_up(size, GetLargePageMinimum());
+            void *ptr = VirtualAlloc(nullptr, large_size,
+                                     MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
             if (ptr) {
-                used_huge = true;
+                out_huge = true;
+                out_mapping_size = large_size;
+                return ptr;
             }
         }
-        if (!ptr) {
-            ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        }
-#elif defined(__linux__)
-        // Linux: Try huge pages first if requested
-        if (try_huge_pages && size >= kMinLargeSize) {
-            ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
-                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
-            if (ptr != MAP_FAILED) {
-                used_huge = true;
-            } else {
-                ptr = nullptr;
+
+        if (alignment <= os_allocation_granularity()) {
+            void *ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (ptr) {
+                out_mapping_size = size;
             }
+            return ptr;
         }
-        if (!ptr) {
-            ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-            if (ptr == MAP_FAILED) {
-                ptr = nullptr;
+
+        // Windows cannot release part of a reservation, so reserve an oversized
+        // range to find an aligned address, release it, and map exactly there.
+        // Another thread may claim the range in between, hence the retries.
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            void *probe = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+            if (!probe) {
+                return nullptr;
+            }
+            auto aligned = round_up(reinterpret_cast<uintptr_t>(probe), alignment);
+            VirtualFree(probe, 0, MEM_RELEASE);
+
+            void *ptr = VirtualAlloc(reinterpret_cast<void *>(aligned), size,
+                                     MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (ptr) {
+                out_mapping_size = size;
+                return ptr;
             }
         }
+        return nullptr;
 #else
-        // Other Unix (macOS, BSD): Standard mmap without huge pages
-        (void)try_huge_pages; // Unused on this platform
-        ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        if (ptr == MAP_FAILED) {
-            ptr = nullptr;
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        // hugetlbfs mappings are always huge-page aligned
+        if (try_huge_pages && size >= kMinLargeSize && alignment <= kHugePageSize) {
+            size_t huge_size = round_up(size, kHugePageSize);
+            void *ptr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                out_huge = true;
+                out_mapping_size = huge_size;
+                return ptr;
+            }
         }
 #endif
 
-        if (ptr) {
-            std::lock_guard<std::mutex> lock(m_lock);
-            m_allocs[ptr] = LargeAlloc{size, ptr, tag, used_huge, false};
-            m_total_allocated += size;
+        // Transparent huge pages only back 2MB-aligned ranges, so raise the
+        // alignment when we intend to advise the kernel below.
+        bool want_thp = try_huge_pages && size >= kMinLargeSize;
+        if (want_thp && alignment < kHugePageSize) {
+            alignment = kHugePageSize;
         }
 
+        size_t page_size = os_page_size();
+        size_t slack = alignment > page_size ? alignment - page_size : 0;
+        size_t reserve_size = size + slack;
+
+        void *raw = mmap(nullptr, reserve_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return nullptr;
+        }
+
+        // Trim the unaligned head and the unused tail back to the OS
+        auto raw_addr = reinterpret_cast<uintptr_t>(raw);
+        auto aligned_addr = round_up(raw_addr, alignment);
+        size_t head = aligned_addr - raw_addr;
+        size_t tail = reserve_size - head - size;
+        if (head > 0) {
+            munmap(raw, head);
+        }
+        if (tail > 0) {
+            munmap(reinterpret_cast<void *>(aligned_addr + size), tail);
+        }
+
+        void *ptr = reinterpret_cast<void *>(aligned_addr);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (want_thp) {
+            // Best-effort: THP may be disabled system-wide
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+#endif
+        out_mapping_size = size;
         return ptr;
+#endif
     }
 
-    void LargeAllocRegistry::free(void *ptr) {
-        if (!ptr)
-            return;
+    void LargeAllocRegistry::unmap(void *ptr, size_t mapping_size) {
+#ifdef _WIN32
+        (void)mapping_size;
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        munmap(ptr, mapping_size);
+#endif
+    }
 
+    // =========================================================================
+    // Destruction
+    // =========================================================================
+
+    LargeAllocRegistry::~LargeAllocRegistry() {
+        // Free all remaining allocations
         std::lock_guard<std::mutex> lock(m_lock);
-        auto it = m_allocs.find(ptr);
-        if (it == m_allocs.end()) {
-            return; // Not our allocation
+        for (auto &[ptr, alloc] : m_allocs) {
+            unmap(ptr, alloc.mapping_size);
         }
+        m_allocs.clear();
+    }
 
-        size_t size = it->second.size;
-        void *original = it->second.original_ptr;
-        bool aligned = it->second.aligned;
-        m_allocs.erase(it);
-        m_total_allocated -= size;
+    // =========================================================================
+    // Allocation
+    // =========================================================================
 
-#ifdef _WIN32
-        if (aligned) {
-            _aligned_free(original);
-        } else {
-            VirtualFree(original, 0, MEM_RELEASE);
-        }
-#else
-        if (aligned) {
-            ::free(original); // posix_memalign uses standard free
-        } else {
-            munmap(original, size);
+    void *LargeAllocRegistry::alloc(size_t size, uint8_t tag, bool try_huge_pages) {
+        return alloc_aligned(size, os_page_size(), tag, try_huge_pages);
+    }
+
+    void LargeAllocRegistry::free(void *ptr) {
+        if (!ptr)
+            return;
+
+        size_t mapping_size = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_allocs.find(ptr);
+            if (it == m_allocs.end()) {
+                return; // Not our allocation
+            }
+
+            mapping_size = it->second.mapping_size;
+            m_total_allocated -= it->second.size;
+            m_allocs.erase(it);
         }
-#endif
+
+        unmap(ptr, mapping_size);
     }
 
     void *LargeAllocRegistry::realloc_bytes(void *ptr, size_t new_size, uint8_t tag) {
@@ -133,6 +231,7 @@ namespace Cell {
 
         // Extract allocation info under lock, then release before OS calls
         size_t old_size = 0;
+        size_t old_alignment = 0;
         uint8_t old_tag = 0;
         {
             std::lock_guard<std::mutex> lock(m_lock);
@@ -142,14 +241,16 @@ namespace Cell {
                 return nullptr;
             }
             old_size = it->second.size;
+            old_alignment = it->second.alignment;
             old_tag = it->second.tag;
         }
         // Lock released here - ptr is still valid (we haven't freed it yet)
 
-        // Allocate new block
+        // Allocate new block with the same alignment as the original
         // Note: Using simple allocate+copy+free for phase 1.
         // Future optimization: use mremap() on Linux for in-place expansion
-        void *new_ptr = alloc(new_size, old_tag);
+        // Try huge pages as alloc() does; the old block may have fallen back to small ones
+        void *new_ptr = alloc_aligned(new_size, old_alignment, old_tag, true);
         if (!new_ptr) {
             // Allocation failed - original block unchanged
             return nullptr;
@@ -165,7 +266,8 @@ namespace Cell {
         return new_ptr;
     }
 
-    void *LargeAllocRegistry::alloc_aligned(size_t size, size_t alignment, uint8_t tag) {
+    void *LargeAllocRegistry::alloc_aligned(size_t size, size_t alignment, uint8_t tag,
+                                            bool try_huge_pages) {
         if (size == 0 || alignment == 0) {
             return nullptr;
         }
@@ -175,26 +277,23 @@ namespace Cell {
             return nullptr;
         }
 
-        void *ptr = nullptr;
-
-#ifdef _WIN32
-        ptr = _aligned_malloc(size, alignment);
-#else
-        // posix_memalign requires alignment to be at least sizeof(void*)
-        // and a power of 2
-        size_t min_align = sizeof(void *);
-        if (alignment < min_align) {
-            alignment = min_align;
+        // Every mapping is at least page aligned
+        if (alignment < os_page_size()) {
+            alignment = os_page_size();
         }
-        if (posix_memalign(&ptr, alignment, size) != 0) {
-            ptr = nullptr;
+
+        size_t accounted_size = rounded_size(size);
+        if (accounted_size == 0) {
+            return nullptr; // size is within a page of SIZE_MAX
         }
-#endif
+        size_t mapping_size = 0;
+        bool used_huge = false;
+        void *ptr = map_aligned(accounted_size, alignment, try_huge_pages, mapping_size, used_huge);
 
         if (ptr) {
             std::lock_guard<std::mutex> lock(m_lock);
-            m_allocs[ptr] = LargeAlloc{size, ptr, tag, false, true};
-            m_total_allocated += size;
+            m_allocs[ptr] = LargeAlloc{accounted_size, mapping_size, alignment, tag, used_huge};
+            m_total_allocated += accounted_size;
         }
 
         return ptr;
@@ -228,4 +327,13 @@ namespace Cell {
         return it->second.size;
     }
 
+    uint8_t LargeAllocRegistry::get_alloc_tag(void *ptr) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_allocs.find(ptr);
+        if (it == m_allocs.end()) {
+            return 0;
+        }
+        return it->second.tag;
+    }
+
 }
@@ -0,0 +1,152 @@
+#include "cell/leak_table.h"
+
+#ifdef CELL_DEBUG_LEAKS
+
+#include "cell/large.h"
+
+namespace Cell {
+
+    LeakTable::~LeakTable() {
+        for (Shard &shard : m_shards) {
+            if (shard.slots) {
+                LargeAllocRegistry::unmap(shard.slots, shard.mapping_size);
+            }
+        }
+    }
+
+    // =========================================================================
+    // Lookup and Update
+    // =========================================================================
+
+    bool LeakTable::insert(const DebugAllocation &alloc) {
+        uint64_t h = hash(alloc.ptr);
+        Shard &shard = shard_for(h);
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        size_t slot = find_slot(shard, alloc.ptr, h);
+        if (slot != shard.capacity) {
+            shard.slots[slot] = alloc; // Freed through an untracked path and handed out again
+            return true;
+        }
+
+        size_t count = shard.count.load(std::memory_order_relaxed);
+        if ((count + 1) * 2 > shard.capacity && !grow(shard)) {
+            return false;
+        }
+
+        size_t mask = shard.capacity - 1;
+        slot = h & mask;
+        while (shard.slots[slot].ptr) {
+            slot = (slot + 1) & mask;
+        }
+        shard.slots[slot] = alloc;
+        shard.count.store(count + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool LeakTable::erase(void *ptr, DebugAllocation *out) {
+        uint64_t h = hash(ptr);
+        Shard &shard = shard_for(h);
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        size_t slot = find_slot(shard, ptr, h);
+        if (slot == shard.capacity) {
+            return false;
+        }
+        if (out) {
+            *out = shard.slots[slot];
+        }
+
+        // Backward-shift deletion: pull later entries of the probe run into the
+        // hole unless that would move them before their home slot
+        size_t mask = shard.capacity - 1;
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask; shard.slots[next].ptr; next = (next + 1) & mask) {
+            size_t home = hash(shard.slots[next].ptr) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                shard.slots[hole] = shard.slots[next];
+                hole = next;
+            }
+        }
+        shard.slots[hole].ptr = nullptr;
+        shard.count.store(shard.count.load(std::memory_order_relaxed) - 1,
+                          std::memory_order_relaxed);
+        return true;
+    }
+
+    bool LeakTable::find(void *ptr, DebugAllocation *out) const {
+        uint64_t h = hash(ptr);
+        const Shard &shard = shard_for(h);
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        size_t slot = find_slot(shard, ptr, h);
+        if (slot == shard.capacity) {
+            return false;
+        }
+        *out = shard.slots[slot];
+        return true;
+    }
+
+    size_t LeakTable::size() const {
+        size_t total = 0;
+        for (const Shard &shard : m_shards) {
+            total += shard.count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // =========================================================================
+    // Shard Storage
+    // =========================================================================
+
+    size_t LeakTable::find_slot(const Shard &shard, const void *ptr, uint64_t h) {
+        if (shard.capacity == 0) {
+            return 0;
+        }
+        size_t mask = shard.capacity - 1;
+        for (size_t slot = h & mask; shard.slots[slot].ptr; slot = (slot + 1) & mask) {
+            if (shard.slots[slot].ptr == ptr) {
+                return slot;
+            }
+        }
+        return shard.capacity;
+    }
+
+    bool LeakTable::grow(Shard &shard) {
+        size_t capacity = shard.capacity ? shard.capacity * 2 : kLeakTableInitialSlots;
+        size_t bytes = LargeAllocRegistry::rounded_size(capacity * sizeof(DebugAllocation));
+        size_t mapping_size;
+        bool huge;
+        auto *slots = static_cast<DebugAllocation *>(
+            LargeAllocRegistry::map_aligned(bytes, alignof(DebugAllocation), false,
+                                            mapping_size, huge));
+        if (!slots) {
+            return false;
+        }
+
+        // Fresh mappings are zeroed, so every slot starts empty
+        size_t mask = capacity - 1;
+        for (size_t i = 0; i < shard.capacity; ++i) {
+            const DebugAllocation &entry = shard.slots[i];
+            if (!entry.ptr) {
+                continue;
+            }
+            size_t slot = hash(entry.ptr) & mask;
+            while (slots[slot].ptr) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = entry;
+        }
+
+        if (shard.slots) {
+            LargeAllocRegistry::unmap(shard.slots, shard.mapping_size);
+        }
+        shard.slots = slots;
+        shard.capacity = capacity;
+        shard.mapping_size = mapping_size;
+        return true;
+    }
+
+}
+
+#endif // CELL_DEBUG_LEAKS
@@ -0,0 +1,124 @@
+#include "cell/page_guard.h"
+
+#include "cell/large.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Cell {
+
+    namespace {
+        /** @brief Makes the page at addr inaccessible. */
+        bool protect_guard_page(void *addr, size_t page_size) {
+#ifdef _WIN32
+            DWORD old_protect;
+            return VirtualProtect(addr, page_size, PAGE_NOACCESS, &old_protect) != 0;
+#else
+            return mprotect(addr, page_size, PROT_NONE) == 0;
+#endif
+        }
+    } // namespace
+
+    PageGuardRegistry::~PageGuardRegistry() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (auto &[ptr, alloc] : m_allocs) {
+            LargeAllocRegistry::unmap(alloc.mapping, alloc.mapping_size);
+        }
+        m_allocs.clear();
+    }
+
+    size_t PageGuardRegistry::mapping_size_for(size_t size) {
+        size_t page_size = LargeAllocRegistry::rounded_size(1);
+        return LargeAllocRegistry::rounded_size(size) + page_size;
+    }
+
+    // =========================================================================
+    // Allocation
+    // =========================================================================
+
+    void *PageGuardRegistry::alloc(size_t size, size_t alignment, uint8_t tag) {
+        if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+            return nullptr;
+        }
+
+        size_t page_size = LargeAllocRegistry::rounded_size(1);
+        if (alignment > page_size) {
+            return nullptr; // The mapping is only page-aligned
+        }
+        size_t data_size = LargeAllocRegistry::rounded_size(size);
+        if (data_size == 0) {
+            return nullptr; // Rounding overflowed
+        }
+        size_t mapping_size;
+        bool huge;
+        void *mapping = LargeAllocRegistry::map_aligned(data_size + page_size, page_size, false,
+                                                        mapping_size, huge);
+        if (!mapping) {
+            return nullptr;
+        }
+
+        auto *guard = static_cast<uint8_t *>(mapping) + data_size;
+        if (!protect_guard_page(guard, page_size)) {
+            LargeAllocRegistry::unmap(mapping, mapping_size);
+            return nullptr;
+        }
+
+        // End the block as close to the guard page as the alignment allows
+        auto end = reinterpret_cast<uintptr_t>(guard);
+        void *ptr = reinterpret_cast<void *>((end - size) & ~(alignment - 1));
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_allocs[ptr] = GuardedAlloc{mapping, mapping_size, size, tag};
+        m_count.store(m_allocs.size(), std::memory_order_relaxed);
+        return ptr;
+    }
+
+    void PageGuardRegistry::free(void *ptr) {
+        GuardedAlloc alloc{};
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_allocs.find(ptr);
+            if (it == m_allocs.end()) {
+                return; // Not our allocation
+            }
+            alloc = it->second;
+            m_allocs.erase(it);
+            m_count.store(m_allocs.size(), std::memory_order_relaxed);
+        }
+        LargeAllocRegistry::unmap(alloc.mapping, alloc.mapping_size);
+    }
+
+    // =========================================================================
+    // Queries
+    // =========================================================================
+
+    bool PageGuardRegistry::owns(void *ptr) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_allocs.find(ptr) != m_allocs.end();
+    }
+
+    size_t PageGuardRegistry::get_alloc_size(void *ptr) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_allocs.find(ptr);
+        return it != m_allocs.end() ? it->second.size : 0;
+    }
+
+    size_t PageGuardRegistry::get_mapping_size(void *ptr) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_allocs.find(ptr);
+        return it != m_allocs.end() ? it->second.mapping_size : 0;
+    }
+
+    uint8_t PageGuardRegistry::get_alloc_tag(void *ptr) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_allocs.find(ptr);
+        return it != m_allocs.end() ? it->second.tag : 0;
+    }
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+namespace Cell {
+
+    /**
+     * @brief Faults in a committed, writable range ahead of use.
+     *
+     * Uses MADV_POPULATE_WRITE (Linux 5.14+) where available. Otherwise each
+     * page is written back to itself, which faults it in without changing its
+     * contents, so ranges already holding free-list links can be prefaulted.
+     *
+     * @param addr Start of the range.
+     * @param size Size of the range in bytes.
+     */
+    inline void prefault_pages(void *addr, size_t size) {
+#if defined(MADV_POPULATE_WRITE)
+        if (madvise(addr, size, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+
+        // Smallest page size we run on; touching more often than needed is harmless
+        constexpr size_t kTouchStride = 4096;
+        auto *bytes = static_cast<volatile char *>(addr);
+        for (size_t off = 0; off < size; off += kTouchStride) {
+            bytes[off] = bytes[off];
+        }
+    }
+
+}
@@ -0,0 +1,173 @@
+#include "cell/pressure.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace Cell {
+
+    namespace {
+        /**
+         * @brief Finds "key" followed by '=' or ' ' at the start of a token in text.
+         * @return Pointer just past the separator, or nullptr.
+         */
+        const char *find_field(const char *text, const char *key, char separator) {
+            size_t key_len = std::strlen(key);
+            for (const char *p = std::strstr(text, key); p; p = std::strstr(p + 1, key)) {
+                bool at_token = (p == text) || p[-1] == ' ' || p[-1] == '\n';
+                if (at_token && p[key_len] == separator) {
+                    return p + key_len + 1;
+                }
+            }
+            return nullptr;
+        }
+
+        /** @brief Returns the start of the line beginning with prefix, or nullptr. */
+        const char *find_line(const char *text, const char *prefix) {
+            size_t len = std::strlen(prefix);
+            for (const char *line = text; line && *line;) {
+                if (std::strncmp(line, prefix, len) == 0) {
+                    return line;
+                }
+                line = std::strchr(line, '\n');
+                if (line) {
+                    ++line;
+                }
+            }
+            return nullptr;
+        }
+    } // namespace
+
+    // =========================================================================
+    // Construction / Destruction
+    // =========================================================================
+
+    PressureMonitor::PressureMonitor(Context &ctx, PressureMonitorConfig config)
+        : m_ctx(ctx), m_config(std::move(config)) {}
+
+    PressureMonitor::~PressureMonitor() { stop(); }
+
+    // =========================================================================
+    // Polling
+    // =========================================================================
+
+    PressureLevel PressureMonitor::poll_once() {
+        PressureLevel level = read_level();
+        m_last_level.store(level, std::memory_order_relaxed);
+
+        if (level != PressureLevel::kNone) {
+            m_bytes_reclaimed.fetch_add(m_ctx.trim(level), std::memory_order_relaxed);
+        }
+        return level;
+    }
+
+    bool PressureMonitor::start() {
+        if (m_thread.joinable()) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = false;
+        }
+
+        m_thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_stop) {
+                lock.unlock();
+                poll_once();
+                lock.lock();
+                m_wake.wait_for(lock, m_config.interval, [this]() { return m_stop; });
+            }
+        });
+        return true;
+    }
+
+    void PressureMonitor::stop() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    // =========================================================================
+    // Source Parsing
+    // =========================================================================
+
+    PressureLevel PressureMonitor::read_level() {
+        std::FILE *file = std::fopen(m_config.path.c_str(), "r");
+        if (!file) {
+            return PressureLevel::kNone;
+        }
+
+        // Both formats are a few short lines
+        char text[1024];
+        size_t len = std::fread(text, 1, sizeof(text) - 1, file);
+        std::fclose(file);
+        text[len] = '\0';
+
+        if (m_config.source == PressureSource::kCgroupEvents) {
+            return parse_cgroup_events(text);
+        }
+        return parse_psi(text);
+    }
+
+    PressureLevel PressureMonitor::parse_psi(const char *text) const {
+        const char *some = find_line(text, "some ");
+        const char *some_avg10 = some ? find_field(some, "avg10", '=') : nullptr;
+        if (!some_avg10) {
+            return PressureLevel::kNone;
+        }
+        double some_pct = std::strtod(some_avg10, nullptr);
+
+        // "full" means every non-idle task was stalled at once
+        double full_pct = 0.0;
+        if (const char *full = find_line(text, "full ")) {
+            if (const char *full_avg10 = find_field(full, "avg10", '=')) {
+                full_pct = std::strtod(full_avg10, nullptr);
+            }
+        }
+
+        if (some_pct >= m_config.critical_avg10 || full_pct >= m_config.moderate_avg10) {
+            return PressureLevel::kCritical;
+        }
+        if (some_pct >= m_config.moderate_avg10) {
+            return PressureLevel::kModerate;
+        }
+        return PressureLevel::kNone;
+    }
+
+    PressureLevel PressureMonitor::parse_cgroup_events(const char *text) {
+        auto counter = [text](const char *key) -> uint64_t {
+            const char *value = find_field(text, key, ' ');
+            return value ? std::strtoull(value, nullptr, 10) : 0;
+        };
+
+        uint64_t high = counter("high");
+        uint64_t max = counter("max");
+        uint64_t oom = counter("oom") + counter("oom_kill");
+
+        PressureLevel level = PressureLevel::kNone;
+        if (m_have_baseline) {
+            if (max > m_last_max || oom > m_last_oom) {
+                level = PressureLevel::kCritical;
+            } else if (high > m_last_high) {
+                level = PressureLevel::kModerate;
+            }
+        }
+
+        m_have_baseline = true;
+        m_last_high = high;
+        m_last_max = max;
+        m_last_oom = oom;
+        return level;
+    }
+
+}
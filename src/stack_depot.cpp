@@ -0,0 +1,158 @@
+#include "cell/stack_depot.h"
+
+#ifdef CELL_DEBUG_STACKTRACE
+
+#include "cell/large.h"
+
+#include <cstring>
+#include <new>
+
+namespace Cell {
+
+    namespace {
+        /** @brief Record offsets are stored in units of this many bytes. */
+        constexpr size_t kRecordAlign = 8;
+
+        /** @brief Bits of a StackId holding the offset within a chunk. */
+        constexpr unsigned kOffsetBits = 17;
+
+        static_assert(kStackDepotChunkSize / kRecordAlign == (size_t{1} << kOffsetBits),
+                      "chunk offsets must fill kOffsetBits");
+        static_assert(kStackDepotMaxChunks << kOffsetBits <= UINT32_MAX,
+                      "IDs must fit in a StackId");
+    } // namespace
+
+    StackDepot &StackDepot::instance() {
+        // Never destroyed: leak reports from static destructors still resolve IDs
+        alignas(StackDepot) static unsigned char storage[sizeof(StackDepot)];
+        static StackDepot *depot = new (storage) StackDepot();
+        return *depot;
+    }
+
+    // =========================================================================
+    // Lookup and Insert
+    // =========================================================================
+
+    StackId StackDepot::put(void *const *stack, size_t depth) {
+        if (depth == 0) {
+            return kInvalidStackId;
+        }
+        if (depth > kStackDepotMaxDepth) {
+            depth = kStackDepotMaxDepth;
+        }
+
+        uint64_t h = hash(stack, depth);
+        std::atomic<StackId> &bucket = m_buckets[h & (kStackDepotBuckets - 1)];
+        StackId id = find(bucket.load(std::memory_order_acquire), h, stack, depth);
+        if (id != kInvalidStackId) {
+            return id;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        // Another thread may have stored the same trace since the lock-free walk
+        StackId head = bucket.load(std::memory_order_relaxed);
+        id = find(head, h, stack, depth);
+        if (id != kInvalidStackId) {
+            return id;
+        }
+
+        size_t bytes = sizeof(Record) + depth * sizeof(void *);
+        size_t chunk = m_chunk_count.load(std::memory_order_relaxed);
+        if (m_chunk_used + bytes > kStackDepotChunkSize) {
+            if (chunk == kStackDepotMaxChunks) {
+                return kInvalidStackId;
+            }
+            size_t mapping_size;
+            bool huge;
+            auto *base = static_cast<uint8_t *>(LargeAllocRegistry::map_aligned(
+                kStackDepotChunkSize, kRecordAlign, false, mapping_size, huge));
+            if (!base) {
+                return kInvalidStackId;
+            }
+            m_chunks[chunk].store(base, std::memory_order_release);
+            m_chunk_count.store(++chunk, std::memory_order_relaxed);
+            m_chunk_used = 0;
+        }
+
+        size_t index = chunk - 1;
+        uint8_t *base = m_chunks[index].load(std::memory_order_relaxed);
+        auto *record = reinterpret_cast<Record *>(base + m_chunk_used);
+        record->hash = h;
+        record->next = head;
+        record->depth = static_cast<uint32_t>(depth);
+        std::memcpy(record + 1, stack, depth * sizeof(void *));
+
+        id = static_cast<StackId>(((index << kOffsetBits) | (m_chunk_used / kRecordAlign)) + 1);
+        m_chunk_used += bytes;
+        m_unique.fetch_add(1, std::memory_order_relaxed);
+        bucket.store(id, std::memory_order_release);
+        return id;
+    }
+
+    StackDepot::StackTrace StackDepot::get(StackId id) const {
+        const Record *record = resolve(id);
+        if (!record) {
+            return {nullptr, 0};
+        }
+        return {reinterpret_cast<void *const *>(record + 1), record->depth};
+    }
+
+    StackId StackDepot::find(StackId head, uint64_t h, void *const *stack, size_t depth) const {
+        for (StackId id = head; id != kInvalidStackId;) {
+            const Record *record = resolve(id);
+            if (record->hash == h && record->depth == depth &&
+                std::memcmp(record + 1, stack, depth * sizeof(void *)) == 0) {
+                return id;
+            }
+            id = record->next;
+        }
+        return kInvalidStackId;
+    }
+
+    const StackDepot::Record *StackDepot::resolve(StackId id) const {
+        if (id == kInvalidStackId) {
+            return nullptr;
+        }
+        size_t value = id - 1;
+        size_t index = value >> kOffsetBits;
+        if (index >= kStackDepotMaxChunks) {
+            return nullptr;
+        }
+        const uint8_t *base = m_chunks[index].load(std::memory_order_acquire);
+        if (!base) {
+            return nullptr;
+        }
+        size_t offset = (value & ((size_t{1} << kOffsetBits) - 1)) * kRecordAlign;
+        return reinterpret_cast<const Record *>(base + offset);
+    }
+
+    uint64_t StackDepot::hash(void *const *stack, size_t depth) {
+        // Fold each frame in, then apply the Murmur3 finalizer
+        uint64_t h = depth;
+        for (size_t i = 0; i < depth; ++i) {
+            h ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(stack[i]));
+            h *= 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // =========================================================================
+    // Capture
+    // =========================================================================
+
+    StackId capture_stack_id(size_t skip_frames) {
+        void *stack[kMaxStackDepth];
+        size_t depth = capture_stack(stack, kMaxStackDepth, skip_frames + 1); // +1 for this function
+        return StackDepot::instance().put(stack, depth);
+    }
+
+}
+
+#endif // CELL_DEBUG_STACKTRACE
@@ -0,0 +1,177 @@
+#include "cell/stats.h"
+
+#ifdef CELL_ENABLE_STATS
+
+namespace Cell {
+
+    namespace {
+        /** @brief Appends printf-formatted text to out. */
+        template <typename... Args>
+        void append(std::string &out, const char *format, Args... args) {
+            char buffer[256];
+            int len = std::snprintf(buffer, sizeof(buffer), format, args...);
+            if (len > 0) {
+                out.append(buffer, static_cast<size_t>(len) < sizeof(buffer)
+                                       ? static_cast<size_t>(len)
+                                       : sizeof(buffer) - 1);
+            }
+        }
+
+        struct TierCounts {
+            const char *name;
+            size_t allocs;
+            size_t frees;
+        };
+
+        /** @brief Writes "# HELP" and "# TYPE" lines for a metric family. */
+        void prometheus_header(std::string &out, const char *prefix, const char *name,
+                               const char *type, const char *help) {
+            append(out, "# HELP %s_%s %s\n", prefix, name, help);
+            append(out, "# TYPE %s_%s %s\n", prefix, name, type);
+        }
+
+        void prometheus_value(std::string &out, const char *prefix, const char *name,
+                              const char *type, const char *help, size_t value) {
+            prometheus_header(out, prefix, name, type, help);
+            append(out, "%s_%s %zu\n", prefix, name, value);
+        }
+    } // namespace
+
+    // =========================================================================
+    // JSON
+    // =========================================================================
+
+    std::string MemoryStats::to_json() const {
+        std::string out;
+        out.reserve(4096);
+
+        append(out, "{\"total_allocated\":%zu,\"total_freed\":%zu", total_allocated, total_freed);
+        append(out, ",\"current_allocated\":%zu,\"peak_allocated\":%zu", current_allocated,
+               peak_allocated);
+        append(out, ",\"reserved_bytes\":%zu,\"cell_committed_bytes\":%zu", reserved_bytes,
+               cell_committed_bytes);
+        append(out, ",\"buddy_committed_bytes\":%zu,\"large_committed_bytes\":%zu",
+               buddy_committed_bytes, large_committed_bytes);
+        append(out, ",\"superblock_commits\":%zu,\"os_calls\":%zu", superblock_commits, os_calls);
+
+        const TierCounts tiers[] = {{"cell", cell_allocs, cell_frees},
+                                    {"subcell", subcell_allocs, subcell_frees},
+                                    {"buddy", buddy_allocs, buddy_frees},
+                                    {"large", large_allocs, large_frees}};
+        out += ",\"tiers\":{";
+        for (size_t i = 0; i < sizeof(tiers) / sizeof(tiers[0]); ++i) {
+            append(out, "%s\"%s\":{\"allocs\":%zu,\"frees\":%zu}", i > 0 ? "," : "",
+                   tiers[i].name, tiers[i].allocs, tiers[i].frees);
+        }
+        out += "}";
+
+        out += ",\"bins\":[";
+        for (size_t i = 0; i < kNumSizeBins; ++i) {
+            const BinStats &bin = bins[i];
+            append(out, "%s{\"size\":%zu,\"allocs\":%zu,\"requested_bytes\":%zu", i > 0 ? "," : "",
+                   kSizeClasses[i], bin.allocs, bin.requested_bytes);
+            append(out, ",\"rounded_bytes\":%zu,\"tls_hits\":%zu,\"tls_misses\":%zu",
+                   bin.rounded_bytes, bin.tls_hits, bin.tls_misses);
+            append(out, ",\"refill_batches\":%zu,\"cells_carved\":%zu,\"cells_returned\":%zu",
+                   bin.refill_batches, bin.cells_carved, bin.cells_returned);
+            append(out, ",\"lock_contended\":%zu}", bin.lock_contended);
+        }
+        out += "]";
+
+        out += ",\"tags\":{";
+        bool first = true;
+        for (size_t tag = 0; tag < per_tag_current.size(); ++tag) {
+            if (per_tag_current[tag] != 0) {
+                append(out, "%s\"%zu\":%zu", first ? "" : ",", tag, per_tag_current[tag]);
+                first = false;
+            }
+        }
+        out += "}}";
+        return out;
+    }
+
+    // =========================================================================
+    // Prometheus Text Exposition
+    // =========================================================================
+
+    std::string MemoryStats::to_prometheus(const char *prefix) const {
+        std::string out;
+        out.reserve(16384);
+
+        prometheus_value(out, prefix, "allocated_bytes_total", "counter",
+                         "Cumulative bytes allocated.", total_allocated);
+        prometheus_value(out, prefix, "freed_bytes_total", "counter", "Cumulative bytes freed.",
+                         total_freed);
+        prometheus_value(out, prefix, "current_bytes", "gauge", "Bytes currently allocated.",
+                         current_allocated);
+        prometheus_value(out, prefix, "peak_bytes", "gauge", "Sampled peak of current bytes.",
+                         peak_allocated);
+        prometheus_value(out, prefix, "reserved_bytes", "gauge",
+                         "Virtual address space reserved.", reserved_bytes);
+
+        prometheus_header(out, prefix, "committed_bytes", "gauge", "Committed bytes by tier.");
+        append(out, "%s_committed_bytes{tier=\"cell\"} %zu\n", prefix, cell_committed_bytes);
+        append(out, "%s_committed_bytes{tier=\"buddy\"} %zu\n", prefix, buddy_committed_bytes);
+        append(out, "%s_committed_bytes{tier=\"large\"} %zu\n", prefix, large_committed_bytes);
+
+        prometheus_value(out, prefix, "superblock_commits_total", "counter",
+                         "Superblocks committed, including recommits.", superblock_commits);
+        prometheus_value(out, prefix, "os_calls_total", "counter",
+                         "mprotect and madvise calls.", os_calls);
+
+        const TierCounts tiers[] = {{"cell", cell_allocs, cell_frees},
+                                    {"subcell", subcell_allocs, subcell_frees},
+                                    {"buddy", buddy_allocs, buddy_frees},
+                                    {"large", large_allocs, large_frees}};
+        prometheus_header(out, prefix, "allocs_total", "counter", "Allocations by tier.");
+        for (const TierCounts &tier : tiers) {
+            append(out, "%s_allocs_total{tier=\"%s\"} %zu\n", prefix, tier.name, tier.allocs);
+        }
+        prometheus_header(out, prefix, "frees_total", "counter", "Frees by tier.");
+        for (const TierCounts &tier : tiers) {
+            append(out, "%s_frees_total{tier=\"%s\"} %zu\n", prefix, tier.name, tier.frees);
+        }
+
+        struct BinMetric {
+            const char *name;
+            const char *help;
+            size_t BinStats::*field;
+        };
+        const BinMetric bin_metrics[] = {
+            {"bin_allocs_total", "Sub-cell allocations by size class.", &BinStats::allocs},
+            {"bin_requested_bytes_total", "Requested bytes by size class.",
+             &BinStats::requested_bytes},
+            {"bin_rounded_bytes_total", "Size-class rounded bytes by size class.",
+             &BinStats::rounded_bytes},
+            {"bin_tls_hits_total", "Thread-cache hits by size class.", &BinStats::tls_hits},
+            {"bin_tls_misses_total", "Thread-cache misses by size class.", &BinStats::tls_misses},
+            {"bin_refill_batches_total", "Thread-cache refills by size class.",
+             &BinStats::refill_batches},
+            {"bin_cells_carved_total", "Cells carved by size class.", &BinStats::cells_carved},
+            {"bin_cells_returned_total", "Cells returned by size class.",
+             &BinStats::cells_returned},
+            {"bin_lock_contended_total", "Contended bin lock acquisitions by size class.",
+             &BinStats::lock_contended},
+        };
+        for (const BinMetric &metric : bin_metrics) {
+            prometheus_header(out, prefix, metric.name, "counter", metric.help);
+            for (size_t i = 0; i < kNumSizeBins; ++i) {
+                append(out, "%s_%s{size=\"%zu\"} %zu\n", prefix, metric.name, kSizeClasses[i],
+                       bins[i].*metric.field);
+            }
+        }
+
+        prometheus_header(out, prefix, "tag_current_bytes", "gauge",
+                          "Bytes currently allocated by tag.");
+        for (size_t tag = 0; tag < per_tag_current.size(); ++tag) {
+            if (per_tag_current[tag] != 0) {
+                append(out, "%s_tag_current_bytes{tag=\"%zu\"} %zu\n", prefix, tag,
+                       per_tag_current[tag]);
+            }
+        }
+        return out;
+    }
+
+}
+
+#endif // CELL_ENABLE_STATS
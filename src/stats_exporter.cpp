@@ -0,0 +1,100 @@
+#include "cell/stats_exporter.h"
+
+#ifdef CELL_ENABLE_STATS
+
+#include <cstdio>
+#include <utility>
+
+namespace Cell {
+
+    // =========================================================================
+    // Construction / Destruction
+    // =========================================================================
+
+    StatsExporter::StatsExporter(Context &ctx, StatsExporterConfig config)
+        : m_ctx(ctx), m_config(std::move(config)) {}
+
+    StatsExporter::~StatsExporter() { stop(); }
+
+    // =========================================================================
+    // Exporting
+    // =========================================================================
+
+    bool StatsExporter::export_once() {
+        MemoryStats stats = m_ctx.get_stats();
+
+        bool written = m_config.path.empty() || write_file(stats);
+        if (m_config.callback) {
+            m_config.callback(stats);
+        }
+        m_export_count.fetch_add(1, std::memory_order_relaxed);
+        return written;
+    }
+
+    bool StatsExporter::start() {
+        if (m_thread.joinable()) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = false;
+        }
+
+        m_thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_stop) {
+                lock.unlock();
+                export_once();
+                lock.lock();
+                m_wake.wait_for(lock, m_config.interval, [this]() { return m_stop; });
+            }
+        });
+        return true;
+    }
+
+    void StatsExporter::stop() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    // =========================================================================
+    // File Output
+    // =========================================================================
+
+    bool StatsExporter::write_file(const MemoryStats &stats) const {
+        std::string text = m_config.format == StatsFormat::kPrometheus
+                               ? stats.to_prometheus(m_config.prometheus_prefix.c_str())
+                               : stats.to_json() + "\n";
+
+        // Write beside the target and rename, so readers see whole snapshots
+        std::string tmp_path = m_config.path + ".tmp";
+        std::FILE *file = std::fopen(tmp_path.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        ok = (std::fclose(file) == 0) && ok;
+        if (!ok) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+
+        // rename() does not replace an existing file on Windows
+#if defined(_WIN32)
+        std::remove(m_config.path.c_str());
+#endif
+        return std::rename(tmp_path.c_str(), m_config.path.c_str()) == 0;
+    }
+
+}
+
+#endif // CELL_ENABLE_STATS
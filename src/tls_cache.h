@@ -6,19 +6,45 @@
 namespace Cell {
 
     /**
-     * @brief Per-thread cell cache.
+     * @brief Per-thread cell cache holding up to two magazines.
      *
-     * Fixed-size array, no locking required.
+     * Cells are pushed and popped on the @c loaded magazine, an intrusive chain
+     * through FreeCell::next. When it fills, it becomes @c previous (whose old
+     * contents go to the global depot); when it empties, a full @c previous or a
+     * depot magazine takes its place. Whole chains move without walking them,
+     * and no locking is required.
+     *
+     * One cache serves every Allocator on the thread, so it records the
+     * Allocator whose cells it holds; see Allocator::claim_tls_cache().
      */
     struct TlsCache {
-        FreeCell *cells[kTlsCacheCapacity] = {};
-        size_t count = 0;
+        Allocator *owner = nullptr;   ///< Allocator the cached cells belong to, or nullptr.
+        FreeCell *loaded = nullptr;   ///< Magazine cells are pushed to and popped from.
+        size_t loaded_count = 0;      ///< Cells in @c loaded.
+        FreeCell *previous = nullptr; ///< Full magazine, or nullptr.
+        size_t previous_count = 0;    ///< Cells in @c previous (0 or a full magazine).
+
+        [[nodiscard]] bool is_empty() const { return loaded_count == 0 && previous_count == 0; }
+
+        void push(FreeCell *c) {
+            c->next = loaded;
+            loaded = c;
+            ++loaded_count;
+        }
 
-        [[nodiscard]] bool is_empty() const { return count == 0; }
-        [[nodiscard]] bool is_full() const { return count >= kTlsCacheCapacity; }
+        [[nodiscard]] FreeCell *pop() {
+            FreeCell *c = loaded;
+            loaded = c->next;
+            --loaded_count;
+            return c;
+        }
 
-        void push(FreeCell *c) { cells[count++] = c; }
-        [[nodiscard]] FreeCell *pop() { return cells[--count]; }
+        /** @brief Drops all cached cells without returning them anywhere. */
+        void clear() {
+            owner = nullptr;
+            loaded = previous = nullptr;
+            loaded_count = previous_count = 0;
+        }
     };
 
     /** @brief Thread-local cache instance. */
@@ -1,5 +1,6 @@
 #include "cell/context.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -232,6 +233,328 @@ TEST(MemoryDecommit) {
     printf("  PASSED\n");
 }
 
+// Test 7: Decommitted superblocks are reused once each, before fresh address space
+TEST(DecommittedSuperblockReuse) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    const size_t count = Cell::kCellsPerSuperblock * 4;
+    std::vector<Cell::CellData *> cells;
+
+    for (size_t i = 0; i < count; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+    size_t committed_full = ctx.committed_bytes();
+
+    for (auto *cell : cells) {
+        ctx.free_cell(cell);
+    }
+    cells.clear();
+    ctx.flush_tls_caches();
+
+    size_t freed = ctx.decommit_unused();
+    assert(freed > 0);
+    assert(ctx.committed_bytes() == committed_full - freed);
+
+    // Refill concurrently: each recommitted superblock must be carved by one
+    // thread only, so every returned cell is distinct.
+    constexpr int num_threads = 4;
+    std::vector<std::vector<Cell::CellData *>> per_thread(num_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&ctx, &per_thread, t, count]() {
+            for (size_t i = 0; i < count / num_threads; ++i) {
+                Cell::CellData *cell = ctx.alloc_cell(0);
+                assert(cell != nullptr);
+                std::memset(reinterpret_cast<char *>(cell) + Cell::kCellSize - 64, t, 64);
+                per_thread[t].push_back(cell);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::vector<Cell::CellData *> all;
+    for (auto &v : per_thread) {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    std::sort(all.begin(), all.end());
+    assert(std::adjacent_find(all.begin(), all.end()) == all.end() && "Cell handed out twice");
+
+    for (auto *cell : all) {
+        ctx.free_cell(cell);
+    }
+    ctx.flush_tls_caches();
+
+    printf("  PASSED (%zu bytes recommitted)\n", ctx.committed_bytes());
+}
+
+// Test 8: Cells freed in bursts on one thread are reused via magazines on another
+TEST(MagazineHandoff) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    const size_t count = Cell::kCellsPerSuperblock * 2 + Cell::kCellMagazineSize / 2;
+    std::vector<Cell::CellData *> cells;
+
+    std::thread producer([&ctx, &cells, count]() {
+        for (size_t i = 0; i < count; ++i) {
+            Cell::CellData *cell = ctx.alloc_cell(0);
+            assert(cell != nullptr);
+            cells.push_back(cell);
+        }
+    });
+    producer.join();
+    size_t committed = ctx.committed_bytes();
+
+    // Free everything from a second thread: its TLS cache spills whole
+    // magazines to the depot, and the remainder is flushed on exit.
+    std::thread consumer([&ctx, &cells]() {
+        for (auto *cell : cells) {
+            ctx.free_cell(cell);
+        }
+        ctx.flush_tls_caches();
+    });
+    consumer.join();
+    cells.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+    assert(ctx.committed_bytes() == committed && "Freed cells should be reused, not refilled");
+
+    std::vector<Cell::CellData *> sorted = cells;
+    std::sort(sorted.begin(), sorted.end());
+    assert(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+    for (auto *cell : cells) {
+        ctx.free_cell(cell);
+    }
+    ctx.flush_tls_caches();
+
+    printf("  PASSED\n");
+}
+
+// Test 9: Free cells of partially used superblocks are released and reused
+TEST(PartialSuperblockRelease) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    const size_t count = Cell::kCellsPerSuperblock * 2;
+    std::vector<Cell::CellData *> cells;
+
+    for (size_t i = 0; i < count; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+    size_t committed_full = ctx.committed_bytes();
+
+    // Keep one live cell per superblock so neither can be decommitted whole
+    std::vector<Cell::CellData *> live;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % Cell::kCellsPerSuperblock == 0) {
+            live.push_back(cells[i]);
+        } else {
+            ctx.free_cell(cells[i]);
+        }
+    }
+    cells.clear();
+
+    size_t freed = ctx.decommit_unused();
+    size_t committed_after = ctx.committed_bytes();
+    size_t retained = Cell::kRetainedCellMagazines * Cell::kCellMagazineSize;
+    printf("  Released: %zu bytes, committed %zu -> %zu\n", freed, committed_full,
+           committed_after);
+    assert(freed == (count - live.size() - retained) * Cell::kCellSize);
+    assert(committed_after == (live.size() + retained) * Cell::kCellSize);
+
+    // Reallocating reuses the released cells without committing new superblocks
+    for (size_t i = 0; i < count - live.size(); ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        std::memset(reinterpret_cast<char *>(cell) + sizeof(Cell::CellHeader), 0x5A,
+                    Cell::kCellSize - sizeof(Cell::CellHeader));
+        cells.push_back(cell);
+    }
+    assert(ctx.committed_bytes() == committed_full);
+
+    for (auto *cell : cells) {
+        ctx.free_cell(cell);
+    }
+    for (auto *cell : live) {
+        ctx.free_cell(cell);
+    }
+    ctx.flush_tls_caches();
+
+    // Everything is free again: both superblocks decommit whole
+    ctx.decommit_unused();
+    assert(ctx.committed_bytes() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 10: Lazy-free release policy
+TEST(LazyFreeReleasePolicy) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.release_policy = Cell::ReleasePolicy::kLazyFree;
+
+    Cell::Context ctx(config);
+    const size_t count = Cell::kCellsPerSuperblock * 2;
+    std::vector<Cell::CellData *> cells;
+
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < count; ++i) {
+            Cell::CellData *cell = ctx.alloc_cell(0);
+            assert(cell != nullptr);
+            char *payload = reinterpret_cast<char *>(cell) + sizeof(Cell::CellHeader);
+            std::memset(payload, round + 1, Cell::kCellSize - sizeof(Cell::CellHeader));
+            cells.push_back(cell);
+        }
+        size_t committed = ctx.committed_bytes();
+
+        // Data written after reuse must survive: the write cancels the lazy free
+        for (auto *cell : cells) {
+            char *payload = reinterpret_cast<char *>(cell) + sizeof(Cell::CellHeader);
+            assert(payload[0] == round + 1);
+            assert(payload[Cell::kCellSize - sizeof(Cell::CellHeader) - 1] == round + 1);
+            ctx.free_cell(cell);
+        }
+        cells.clear();
+
+        size_t freed = ctx.decommit_unused();
+        assert(freed == committed && "Both superblocks should be lazily freed");
+        assert(ctx.committed_bytes() == 0);
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 11: Prewarming commits cells and carves bin cells ahead of use
+TEST(PrewarmCommitsAhead) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    const size_t target = 2 * Cell::kSuperblockSize;
+
+    // Both the cell and buddy tiers are warmed to the target
+    const size_t warmed = ctx.prewarm(target, {64, 256});
+    assert(warmed >= target);
+    assert(ctx.committed_bytes() == warmed);
+    assert(ctx.prewarm(target) == 0 && "Already warm tiers should commit nothing");
+
+    // Filling every TLS bin carves its cells from the prewarmed pool
+    ctx.warm_thread();
+    assert(ctx.committed_bytes() == warmed);
+
+    std::vector<void *> blocks;
+    for (size_t size : {16, 64, 256, 4096}) {
+        void *p = ctx.alloc_bytes(size, 1);
+        assert(p != nullptr);
+        std::memset(p, 0x3C, size);
+        blocks.push_back(p);
+    }
+
+    // The remaining prewarmed cells are served without committing more
+    std::vector<Cell::CellData *> cells;
+    for (size_t i = 0; i < Cell::kCellsPerSuperblock; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+    assert(ctx.committed_bytes() == warmed);
+
+    for (auto *cell : cells) {
+        ctx.free_cell(cell);
+    }
+    for (void *p : blocks) {
+        ctx.free_bytes(p);
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 12: A smaller TLS cell cache moves and retains smaller magazines
+TEST(ConfiguredCellMagazines) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.tls_cache_capacity = 8;
+
+    Cell::Context ctx(config);
+    const size_t count = Cell::kCellsPerSuperblock * 2;
+    std::vector<Cell::CellData *> cells;
+
+    for (size_t i = 0; i < count; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+
+    // Free on another thread so every cell goes through magazine spills
+    std::thread consumer([&ctx, &cells]() {
+        for (size_t i = 1; i < cells.size(); ++i) {
+            ctx.free_cell(cells[i]);
+        }
+        ctx.flush_tls_caches();
+    });
+    consumer.join();
+
+    // The depot retains kRetainedCellMagazines magazines of 4 cells
+    size_t retained = Cell::kRetainedCellMagazines * (config.tls_cache_capacity / 2);
+    ctx.decommit_unused();
+    assert(ctx.committed_bytes() == (1 + retained) * Cell::kCellSize);
+
+    ctx.free_cell(cells[0]);
+    ctx.decommit_unused();
+    assert(ctx.committed_bytes() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 13: Two Contexts used from one thread keep their cells apart
+TEST(TwoContextsOneThread) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    Cell::Context a(config);
+    Cell::Context b(config);
+
+    // Enough cells to spill magazines to each depot and refill from it
+    constexpr size_t kCells = 300;
+    std::vector<Cell::CellData *> cells_a;
+    std::vector<Cell::CellData *> cells_b;
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < kCells; ++i) {
+            cells_a.push_back(a.alloc_cell(0));
+            cells_b.push_back(b.alloc_cell(0));
+            assert(cells_a.back() != nullptr && cells_b.back() != nullptr);
+        }
+        for (size_t i = 0; i < kCells; ++i) {
+            a.free_cell(cells_a[i]);
+            b.free_cell(cells_b[i]);
+        }
+        cells_a.clear();
+        cells_b.clear();
+    }
+
+    // Each Context got back all of its own cells, so both can release everything
+    a.trim(Cell::PressureLevel::kCritical);
+    assert(a.committed_bytes() == 0);
+    b.trim(Cell::PressureLevel::kCritical);
+    assert(b.committed_bytes() == 0);
+
+    printf("  PASSED\n");
+}
+
 int main() {
     // When run under CTest (or other runners), stdout is often fully buffered.
     // Disable buffering so we see the last test name before an AV.
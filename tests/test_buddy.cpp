@@ -1,6 +1,7 @@
 #include "cell/context.h"
 
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <thread>
@@ -224,7 +225,31 @@ TEST(LargeStress) {
     printf("  PASSED\n");
 }
 
-#include <cstdlib> // For malloc/free
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// BuddyAllocator commits superblocks out of a reserved (inaccessible) range,
+// so direct tests need the same kind of reservation a Context makes.
+static void *reserve_region(size_t size) {
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *base = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return base == MAP_FAILED ? nullptr : base;
+#endif
+}
+
+static void release_region(void *base, size_t size) {
+#if defined(_WIN32)
+    (void)size;
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, size);
+#endif
+}
 
 // =============================================================================
 // Realloc Tests (Direct BuddyAllocator)
@@ -233,7 +258,7 @@ TEST(LargeStress) {
 // Test 9: Realloc - In-place same order
 TEST(ReallocInPlace) {
     const size_t size = 64 * 1024 * 1024;
-    void *base = std::malloc(size);
+    void *base = reserve_region(size);
     Cell::BuddyAllocator buddy(base, size);
 
     // Alloc 40KB (order 16, 64KB block)
@@ -246,14 +271,14 @@ TEST(ReallocInPlace) {
     assert(p2 == p && "Should have expanded in-place");
 
     buddy.free(p2);
-    std::free(base);
+    release_region(base, size);
     printf("  PASSED\n");
 }
 
 // Test 10: Realloc - Grow to next order with buddy merge
 TEST(ReallocBuddyMerge) {
     const size_t size = 64 * 1024 * 1024;
-    void *base = std::malloc(size);
+    void *base = reserve_region(size);
     Cell::BuddyAllocator buddy(base, size);
 
     // Alloc two 32KB blocks to get neighbors
@@ -287,14 +312,14 @@ TEST(ReallocBuddyMerge) {
     }
 
     buddy.free(p3);
-    std::free(base);
+    release_region(base, size);
     printf("  PASSED\n");
 }
 
 // Test 11: Realloc - Fallback (alloc+copy+free)
 TEST(ReallocFallback) {
     const size_t size = 64 * 1024 * 1024;
-    void *base = std::malloc(size);
+    void *base = reserve_region(size);
     Cell::BuddyAllocator buddy(base, size);
 
     // Alloc 32KB
@@ -318,14 +343,14 @@ TEST(ReallocFallback) {
 
     buddy.free(p2);
     buddy.free(p3);
-    std::free(base);
+    release_region(base, size);
     printf("  PASSED\n");
 }
 
 // Test 12: Realloc - Shrink
 TEST(ReallocShrink) {
     const size_t size = 64 * 1024 * 1024;
-    void *base = std::malloc(size);
+    void *base = reserve_region(size);
     Cell::BuddyAllocator buddy(base, size);
 
     // Alloc 100KB (order 17, 128KB)
@@ -343,7 +368,179 @@ TEST(ReallocShrink) {
     }
 
     buddy.free(p2);
-    std::free(base);
+    release_region(base, size);
+    printf("  PASSED\n");
+}
+
+// Test 13: Superblocks are committed on demand
+TEST(BuddyLazyCommit) {
+    const size_t size = 64 * 1024 * 1024;
+    void *base = reserve_region(size);
+    assert(base != nullptr);
+    Cell::BuddyAllocator buddy(base, size);
+
+    // Nothing is committed until the first allocation
+    assert(buddy.bytes_committed() == 0);
+
+    void *p = buddy.alloc(64 * 1024);
+    assert(p != nullptr);
+    std::memset(p, 0x42, 64 * 1024);
+    assert(buddy.bytes_committed() == Cell::BuddyAllocator::kDefaultMaxBlockSize);
+
+    buddy.free(p);
+    release_region(base, size);
+    printf("  PASSED\n");
+}
+
+// Test 14: Many default-sized Contexts can coexist in one process
+TEST(ManyContextsCoexist) {
+    constexpr size_t kContexts = 16;
+    std::vector<Cell::Context *> contexts;
+    std::vector<void *> blocks;
+
+    for (size_t i = 0; i < kContexts; ++i) {
+        auto *ctx = new Cell::Context();
+        void *p = ctx->alloc_bytes(256 * 1024, 1);
+        assert(p != nullptr && "Buddy reservation should not consume commit charge");
+        std::memset(p, static_cast<int>(i), 256 * 1024);
+        contexts.push_back(ctx);
+        blocks.push_back(p);
+    }
+
+    for (size_t i = 0; i < kContexts; ++i) {
+        contexts[i]->free_bytes(blocks[i]);
+        delete contexts[i];
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 15: A raised max order serves multi-megabyte blocks
+TEST(BuddyRaisedMaxOrder) {
+    const size_t size = 64 * 1024 * 1024;
+    void *base = reserve_region(size);
+    assert(base != nullptr);
+    Cell::BuddyAllocator buddy(base, size, 24);
+    assert(buddy.max_block_size() == 16 * 1024 * 1024);
+
+    // 8MB plus header rounds up to a 16MB block
+    void *p1 = buddy.alloc(8 * 1024 * 1024);
+    assert(p1 != nullptr);
+    assert(buddy.get_alloc_size(p1) == 16 * 1024 * 1024);
+    std::memset(p1, 0x11, 8 * 1024 * 1024);
+
+    // A block larger than the max order is refused rather than truncated
+    assert(buddy.alloc(20 * 1024 * 1024) == nullptr);
+    assert(buddy.block_size_for(16 * 1024 * 1024) == 0);
+
+    // A 3MB request takes a 4MB block from a separate superblock
+    void *p2 = buddy.alloc(3 * 1024 * 1024);
+    assert(p2 != nullptr);
+    assert(buddy.get_alloc_size(p2) == 4 * 1024 * 1024);
+
+    buddy.free(p1);
+    buddy.free(p2);
+
+    // Both superblocks coalesce back to whole max-order blocks
+    void *p3 = buddy.alloc(16 * 1024 * 1024 - 64);
+    assert(p3 != nullptr);
+    buddy.free(p3);
+
+    release_region(base, size);
+    printf("  PASSED\n");
+}
+
+// Test 16: Contexts route to the buddy tier up to the configured max order
+TEST(ContextBuddyMaxOrder) {
+    Cell::Config config;
+    config.buddy_max_order = 24;
+    Cell::Context ctx(config);
+
+    std::vector<void *> blocks;
+    for (size_t mb = 4; mb <= 12; mb += 4) {
+        void *p = ctx.alloc_bytes(mb * 1024 * 1024, 1);
+        assert(p != nullptr);
+        std::memset(p, static_cast<int>(mb), mb * 1024 * 1024);
+        blocks.push_back(p);
+    }
+
+    // Above the max block size requests fall back to direct OS mappings
+    void *big = ctx.alloc_bytes(16 * 1024 * 1024, 1);
+    assert(big != nullptr);
+    std::memset(big, 0x5A, 16 * 1024 * 1024);
+
+    void *grown = ctx.realloc_bytes(blocks[0], 10 * 1024 * 1024, 1);
+    assert(grown != nullptr);
+    assert(static_cast<unsigned char *>(grown)[4 * 1024 * 1024 - 1] == 4);
+    blocks[0] = grown;
+
+    for (void *p : blocks) {
+        ctx.free_bytes(p);
+    }
+    ctx.free_bytes(big);
+
+    printf("  PASSED\n");
+}
+
+// Test 17: Prewarming commits whole superblocks up to the reservation
+TEST(BuddyPrewarm) {
+    const size_t size = 16 * 1024 * 1024;
+    void *base = reserve_region(size);
+    assert(base != nullptr);
+    Cell::BuddyAllocator buddy(base, size);
+    const size_t superblock = buddy.max_block_size();
+
+    assert(buddy.prewarm(superblock + 1) == 2 * superblock);
+    assert(buddy.bytes_committed() == 2 * superblock);
+    assert(buddy.prewarm(superblock) == 0);
+
+    // Prewarmed blocks are usable and coalesce as usual
+    void *p1 = buddy.alloc(superblock - 64);
+    void *p2 = buddy.alloc(superblock - 64);
+    assert(p1 != nullptr && p2 != nullptr);
+    std::memset(p1, 0x21, superblock - 64);
+    std::memset(p2, 0x42, superblock - 64);
+    assert(buddy.bytes_committed() == 2 * superblock);
+    buddy.free(p1);
+    buddy.free(p2);
+
+    // A target beyond the reservation commits what is left
+    assert(buddy.prewarm(size * 2) == size - 2 * superblock);
+    assert(buddy.bytes_committed() == size);
+
+    release_region(base, size);
+    printf("  PASSED\n");
+}
+
+// Test 18: Sizes near SIZE_MAX are rejected instead of wrapping to a small order
+TEST(BuddyHugeSizeRejected) {
+    const size_t size = 16 * 1024 * 1024;
+    void *base = reserve_region(size);
+    assert(base != nullptr);
+    Cell::BuddyAllocator buddy(base, size);
+
+    assert(buddy.block_size_for(SIZE_MAX - 3) == 0);
+    assert(buddy.block_size_for(buddy.max_block_size()) == 0);
+    assert(buddy.alloc(SIZE_MAX - 3) == nullptr);
+
+    void *p = buddy.alloc(64 * 1024);
+    assert(p != nullptr);
+    assert(buddy.realloc_bytes(p, SIZE_MAX - 3) == nullptr);
+    assert(buddy.get_alloc_size(p) == 128 * 1024 && "Failed realloc leaves the block alone");
+    buddy.free(p);
+    release_region(base, size);
+
+    // Context routing must not send them to the buddy tier either
+    Cell::Context ctx;
+    assert(ctx.alloc_bytes(SIZE_MAX - 3) == nullptr);
+    assert(ctx.alloc_large(SIZE_MAX - 3) == nullptr);
+    assert(ctx.alloc_aligned(SIZE_MAX - 100, 4 * 1024 * 1024) == nullptr);
+
+    void *q = ctx.alloc_bytes(64 * 1024);
+    assert(q != nullptr);
+    assert(ctx.realloc_bytes(q, SIZE_MAX - 3) == nullptr);
+    ctx.free_bytes(q);
+
     printf("  PASSED\n");
 }
 
@@ -356,7 +553,7 @@ int main() {
     printf("=================================\n");
     printf("Configuration:\n");
     printf("  Buddy min size: %zuKB\n", Cell::BuddyAllocator::kMinBlockSize / 1024);
-    printf("  Buddy max size: %zuMB\n", Cell::BuddyAllocator::kMaxBlockSize / (1024 * 1024));
+    printf("  Buddy max size: %zuMB\n", Cell::BuddyAllocator::kDefaultMaxBlockSize / (1024 * 1024));
     printf("  Large alloc min: %zuMB\n", Cell::LargeAllocRegistry::kMinLargeSize / (1024 * 1024));
     printf("\n");
 
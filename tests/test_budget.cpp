@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <thread>
 #include <vector>
 
 // Simple test helper
@@ -186,6 +187,355 @@ TEST(BudgetRuntimeChange) {
     printf("  PASSED\n");
 }
 
+// Test 6: Threads spend local credit; usage stays exact and the limit within slack
+TEST(BudgetThreadCredits) {
+    constexpr size_t kBudget = 256 * 1024;
+    constexpr size_t kSlack = 8 * 1024;
+    constexpr int kThreads = 4;
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.memory_budget = kBudget;
+    config.budget_slack = kSlack;
+
+    Cell::Context ctx(config);
+    assert(ctx.get_budget_slack() == kSlack);
+
+    // Bytes charged per 64B request (guard bytes can move it up a size class)
+    void *probe = ctx.alloc_bytes(64);
+    size_t block_charge = ctx.get_budget_current();
+    assert(block_charge >= 64);
+    ctx.free_bytes(probe);
+    assert(ctx.get_budget_current() == 0 && "Usage excludes the thread's unspent credit");
+    ctx.flush_tls_caches(); // Hand the main thread's credit back before the workers start
+
+    std::vector<std::vector<void *>> ptrs(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, &ptrs, t]() {
+            while (void *p = ctx.alloc_bytes(64)) {
+                ptrs[t].push_back(p);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    size_t blocks = 0;
+    for (const auto &list : ptrs) {
+        blocks += list.size();
+    }
+    size_t used = ctx.get_budget_current();
+    printf("  %zu blocks, %zuKB of %zuKB used\n", blocks, used / 1024, kBudget / 1024);
+    assert(used == blocks * block_charge && "Usage must match live blocks exactly");
+    assert(used <= kBudget && "Budget must not be exceeded");
+    assert(used + kThreads * kSlack >= kBudget && "Failures must be within slack of the limit");
+
+    // Exited threads' credit is reclaimed, so the main thread can use it
+    void *p = ctx.alloc_bytes(64);
+    if (used + block_charge <= kBudget) {
+        assert(p != nullptr && "Reclaimed credit should satisfy the allocation");
+    }
+    ctx.free_bytes(p);
+
+    for (const auto &list : ptrs) {
+        for (void *q : list) {
+            ctx.free_bytes(q);
+        }
+    }
+    assert(ctx.get_budget_current() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 7: Batch and fixed-size paths charge the budget like alloc_bytes
+TEST(BudgetBatchAndFixed) {
+    constexpr size_t kBudget = 64 * 64;
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.memory_budget = kBudget;
+    config.budget_slack = 0; // Exact accounting
+
+    Cell::Context ctx(config);
+
+    // A batch larger than the budget is filled as far as the budget allows
+    void *batch[100];
+    size_t got = ctx.alloc_batch(64, batch, 100);
+    assert(got == kBudget / 64 && "Batch should stop at the budget");
+    assert(ctx.get_budget_current() == kBudget);
+    assert(ctx.alloc_fixed<64>() == nullptr && "alloc_fixed must respect the budget");
+
+    ctx.free_batch(batch, got);
+    assert(ctx.get_budget_current() == 0);
+
+    std::vector<void *> fixed;
+    while (void *p = ctx.alloc_fixed<64>()) {
+        fixed.push_back(p);
+    }
+    assert(!fixed.empty());
+    assert(ctx.get_budget_current() <= kBudget);
+    for (void *p : fixed) {
+        ctx.free_fixed<64>(p);
+    }
+    assert(ctx.get_budget_current() == 0);
+
+    // A slack set at runtime takes effect at the next refill
+    ctx.set_budget_slack(1024);
+    assert(ctx.get_budget_slack() == 1024);
+    void *p = ctx.alloc_fixed<64>();
+    assert(p != nullptr && ctx.get_budget_current() > 0);
+    ctx.free_fixed<64>(p);
+    assert(ctx.get_budget_current() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 8: Per-tag budgets and usage
+static uint8_t g_tag_callback_tag = 0;
+static size_t g_tag_callback_budget = 0;
+
+void tag_budget_callback(uint8_t tag, size_t /*requested*/, size_t budget, size_t /*current*/) {
+    g_tag_callback_tag = tag;
+    g_tag_callback_budget = budget;
+}
+
+TEST(TagBudgets) {
+    constexpr uint8_t kLimited = 3;
+    constexpr uint8_t kOther = 4;
+    constexpr size_t kTagBudget = 4096;
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    ctx.set_tag_budget(kLimited, kTagBudget);
+    ctx.set_tag_budget_callback(kLimited, tag_budget_callback);
+    assert(ctx.get_tag_budget(kLimited) == kTagBudget);
+    assert(ctx.get_tag_budget(kOther) == 0);
+
+    std::vector<void *> limited;
+    while (void *p = ctx.alloc_bytes(64, kLimited)) {
+        limited.push_back(p);
+    }
+    size_t used = ctx.get_tag_budget_current(kLimited);
+    printf("  tag %u: %zu blocks, %zu of %zu bytes\n", kLimited, limited.size(), used, kTagBudget);
+    assert(!limited.empty() && used <= kTagBudget && used + 256 > kTagBudget);
+    assert(g_tag_callback_tag == kLimited && g_tag_callback_budget == kTagBudget);
+
+    // Other tags and the Context budget are unaffected
+    void *other = ctx.alloc_bytes(64, kOther);
+    assert(other != nullptr && "An unrelated tag should still allocate");
+    assert(ctx.get_tag_budget_current(kOther) > 0);
+    assert(ctx.get_budget_current() == used + ctx.get_tag_budget_current(kOther));
+
+    // Frees credit the allocation's tag even when they share cells or come from another thread
+    std::thread([&ctx, &limited]() {
+        for (void *p : limited) {
+            ctx.free_bytes(p);
+        }
+    }).join();
+    assert(ctx.get_tag_budget_current(kLimited) == 0);
+    assert(ctx.get_tag_budget_current(kOther) > 0);
+    void *again = ctx.alloc_fixed<64>(kLimited);
+    assert(again != nullptr && "Freed bytes are available again");
+    ctx.free_fixed<64>(again);
+    ctx.free_bytes(other);
+    assert(ctx.get_tag_budget_current(kOther) == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 8b: Block tags follow their superblocks through decommit and recommit
+TEST(TagsAcrossDecommit) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.budget_slack = 0;
+
+    Cell::Context ctx(config);
+    size_t cell = ctx.cell_size();
+
+    // Whole cells spanning more than one superblock
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 200; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(cell - 64, 5));
+        assert(ptrs.back() != nullptr);
+    }
+    assert(ctx.get_tag_budget_current(5) == 200 * cell);
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    ctx.flush_tls_caches();
+    assert(ctx.decommit_unused() > 0);
+    assert(ctx.get_tag_budget_current(5) == 0);
+
+    ptrs.clear();
+    for (int i = 0; i < 200; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(cell - 64, 6));
+        assert(ptrs.back() != nullptr);
+    }
+    assert(ctx.get_tag_budget_current(6) == 200 * cell);
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(ctx.get_tag_budget_current(6) == 0 && ctx.get_tag_budget_current(5) == 0);
+
+    printf("  PASSED\n");
+}
+// Test 9: Tag budgets apply to batches and to buddy allocations
+TEST(TagBudgetBatchAndLarge) {
+    constexpr uint8_t kTag = 9;
+
+    Cell::Config config;
+    config.reserve_size = 128 * 1024 * 1024;
+    config.budget_slack = 0;
+
+    Cell::Context ctx(config);
+    ctx.set_tag_budget(kTag, 64 * 64);
+
+    void *batch[100];
+    size_t got = ctx.alloc_batch(64, batch, 100, kTag);
+    assert(got == 64 && "Batch should stop at the tag budget");
+    assert(ctx.get_tag_budget_current(kTag) == 64 * 64);
+    ctx.free_batch(batch, got);
+    assert(ctx.get_tag_budget_current(kTag) == 0);
+
+    // 512KB buddy requests take 1MB blocks (header included)
+    ctx.set_tag_budget(kTag, 1024 * 1024);
+    void *p1 = ctx.alloc_bytes(512 * 1024, kTag);
+    assert(p1 != nullptr);
+    assert(ctx.get_tag_budget_current(kTag) == 1024 * 1024);
+    assert(ctx.alloc_bytes(512 * 1024, kTag) == nullptr && "Second block exceeds the tag");
+    void *p2 = ctx.alloc_bytes(512 * 1024, kTag + 1);
+    assert(p2 != nullptr && "Other tags are not limited");
+
+    ctx.free_bytes(p1);
+    ctx.free_large(p2);
+    assert(ctx.get_tag_budget_current(kTag) == 0);
+    assert(ctx.get_tag_budget_current(kTag + 1) == 0);
+    assert(ctx.get_budget_current() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 10: Crossing the soft budget runs the pressure callback once per crossing
+static int g_pressure_calls = 0;
+static size_t g_pressure_soft = 0;
+static size_t g_pressure_hard = 0;
+
+void pressure_callback(size_t soft, size_t hard, size_t /*current*/) {
+    ++g_pressure_calls;
+    g_pressure_soft = soft;
+    g_pressure_hard = hard;
+}
+
+TEST(SoftBudgetPressure) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.memory_budget = 1024 * 1024;
+    config.soft_memory_budget = 256 * 1024;
+    config.budget_slack = 0;
+
+    Cell::Context ctx(config);
+    assert(ctx.get_soft_budget() == 256 * 1024);
+    ctx.set_budget_pressure_callback(pressure_callback);
+    g_pressure_calls = 0;
+
+    std::vector<void *> ptrs;
+    while (ctx.get_budget_current() <= 256 * 1024) {
+        ptrs.push_back(ctx.alloc_bytes(4096));
+        assert(ptrs.back() != nullptr);
+    }
+    assert(g_pressure_calls == 1 && "Crossing the soft budget runs the pipeline");
+    assert(g_pressure_soft == 256 * 1024 && g_pressure_hard == 1024 * 1024);
+
+    // Staying above the soft budget does not run it again
+    for (int i = 0; i < 16; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(4096));
+        assert(ptrs.back() != nullptr && "The soft budget never fails allocations");
+    }
+    assert(g_pressure_calls == 1);
+
+    // Dropping back under the soft budget re-arms it
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    ptrs.clear();
+    while (ctx.get_budget_current() <= 256 * 1024) {
+        ptrs.push_back(ctx.alloc_bytes(4096));
+    }
+    assert(g_pressure_calls == 2 && "A second crossing runs the pipeline again");
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 11: At the hard limit, the pressure callback can free memory for the allocation
+static Cell::Context *g_pressure_ctx = nullptr;
+static std::vector<void *> g_pressure_cache;
+static bool g_pressure_release = false;
+
+void releasing_pressure_callback(size_t /*soft*/, size_t /*hard*/, size_t /*current*/) {
+    ++g_pressure_calls;
+    if (g_pressure_release) {
+        for (void *p : g_pressure_cache) {
+            g_pressure_ctx->free_bytes(p);
+        }
+        g_pressure_cache.clear();
+    }
+}
+
+TEST(HardBudgetAfterPressure) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.memory_budget = 64 * 1024;
+    config.soft_memory_budget = 32 * 1024;
+    config.budget_slack = 0;
+
+    Cell::Context ctx(config);
+    ctx.set_budget_pressure_callback(releasing_pressure_callback);
+    ctx.set_budget_callback(budget_callback);
+    g_pressure_ctx = &ctx;
+    g_pressure_calls = 0;
+    g_pressure_release = false;
+    g_callback_invoked = false;
+
+    // Fill the hard budget with memory the callback could give back
+    while (void *p = ctx.alloc_bytes(4096)) {
+        g_pressure_cache.push_back(p);
+    }
+    assert(ctx.get_budget_current() + 4096 > 64 * 1024);
+    assert(g_pressure_calls == 2 && "Soft crossing, then the failed allocation");
+    assert(g_callback_invoked && "The allocation failed at the hard limit");
+
+    // The retry after the pipeline succeeds once the callback frees memory
+    g_pressure_release = true;
+    g_callback_invoked = false;
+    void *p = ctx.alloc_bytes(4096);
+    assert(p != nullptr && "Pipeline made room below the hard limit");
+    assert(g_pressure_cache.empty() && !g_callback_invoked);
+    ctx.free_bytes(p);
+
+    // Buddy allocations go through the same pipeline
+    g_pressure_release = false;
+    void *big = ctx.alloc_bytes(40 * 1024);
+    assert(big != nullptr);
+    g_pressure_cache.push_back(big);
+    assert(ctx.alloc_bytes(40 * 1024) == nullptr);
+    g_pressure_release = true;
+    void *big2 = ctx.alloc_bytes(40 * 1024);
+    assert(big2 != nullptr && g_pressure_cache.empty());
+    ctx.free_bytes(big2);
+    assert(ctx.get_budget_current() == 0);
+
+    g_pressure_ctx = nullptr;
+    printf("  PASSED\n");
+}
+
 #else
 
 // When budget is disabled, just report that
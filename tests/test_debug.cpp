@@ -6,10 +6,13 @@
  */
 
 #include <cell/context.h>
+#include <cell/stack_depot.h>
 
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 using namespace Cell;
 
@@ -165,6 +168,185 @@ void test_no_false_positives() {
     std::printf("OK\n");
     TEST_PASS();
 }
+
+void test_leak_tracking_threads() {
+    std::printf("  test_leak_tracking_threads... ");
+
+    Context ctx;
+    constexpr int kThreads = 4;
+    constexpr size_t kPerThread = 20000; // Grows every shard of the table several times
+
+    std::vector<std::vector<void *>> ptrs(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, &ptrs, t]() {
+            for (size_t i = 0; i < kPerThread; ++i) {
+                ptrs[t].push_back(ctx.alloc_bytes(16 + (i % 64) * 16));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT(ctx.live_allocation_count() == kThreads * kPerThread);
+
+    // Free every other block from another thread, then the rest
+    threads.clear();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, &ptrs, t]() {
+            std::vector<void *> &mine = ptrs[(t + 1) % kThreads];
+            for (size_t i = 0; i < mine.size(); i += 2) {
+                ctx.free_bytes(mine[i]);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT(ctx.live_allocation_count() == kThreads * kPerThread / 2);
+
+    for (auto &mine : ptrs) {
+        for (size_t i = 1; i < mine.size(); i += 2) {
+            ctx.free_bytes(mine[i]);
+        }
+    }
+    TEST_ASSERT(ctx.live_allocation_count() == 0);
+
+    // Realloc moves the record to the new pointer
+    void *p = ctx.alloc_bytes(100000);
+    p = ctx.realloc_bytes(p, 200000);
+    TEST_ASSERT(p != nullptr && ctx.live_allocation_count() == 1);
+    ctx.free_bytes(p);
+    TEST_ASSERT(ctx.live_allocation_count() == 0);
+
+    std::printf("OK\n");
+    TEST_PASS();
+}
+#endif
+
+// ============================================================================
+// Stack Depot Tests
+// ============================================================================
+
+#ifdef CELL_DEBUG_STACKTRACE
+#if defined(__GNUC__)
+#define TEST_NOINLINE __attribute__((noinline))
+#else
+#define TEST_NOINLINE
+#endif
+
+/** @brief Captures a trace whose innermost frame is the call site of this helper. */
+TEST_NOINLINE static StackId capture_from_here() { return capture_stack_id(0); }
+
+void test_stack_depot_dedup() {
+    std::printf("  test_stack_depot_dedup... ");
+
+    StackDepot &depot = StackDepot::instance();
+    void *a[] = {reinterpret_cast<void *>(0x1000), reinterpret_cast<void *>(0x2000),
+                 reinterpret_cast<void *>(0x3000)};
+    void *b[] = {reinterpret_cast<void *>(0x1000), reinterpret_cast<void *>(0x2000),
+                 reinterpret_cast<void *>(0x4000)};
+
+    size_t before = depot.unique_stacks();
+    StackId id_a = depot.put(a, 3);
+    StackId id_b = depot.put(b, 3);
+    StackId id_prefix = depot.put(a, 2);
+    TEST_ASSERT(id_a != kInvalidStackId && id_b != kInvalidStackId);
+    TEST_ASSERT(id_a != id_b && id_a != id_prefix && id_b != id_prefix);
+    TEST_ASSERT(depot.put(a, 3) == id_a);
+    TEST_ASSERT(depot.unique_stacks() == before + 3);
+    TEST_ASSERT(depot.memory_usage() >= kStackDepotChunkSize);
+
+    StackDepot::StackTrace trace = depot.get(id_b);
+    TEST_ASSERT(trace.depth == 3);
+    TEST_ASSERT(std::memcmp(trace.frames, b, sizeof(b)) == 0);
+
+    TEST_ASSERT(depot.put(a, 0) == kInvalidStackId);
+    TEST_ASSERT(depot.get(kInvalidStackId).depth == 0);
+
+    std::printf("OK\n");
+    TEST_PASS();
+}
+
+void test_stack_depot_threads() {
+    std::printf("  test_stack_depot_threads... ");
+
+    // Every thread stores the same traces; each must map to a single ID
+    constexpr int kThreads = 4;
+    constexpr uintptr_t kTraces = 500;
+    std::vector<std::vector<StackId>> ids(kThreads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ids, t]() {
+            for (uintptr_t i = 0; i < kTraces; ++i) {
+                void *frames[] = {reinterpret_cast<void *>(0xD0000000 + i * 16),
+                                  reinterpret_cast<void *>(0xE0000000)};
+                ids[t].push_back(StackDepot::instance().put(frames, 2));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 1; t < kThreads; ++t) {
+        TEST_ASSERT(ids[t] == ids[0]);
+    }
+    for (uintptr_t i = 0; i < kTraces; ++i) {
+        StackDepot::StackTrace trace = StackDepot::instance().get(ids[0][i]);
+        TEST_ASSERT(trace.depth == 2);
+        TEST_ASSERT(trace.frames[0] == reinterpret_cast<void *>(0xD0000000 + i * 16));
+    }
+
+    std::printf("OK\n");
+    TEST_PASS();
+}
+
+void test_capture_stack_id_sites() {
+    std::printf("  test_capture_stack_id_sites... ");
+
+    // volatile keeps the loop from being unrolled into two call sites
+    StackId ids[2];
+    for (volatile int i = 0; i < 2; ++i) {
+        ids[i] = capture_from_here();
+    }
+    StackId other = capture_from_here();
+
+    TEST_ASSERT(ids[0] != kInvalidStackId);
+    TEST_ASSERT(ids[0] == ids[1] && "Same call site should reuse its trace");
+    TEST_ASSERT(other != ids[0] && "A different call site is a different trace");
+    TEST_ASSERT(StackDepot::instance().get(other).depth > 1);
+
+    std::printf("OK\n");
+    TEST_PASS();
+}
+
+#ifdef CELL_DEBUG_LEAKS
+void test_leak_traces_shared() {
+    std::printf("  test_leak_traces_shared... ");
+
+    Context ctx;
+    std::vector<void *> ptrs;
+    ctx.free_bytes(ctx.alloc_bytes(64)); // Store this site's traces first
+
+    size_t before = StackDepot::instance().unique_stacks();
+    for (int i = 0; i < 1000; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(64));
+    }
+    TEST_ASSERT(ctx.live_allocation_count() == 1000);
+    TEST_ASSERT(StackDepot::instance().unique_stacks() - before <= 1 &&
+                "Allocations from one site share a depot entry");
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    TEST_ASSERT(ctx.live_allocation_count() == 0);
+
+    std::printf("OK\n");
+    TEST_PASS();
+}
+#endif
 #endif
 
 // ============================================================================
@@ -277,6 +459,17 @@ int main() {
     test_leak_count_tracks_allocations();
     test_leak_count_different_sizes();
     test_no_false_positives();
+    test_leak_tracking_threads();
+#endif
+
+#ifdef CELL_DEBUG_STACKTRACE
+    std::printf("\nStack depot tests:\n");
+    test_stack_depot_dedup();
+    test_stack_depot_threads();
+    test_capture_stack_id_sites();
+#ifdef CELL_DEBUG_LEAKS
+    test_leak_traces_shared();
+#endif
 #endif
 
 #if defined(CELL_DEBUG_GUARDS) && defined(CELL_DEBUG_LEAKS)
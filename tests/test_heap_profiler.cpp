@@ -0,0 +1,283 @@
+#include "cell/context.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simple test helper
+#define TEST(name)                                                                                 \
+    void test_##name();                                                                            \
+    struct Register##name {                                                                        \
+        Register##name() { tests.push_back({#name, test_##name}); }                                \
+    } reg_##name;                                                                                  \
+    void test_##name()
+
+struct TestCase {
+    const char *name;
+    void (*fn)();
+};
+std::vector<TestCase> tests;
+
+// =============================================================================
+// Heap Profiler Tests (only run when CELL_ENABLE_HEAP_PROFILER is defined)
+// =============================================================================
+
+#ifdef CELL_ENABLE_HEAP_PROFILER
+
+namespace {
+    Cell::Config profiler_config(size_t interval) {
+        Cell::Config config;
+        config.reserve_size = 256 * 1024 * 1024;
+        config.heap_sample_interval = interval;
+        return config;
+    }
+
+    /** @brief Parses "heap profile: a: b [ c: d]" into its four totals. */
+    void parse_header(const std::string &profile, size_t totals[4]) {
+        int n = std::sscanf(profile.c_str(), "heap profile: %zu: %zu [ %zu: %zu]", &totals[0],
+                            &totals[1], &totals[2], &totals[3]);
+        assert(n == 4 && "Profile must start with a heap profile header");
+        (void)n;
+    }
+} // namespace
+
+// Test 1: Samples track the byte-based rate and leave the profile when freed
+TEST(SamplingRate) {
+    Cell::Context ctx(profiler_config(4096));
+    Cell::HeapProfiler &profiler = ctx.heap_profiler();
+    assert(profiler.sample_interval() == 4096);
+
+    // 64B blocks are sampled with probability 1 - exp(-64/4096), about 1.55%
+    constexpr size_t kCount = 10000;
+    std::vector<void *> ptrs(kCount);
+    for (size_t i = 0; i < kCount; ++i) {
+        ptrs[i] = ctx.alloc_bytes(64, 1);
+        assert(ptrs[i] != nullptr);
+    }
+
+    size_t live = profiler.live_sample_count();
+    printf("  %zu of %zu allocations sampled (expected ~155)\n", live, kCount);
+    assert(live >= 80 && live <= 260 && "Sample count should follow the interval");
+    assert(profiler.sample_count() == live);
+
+    size_t totals[4];
+    parse_header(profiler.profile(), totals);
+    assert(totals[0] == live && totals[1] == live * 64);
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(profiler.live_sample_count() == 0 && "Frees must remove sampled allocations");
+
+    parse_header(profiler.profile(), totals);
+    assert(totals[0] == 0 && totals[1] == 0 && "No bytes should remain in use");
+    assert(totals[2] == live && "Cumulative counts outlive the frees");
+
+    printf("  PASSED\n");
+}
+
+// Test 2: Output is in the legacy pprof heap format
+TEST(PprofFormat) {
+    Cell::Context ctx(profiler_config(1024));
+
+    // Large allocations cross the sample point almost surely
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 8; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(64 * 1024));
+    }
+
+    std::string profile = ctx.heap_profiler().profile();
+    assert(profile.rfind("heap profile: ", 0) == 0);
+    assert(profile.find("] @ heap_v2/1024\n") != std::string::npos);
+
+    // Every sample line lists its stack as hex return addresses
+    size_t line_start = profile.find('\n') + 1;
+    size_t line_end = profile.find('\n', line_start);
+    std::string line = profile.substr(line_start, line_end - line_start);
+    printf("  %s\n", line.c_str());
+    assert(line.find(" [") != std::string::npos);
+    assert(line.find("] @ 0x") != std::string::npos && "Samples need a captured stack");
+
+#if defined(__linux__)
+    assert(profile.find("\nMAPPED_LIBRARIES:\n") != std::string::npos);
+#endif
+
+    const char *path = "test_heap_profiler.heap";
+    assert(ctx.heap_profiler().write_profile(path));
+    std::FILE *file = std::fopen(path, "r");
+    assert(file != nullptr);
+    char head[32] = {};
+    size_t read = std::fread(head, 1, sizeof(head) - 1, file);
+    std::fclose(file);
+    std::remove(path);
+    assert(read > 0 && std::strncmp(head, "heap profile: ", 14) == 0);
+    (void)read;
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(ctx.heap_profiler().live_sample_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 3: reset() starts a new allocation window but keeps live samples
+TEST(ResetKeepsLiveSamples) {
+    Cell::Context ctx(profiler_config(2048));
+    Cell::HeapProfiler &profiler = ctx.heap_profiler();
+
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 2000; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(256));
+    }
+    size_t live = profiler.live_sample_count();
+    assert(live > 0);
+
+    profiler.reset();
+    assert(profiler.sample_count() == 0);
+    assert(profiler.live_sample_count() == live);
+
+    size_t totals[4];
+    parse_header(profiler.profile(), totals);
+    assert(totals[0] == live && totals[1] == live * 256);
+    assert(totals[2] == 0 && totals[3] == 0 && "Allocation window should be empty");
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(profiler.live_sample_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 4: alloc_fixed and alloc_batch are sampled; their frees are tracked
+TEST(FixedAndBatchPaths) {
+    Cell::Context ctx(profiler_config(1024));
+    Cell::HeapProfiler &profiler = ctx.heap_profiler();
+
+    std::vector<void *> fixed;
+    for (int i = 0; i < 1000; ++i) {
+        fixed.push_back(ctx.alloc_fixed<128>());
+    }
+    size_t fixed_samples = profiler.live_sample_count();
+    assert(fixed_samples > 0 && "alloc_fixed must charge the sampling countdown");
+
+    constexpr size_t kBatch = 512;
+    void *batch[kBatch];
+    size_t got = ctx.alloc_batch(128, batch, kBatch);
+    assert(got == kBatch);
+    assert(profiler.live_sample_count() > fixed_samples && "alloc_batch should be sampled");
+
+    for (void *p : fixed) {
+        ctx.free_fixed<128>(p);
+    }
+    ctx.free_batch(batch, got);
+    assert(profiler.live_sample_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 5: Threads sample independently and free each other's samples
+TEST(MultiThreadedSampling) {
+    Cell::Context ctx(profiler_config(4096));
+    constexpr int kThreads = 4;
+    constexpr size_t kPerThread = 4000;
+
+    std::vector<std::vector<void *>> ptrs(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, &ptrs, t]() {
+            for (size_t i = 0; i < kPerThread; ++i) {
+                ptrs[t].push_back(ctx.alloc_bytes(16 + (i % 32) * 16));
+            }
+            ctx.flush_tls_caches();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    size_t live = ctx.heap_profiler().live_sample_count();
+    assert(live > 0);
+
+    // Free from a different thread than the allocating one
+    threads.clear();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, &ptrs, t]() {
+            for (void *p : ptrs[(t + 1) % kThreads]) {
+                ctx.free_bytes(p);
+            }
+            ctx.flush_tls_caches();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert(ctx.heap_profiler().live_sample_count() == 0);
+
+    printf("  %zu samples across %d threads\n", live, kThreads);
+    printf("  PASSED\n");
+}
+
+// Test 6: An interval of 0 stops sampling
+TEST(SamplingDisabled) {
+    Cell::Context ctx(profiler_config(0));
+    Cell::HeapProfiler &profiler = ctx.heap_profiler();
+
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 1000; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(64 * 1024));
+    }
+    assert(profiler.sample_count() == 0 && profiler.live_sample_count() == 0);
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+
+    printf("  PASSED\n");
+}
+
+#else
+
+// When the profiler is disabled, just report that
+TEST(HeapProfilerDisabled) {
+    printf("  CELL_ENABLE_HEAP_PROFILER not defined, heap profiler tests skipped\n");
+    printf("  PASSED\n");
+}
+
+#endif
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main() {
+    printf("Heap Profiler Tests\n");
+    printf("===================\n");
+#ifdef CELL_ENABLE_HEAP_PROFILER
+    printf("CELL_ENABLE_HEAP_PROFILER: ENABLED\n");
+#else
+    printf("CELL_ENABLE_HEAP_PROFILER: DISABLED\n");
+#endif
+    printf("\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    for (const auto &test : tests) {
+        printf("Running %s...\n", test.name);
+        try {
+            test.fn();
+            ++passed;
+        } catch (...) {
+            printf("  FAILED (exception)\n");
+            ++failed;
+        }
+    }
+
+    printf("\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+    return failed == 0 ? 0 : 1;
+}
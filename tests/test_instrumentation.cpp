@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <thread>
 #include <vector>
 
 // Simple test helper
@@ -176,6 +177,190 @@ TEST(RuntimeCallbackChange) {
     printf("  PASSED\n");
 }
 
+// Test 6: Free callbacks carry the block size and tag from metadata
+TEST(FreeCallbackMetadata) {
+    Cell::Config config;
+    config.reserve_size = 128 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    ctx.set_alloc_callback(alloc_callback);
+    reset_tracking();
+
+#ifdef CELL_DEBUG_GUARDS
+    constexpr size_t kSmallBlock = 256; // 100 bytes plus two 16-byte guards
+#else
+    constexpr size_t kSmallBlock = 128;
+#endif
+    void *small = ctx.alloc_bytes(100, 3);
+    ctx.free_bytes(small);
+    assert(g_last_size == kSmallBlock && "Sub-cell free reports its size class");
+    assert(g_last_tag == 3 && "Sub-cell free reports the cell's tag");
+
+    void *cell = ctx.alloc_bytes(12 * 1024, 4);
+    ctx.free_bytes(cell);
+    assert(g_last_size == ctx.cell_size() && g_last_tag == 4);
+
+    void *buddy = ctx.alloc_bytes(100 * 1024, 5);
+    assert(g_alloc_count == 3 && "alloc_bytes reports a buddy allocation once");
+    ctx.free_bytes(buddy);
+    assert(g_last_size == 128 * 1024 && "Buddy free reports the block size");
+    assert(g_last_tag == 5 && "Buddy free reports the header's tag");
+
+    void *large = ctx.alloc_large(8 * 1024 * 1024, 6);
+    ctx.free_large(large);
+    assert(g_last_size == 8 * 1024 * 1024 && g_last_tag == 6);
+    assert(g_alloc_count == 4 && g_free_count == 4);
+
+    printf("  PASSED\n");
+}
+
+// Test 7: Event stream records allocs and frees in order
+TEST(EventStream) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    assert(!ctx.event_stream_enabled());
+
+    void *before = ctx.alloc_bytes(64);
+    ctx.free_bytes(before);
+
+    ctx.set_event_stream(true);
+    void *p = ctx.alloc_bytes(200, 7);
+    void *batch[8];
+    size_t got = ctx.alloc_batch(32, batch, 8, 2);
+    assert(got == 8);
+    ctx.free_batch(batch, got);
+    ctx.free_bytes(p);
+    ctx.set_event_stream(false);
+
+    Cell::AllocEvent events[64];
+    size_t n = ctx.drain_events(events, 64);
+    assert(n == 18 && "Only events recorded while the stream was on");
+
+    assert(events[0].op == Cell::AllocEventOp::kAlloc && events[0].ptr == p);
+    assert(events[0].size == 200 && events[0].size_class == 4 && events[0].tag == 7);
+    for (size_t i = 1; i <= 8; ++i) {
+        assert(events[i].op == Cell::AllocEventOp::kAlloc && events[i].size_class == 1);
+        assert(events[i + 8].op == Cell::AllocEventOp::kFree && events[i + 8].size == 32);
+        assert(events[i + 8].tag == 2);
+    }
+    assert(events[17].op == Cell::AllocEventOp::kFree && events[17].ptr == p);
+    assert(events[17].size == 256 && events[17].tag == 7);
+    for (size_t i = 1; i < n; ++i) {
+        assert(events[i].timestamp >= events[i - 1].timestamp);
+    }
+
+    assert(ctx.drain_events(events, 64) == 0 && "Drained events are consumed");
+    assert(ctx.dropped_events() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 8: A full ring drops events instead of blocking
+TEST(EventRingOverflow) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.event_ring_capacity = 16;
+
+    Cell::Context ctx(config);
+    ctx.set_event_stream(true);
+    for (int i = 0; i < 20; ++i) {
+        ctx.free_bytes(ctx.alloc_bytes(64));
+    }
+
+    Cell::AllocEvent events[64];
+    size_t n = ctx.drain_events(events, 10);
+    assert(n == 10 && "Drain respects max_events");
+    n += ctx.drain_events(events, 64);
+    assert(n == 16 && "Ring holds its capacity");
+    assert(ctx.dropped_events() == 24);
+
+    // Draining makes room again
+    ctx.free_bytes(ctx.alloc_bytes(64));
+    assert(ctx.drain_events(events, 64) == 2);
+
+    printf("  PASSED\n");
+}
+
+// Test 9: Each thread records into its own ring
+TEST(EventStreamMultiThreaded) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    ctx.set_event_stream(true);
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                ctx.free_bytes(ctx.alloc_bytes(64, static_cast<uint8_t>(t)));
+            }
+            ctx.flush_tls_caches();
+        });
+    }
+
+    // Drain concurrently with the producers, then collect the rest
+    std::vector<Cell::AllocEvent> events(1024);
+    size_t total = 0;
+    size_t allocs_per_tag[kThreads] = {};
+    auto drain = [&]() {
+        size_t n = ctx.drain_events(events.data(), events.size());
+        for (size_t i = 0; i < n; ++i) {
+            if (events[i].op == Cell::AllocEventOp::kAlloc) {
+                allocs_per_tag[events[i].tag]++;
+            }
+        }
+        total += n;
+        return n;
+    };
+    while (total < kThreads * kPerThread * 2 && ctx.dropped_events() == 0) {
+        if (drain() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    drain();
+
+    assert(total + ctx.dropped_events() == kThreads * kPerThread * 2);
+    if (ctx.dropped_events() == 0) {
+        for (int t = 0; t < kThreads; ++t) {
+            assert(allocs_per_tag[t] == kPerThread);
+        }
+    }
+    printf("  %zu events drained, %zu dropped\n", total, ctx.dropped_events());
+
+    printf("  PASSED\n");
+}
+
+// Test 10: A thread keeps one ring per Context when alternating between them
+TEST(EventStreamAlternatingContexts) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.event_ring_capacity = 16;
+
+    Cell::Context a(config);
+    Cell::Context b(config);
+    a.set_event_stream(true);
+    b.set_event_stream(true);
+    for (int i = 0; i < 20; ++i) {
+        a.free_bytes(a.alloc_bytes(6000));
+        b.free_bytes(b.alloc_bytes(6000));
+    }
+
+    // Fresh rings on every switch would have held all 40 events without drops
+    Cell::AllocEvent events[64];
+    assert(a.drain_events(events, 64) == 16 && a.dropped_events() == 24);
+    assert(b.drain_events(events, 64) == 16 && b.dropped_events() == 24);
+
+    printf("  PASSED\n");
+}
+
 #else
 
 // When instrumentation is disabled
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <vector>
@@ -197,6 +198,84 @@ TEST(ReallocAlignedAlloc) {
     printf("  PASSED\n");
 }
 
+// =============================================================================
+// Aligned Mapping Tests
+// =============================================================================
+
+TEST(AlignedMappingAlignments) {
+    Cell::LargeAllocRegistry registry;
+
+    const size_t alignments[] = {64, 4096, 64 * 1024, 1024 * 1024, 2 * 1024 * 1024,
+                                 8 * 1024 * 1024};
+
+    for (size_t alignment : alignments) {
+        const size_t size = 3 * 1024 * 1024 + 123;
+        auto *ptr = static_cast<uint8_t *>(registry.alloc_aligned(size, alignment, 5));
+        assert(ptr != nullptr);
+        assert(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+
+        // Whole range must be writable, including the page-rounded tail
+        std::memset(ptr, 0x5A, registry.get_alloc_size(ptr));
+        registry.free(ptr);
+    }
+
+    assert(registry.allocation_count() == 0);
+    assert(registry.bytes_allocated() == 0);
+    printf("  PASSED\n");
+}
+
+TEST(AlignedMappingPageRounding) {
+    Cell::LargeAllocRegistry registry;
+
+    // Small aligned requests still come from page-granular OS mappings
+    void *ptr = registry.alloc_aligned(100, 256, 0, false);
+    assert(ptr != nullptr);
+    assert(reinterpret_cast<uintptr_t>(ptr) % 256 == 0);
+
+    size_t accounted = registry.get_alloc_size(ptr);
+    assert(accounted == Cell::LargeAllocRegistry::rounded_size(100));
+    assert(accounted >= 100);
+    assert(registry.bytes_allocated() == accounted);
+
+    registry.free(ptr);
+    assert(registry.bytes_allocated() == 0);
+    printf("  PASSED\n");
+}
+
+TEST(AlignedReallocPreservesAlignment) {
+    Cell::LargeAllocRegistry registry;
+
+    const size_t alignment = 4 * 1024 * 1024;
+    void *ptr = registry.alloc_aligned(3 * 1024 * 1024, alignment, 7);
+    assert(ptr != nullptr);
+
+    void *grown = registry.realloc_bytes(ptr, 9 * 1024 * 1024, 7);
+    assert(grown != nullptr);
+    assert(reinterpret_cast<uintptr_t>(grown) % alignment == 0);
+
+    registry.free(grown);
+    assert(registry.allocation_count() == 0);
+    printf("  PASSED\n");
+}
+
+TEST(AlignedSizeOverflowRejected) {
+    Cell::LargeAllocRegistry registry;
+
+    // Page rounding and alignment slack must not wrap to a tiny mapping
+    assert(Cell::LargeAllocRegistry::rounded_size(SIZE_MAX - 100) == 0);
+    assert(registry.alloc_aligned(SIZE_MAX - 100, 4 * 1024 * 1024) == nullptr);
+    assert(registry.alloc_aligned(SIZE_MAX - 100, 64) == nullptr);
+    assert(registry.alloc(SIZE_MAX - 3) == nullptr);
+
+    size_t mapping_size = 1;
+    bool huge = true;
+    assert(Cell::LargeAllocRegistry::map_aligned(SIZE_MAX - 4096, 1024 * 1024 * 1024, false,
+                                                 mapping_size, huge) == nullptr);
+    assert(mapping_size == 0 && !huge);
+    assert(registry.allocation_count() == 0);
+    printf("  PASSED\n");
+}
+
 int main() {
     printf("Large Allocation Realloc Tests\n");
     printf("===============================\n\n");
@@ -0,0 +1,251 @@
+#include "cell/context.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Simple test helper
+#define TEST(name)                                                                                 \
+    void test_##name();                                                                            \
+    struct Register##name {                                                                        \
+        Register##name() { tests.push_back({#name, test_##name}); }                                \
+    } reg_##name;                                                                                  \
+    void test_##name()
+
+struct TestCase {
+    const char *name;
+    void (*fn)();
+};
+std::vector<TestCase> tests;
+
+namespace {
+    constexpr uint8_t kGuardedTag = 7;
+
+    Cell::Config guard_config() {
+        Cell::Config config;
+        config.reserve_size = 64 * 1024 * 1024;
+        return config;
+    }
+
+    /** @brief Returns true if the block's last aligned byte ends at a page boundary. */
+    bool ends_at_page(void *ptr, size_t size, size_t alignment) {
+        size_t page = Cell::LargeAllocRegistry::rounded_size(1);
+        size_t padded = (size + alignment - 1) & ~(alignment - 1);
+        return (reinterpret_cast<uintptr_t>(ptr) + padded) % page == 0;
+    }
+} // namespace
+
+// =============================================================================
+// Page Guard Tests
+// =============================================================================
+
+// Test 1: Guarded tags get a dedicated block that ends at the guard page
+TEST(GuardedTagPlacement) {
+    Cell::Context ctx(guard_config());
+    ctx.set_page_guard_tag(kGuardedTag, true);
+    assert(ctx.page_guard_tag(kGuardedTag));
+
+    void *guarded = ctx.alloc_bytes(100, kGuardedTag);
+    assert(guarded != nullptr);
+    assert(ctx.page_guarded_count() == 1);
+    assert(ends_at_page(guarded, 100, 8) && "Block should end against the guard page");
+    std::memset(guarded, 0x5A, 100);
+
+    void *aligned = ctx.alloc_bytes(100, kGuardedTag, 16);
+    assert(ends_at_page(aligned, 100, 16));
+    assert(reinterpret_cast<uintptr_t>(aligned) % 16 == 0);
+
+    void *plain = ctx.alloc_bytes(100, kGuardedTag + 1);
+    assert(plain != nullptr && ctx.page_guarded_count() == 2 && "Other tags stay unguarded");
+
+    ctx.free_bytes(guarded);
+    ctx.free_bytes(aligned);
+    ctx.free_bytes(plain);
+    assert(ctx.page_guarded_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 2: Writing one byte past a guarded block faults at once
+TEST(OverflowFaults) {
+#if defined(__unix__) || defined(__APPLE__)
+    Cell::Context ctx(guard_config());
+    ctx.set_page_guard_tag(kGuardedTag, true);
+    auto *block = static_cast<volatile uint8_t *>(ctx.alloc_bytes(64, kGuardedTag));
+    assert(block != nullptr);
+
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        block[63] = 1; // Last byte is writable
+        block[64] = 1; // First byte past the end hits the guard page
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFSIGNALED(status) && "The overflow should have faulted");
+    printf("  child stopped by signal %d\n", WTERMSIG(status));
+
+    ctx.free_bytes(const_cast<uint8_t *>(block));
+#else
+    printf("  (fork not available, skipped)\n");
+#endif
+    printf("  PASSED\n");
+}
+
+// Test 3: A sample rate guards one in N allocations of every tag
+TEST(SampledGuards) {
+    Cell::Config config = guard_config();
+    config.page_guard_sample_rate = 4;
+    Cell::Context ctx(config);
+    assert(ctx.page_guard_sample_rate() == 4);
+
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 400; ++i) {
+        ptrs.push_back(ctx.alloc_bytes(48, static_cast<uint8_t>(i)));
+        assert(ptrs.back() != nullptr);
+    }
+    assert(ctx.page_guarded_count() == 100);
+
+    // Turning sampling off restores the normal paths; live guarded blocks still free
+    ctx.set_page_guard_sample_rate(0);
+    void *plain = ctx.alloc_bytes(48);
+    assert(ctx.page_guarded_count() == 100);
+    ctx.free_bytes(plain);
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(ctx.page_guarded_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// Test 4: Fixed, batch and realloc paths honor guarded tags
+TEST(FixedBatchAndRealloc) {
+    Cell::Context ctx(guard_config());
+    ctx.set_page_guard_tag(kGuardedTag, true);
+
+    void *fixed = ctx.alloc_fixed<64>(kGuardedTag);
+    assert(fixed != nullptr && ctx.page_guarded_count() == 1);
+    void *unguarded = ctx.alloc_fixed<64>();
+    assert(ctx.page_guarded_count() == 1);
+    ctx.free_fixed<64>(fixed);
+    ctx.free_fixed<64>(unguarded);
+    assert(ctx.page_guarded_count() == 0);
+
+    void *batch[16];
+    size_t got = ctx.alloc_batch(128, batch, 16, kGuardedTag);
+    assert(got == 16 && ctx.page_guarded_count() == 16);
+    ctx.free_batch(batch, got);
+    assert(ctx.page_guarded_count() == 0);
+
+    auto *p = static_cast<uint8_t *>(ctx.alloc_bytes(200, kGuardedTag));
+    for (int i = 0; i < 200; ++i) {
+        p[i] = static_cast<uint8_t>(i);
+    }
+    p = static_cast<uint8_t *>(ctx.realloc_bytes(p, 5000, kGuardedTag));
+    assert(p != nullptr && ends_at_page(p, 5000, 8));
+    for (int i = 0; i < 200; ++i) {
+        assert(p[i] == static_cast<uint8_t>(i) && "Realloc must preserve contents");
+    }
+    p = static_cast<uint8_t *>(ctx.realloc_bytes(p, 300, 0));
+    assert(p != nullptr && ctx.page_guarded_count() == 0 && "Tag 0 moves back to a bin");
+    assert(p[199] == 199);
+    ctx.free_bytes(p);
+
+    ctx.set_page_guard_tag(kGuardedTag, false);
+    void *q = ctx.alloc_bytes(100, kGuardedTag);
+    assert(ctx.page_guarded_count() == 0 && "Disabled tags use the normal paths");
+    ctx.free_bytes(q);
+
+    printf("  PASSED\n");
+}
+
+// Test 5: Aligned allocations honor guarded tags and sampling up to page alignment
+TEST(AlignedGuards) {
+    Cell::Context ctx(guard_config());
+    ctx.set_page_guard_tag(kGuardedTag, true);
+    size_t page = Cell::LargeAllocRegistry::rounded_size(1);
+
+    void *small = ctx.alloc_aligned(64, 64, kGuardedTag);
+    assert(small != nullptr && ctx.page_guarded_count() == 1);
+    assert(reinterpret_cast<uintptr_t>(small) % 64 == 0 && ends_at_page(small, 64, 64));
+
+    void *big = ctx.alloc_aligned(100 * 1024, page, kGuardedTag);
+    assert(big != nullptr && ctx.page_guarded_count() == 2);
+    assert(reinterpret_cast<uintptr_t>(big) % page == 0 && ends_at_page(big, 100 * 1024, page));
+    std::memset(big, 0x5A, 100 * 1024);
+
+    void *wide = ctx.alloc_aligned(100 * 1024, 2 * page, kGuardedTag);
+    assert(wide != nullptr && ctx.page_guarded_count() == 2 && "Beyond a page is not guarded");
+    assert(reinterpret_cast<uintptr_t>(wide) % (2 * page) == 0);
+    std::memset(wide, 0x5A, 100 * 1024);
+
+    // Small sizes at 2-page alignment come from a bin, also unguarded
+    std::vector<void *> narrow;
+    for (int i = 0; i < 64; ++i) {
+        void *p = ctx.alloc_aligned(16, 2 * page, kGuardedTag);
+        assert(p != nullptr && reinterpret_cast<uintptr_t>(p) % (2 * page) == 0);
+        std::memset(p, 0x5A, 16);
+        narrow.push_back(p);
+    }
+    assert(ctx.page_guarded_count() == 2);
+    for (void *p : narrow) {
+        ctx.free_bytes(p);
+    }
+
+    ctx.free_bytes(small);
+    ctx.free_bytes(big);
+    ctx.free_bytes(wide);
+    assert(ctx.page_guarded_count() == 0);
+
+    ctx.set_page_guard_tag(kGuardedTag, false);
+    ctx.set_page_guard_sample_rate(2);
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 10; ++i) {
+        ptrs.push_back(ctx.alloc_aligned(40 * 1024, 256));
+        assert(ptrs.back() != nullptr && reinterpret_cast<uintptr_t>(ptrs.back()) % 256 == 0);
+    }
+    assert(ctx.page_guarded_count() == 5);
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+    assert(ctx.page_guarded_count() == 0);
+
+    printf("  PASSED\n");
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main() {
+    printf("Page Guard Tests\n");
+    printf("================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    for (const auto &test : tests) {
+        printf("Running %s...\n", test.name);
+        try {
+            test.fn();
+            ++passed;
+        } catch (...) {
+            printf("  FAILED (exception)\n");
+            ++failed;
+        }
+    }
+
+    printf("\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include "cell/pressure.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simple test helper
+#define TEST(name)                                                                                 \
+    void test_##name();                                                                            \
+    struct Register##name {                                                                        \
+        Register##name() { tests.push_back({#name, test_##name}); }                                \
+    } reg_##name;                                                                                  \
+    void test_##name()
+
+struct TestCase {
+    const char *name;
+    void (*fn)();
+};
+std::vector<TestCase> tests;
+
+// Stand-in for /proc/pressure/memory or memory.events
+static std::string source_path(const char *name) {
+    return std::string("cell_test_pressure_") + name + ".txt";
+}
+
+static void write_source(const std::string &path, const char *text) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    assert(file != nullptr);
+    std::fputs(text, file);
+    std::fclose(file);
+}
+
+static const char *kPsiIdle = "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"
+                              "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+static const char *kPsiModerate = "some avg10=15.50 avg60=3.00 avg300=1.00 total=123456\n"
+                                  "full avg10=2.00 avg60=0.50 avg300=0.10 total=4567\n";
+static const char *kPsiCritical = "some avg10=55.00 avg60=20.00 avg300=5.00 total=999999\n"
+                                  "full avg10=30.00 avg60=9.00 avg300=2.00 total=88888\n";
+
+// Allocates a superblock's worth of cells plus sub-cell blocks, then frees
+// them so the Context holds warm, cached, and fully free memory.
+static void churn(Cell::Context &ctx) {
+    std::vector<Cell::CellData *> cells;
+    for (size_t i = 0; i < Cell::kCellsPerSuperblock * 2; ++i) {
+        Cell::CellData *cell = ctx.alloc_cell(0);
+        assert(cell != nullptr);
+        cells.push_back(cell);
+    }
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 4096; ++i) {
+        void *p = ctx.alloc_bytes(256, 1);
+        assert(p != nullptr);
+        blocks.push_back(p);
+    }
+    for (auto *cell : cells) {
+        ctx.free_cell(cell);
+    }
+    for (void *p : blocks) {
+        ctx.free_bytes(p);
+    }
+}
+
+// =============================================================================
+// Context::trim
+// =============================================================================
+
+TEST(TrimLevels) {
+    Cell::Context ctx;
+    churn(ctx);
+
+    assert(ctx.trim(Cell::PressureLevel::kNone) == 0);
+
+    size_t moderate = ctx.trim(Cell::PressureLevel::kModerate);
+    assert(moderate > 0 && "Moderate trim should release free superblocks");
+
+    // Only the retained depot magazines are still committed
+    size_t retained = Cell::kRetainedCellMagazines * Cell::kCellMagazineSize * Cell::kCellSize;
+    assert(ctx.committed_bytes() <= retained);
+
+    size_t critical = ctx.trim(Cell::PressureLevel::kCritical);
+    printf("  moderate released %zu bytes, critical %zu bytes\n", moderate, critical);
+    assert(ctx.committed_bytes() == 0 && "Critical trim should release every free cell");
+
+    // The Context still works afterwards
+    void *p = ctx.alloc_bytes(256, 1);
+    assert(p != nullptr);
+    std::memset(p, 0xAB, 256);
+    ctx.free_bytes(p);
+
+    printf("  PASSED\n");
+}
+
+// =============================================================================
+// PSI Source
+// =============================================================================
+
+TEST(PsiLevels) {
+    std::string path = source_path("psi");
+    Cell::Context ctx;
+
+    Cell::PressureMonitorConfig config;
+    config.path = path;
+    Cell::PressureMonitor monitor(ctx, config);
+
+    write_source(path, kPsiIdle);
+    assert(monitor.poll_once() == Cell::PressureLevel::kNone);
+
+    write_source(path, kPsiModerate);
+    churn(ctx);
+    assert(monitor.poll_once() == Cell::PressureLevel::kModerate);
+    assert(monitor.bytes_reclaimed() > 0);
+
+    write_source(path, kPsiCritical);
+    assert(monitor.poll_once() == Cell::PressureLevel::kCritical);
+    assert(monitor.last_level() == Cell::PressureLevel::kCritical);
+
+    std::remove(path.c_str());
+    assert(monitor.poll_once() == Cell::PressureLevel::kNone && "Missing file means no pressure");
+
+    printf("  PASSED\n");
+}
+
+// =============================================================================
+// cgroup memory.events Source
+// =============================================================================
+
+TEST(CgroupEventsDeltas) {
+    std::string path = source_path("events");
+    Cell::Context ctx;
+
+    Cell::PressureMonitorConfig config;
+    config.path = path;
+    config.source = Cell::PressureSource::kCgroupEvents;
+    Cell::PressureMonitor monitor(ctx, config);
+
+    // Non-zero counters on the first poll are history, not new pressure
+    write_source(path, "low 0\nhigh 7\nmax 1\noom 0\noom_kill 0\noom_group_kill 0\n");
+    assert(monitor.poll_once() == Cell::PressureLevel::kNone);
+    assert(monitor.poll_once() == Cell::PressureLevel::kNone);
+
+    write_source(path, "low 0\nhigh 9\nmax 1\noom 0\noom_kill 0\noom_group_kill 0\n");
+    assert(monitor.poll_once() == Cell::PressureLevel::kModerate);
+
+    write_source(path, "low 0\nhigh 9\nmax 2\noom 0\noom_kill 0\noom_group_kill 0\n");
+    assert(monitor.poll_once() == Cell::PressureLevel::kCritical);
+
+    write_source(path, "low 0\nhigh 9\nmax 2\noom 0\noom_kill 1\noom_group_kill 0\n");
+    assert(monitor.poll_once() == Cell::PressureLevel::kCritical);
+
+    assert(monitor.poll_once() == Cell::PressureLevel::kNone);
+
+    std::remove(path.c_str());
+    printf("  PASSED\n");
+}
+
+// =============================================================================
+// Background Thread
+// =============================================================================
+
+TEST(BackgroundMonitorTrims) {
+    std::string path = source_path("thread");
+    write_source(path, kPsiCritical);
+
+    Cell::Context ctx;
+    Cell::PressureMonitorConfig config;
+    config.path = path;
+    config.interval = std::chrono::milliseconds(5);
+    Cell::PressureMonitor monitor(ctx, config);
+
+    assert(monitor.start());
+    assert(!monitor.start() && "Second start should be refused");
+
+    // Keep allocating while the monitor trims from its own thread
+    for (int round = 0; round < 50; ++round) {
+        churn(ctx);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    monitor.stop();
+    assert(!monitor.running());
+    assert(monitor.last_level() == Cell::PressureLevel::kCritical);
+    assert(monitor.bytes_reclaimed() > 0);
+
+    std::remove(path.c_str());
+    printf("  PASSED\n");
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main() {
+    printf("Memory Pressure Monitor Tests\n");
+    printf("=============================\n\n");
+
+    int passed = 0;
+    int failed = 0;
+
+    for (const auto &test : tests) {
+        printf("Running %s...\n", test.name);
+        try {
+            test.fn();
+            ++passed;
+        } catch (...) {
+            printf("  FAILED (exception)\n");
+            ++failed;
+        }
+    }
+
+    printf("\n");
+    printf("Results: %d passed, %d failed\n", passed, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -1,7 +1,12 @@
 #include "cell/context.h"
+#include "cell/stats_exporter.h"
 
 #include <cassert>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
 #include <vector>
 
 // Simple test helper
@@ -32,19 +37,21 @@ TEST(StatsBasicTracking) {
     Cell::Context ctx(config);
 
     // Initial state
-    const auto &stats = ctx.get_stats();
+    Cell::MemoryStats stats = ctx.get_stats();
     assert(stats.current_allocated == 0 && "Should start at zero");
 
     // Allocate some memory
     void *p1 = ctx.alloc_bytes(100, 1);
     assert(p1 != nullptr);
 
+    stats = ctx.get_stats();
     assert(stats.current_allocated > 0 && "Should have allocated");
     assert(stats.total_allocated > 0 && "Total should increase");
     assert(stats.subcell_allocs >= 1 && "Should have sub-cell alloc");
 
     // Free it
     ctx.free_bytes(p1);
+    stats = ctx.get_stats();
     assert(stats.current_allocated == 0 && "Should be zero after free");
     assert(stats.subcell_frees >= 1 && "Should have sub-cell free");
 
@@ -57,26 +64,26 @@ TEST(StatsPeakTracking) {
     config.reserve_size = 64 * 1024 * 1024;
 
     Cell::Context ctx(config);
-    const auto &stats = ctx.get_stats();
 
     // Allocate
     void *p1 = ctx.alloc_bytes(1000, 0);
     void *p2 = ctx.alloc_bytes(2000, 0);
 
-    size_t peak_after_alloc = stats.peak_allocated.load();
+    size_t peak_after_alloc = ctx.get_stats().peak_allocated;
+    assert(peak_after_alloc >= ctx.get_stats().current_allocated && "Peak covers current");
 
     // Free one
     ctx.free_bytes(p1);
 
     // Peak should not decrease
-    assert(stats.peak_allocated >= peak_after_alloc && "Peak should not decrease");
+    assert(ctx.get_stats().peak_allocated >= peak_after_alloc && "Peak should not decrease");
 
     ctx.free_bytes(p2);
 
     // Peak should still be preserved
-    assert(stats.peak_allocated >= peak_after_alloc && "Peak should persist after free");
+    assert(ctx.get_stats().peak_allocated >= peak_after_alloc && "Peak should persist after free");
 
-    printf("  Peak: %zu bytes\n", stats.peak_allocated.load());
+    printf("  Peak: %zu bytes\n", ctx.get_stats().peak_allocated);
     printf("  PASSED\n");
 }
 
@@ -86,15 +93,15 @@ TEST(StatsPerTagTracking) {
     config.reserve_size = 64 * 1024 * 1024;
 
     Cell::Context ctx(config);
-    const auto &stats = ctx.get_stats();
 
     // Allocate with different tags
     void *p1 = ctx.alloc_bytes(500, 10);
     void *p2 = ctx.alloc_bytes(1000, 20);
     void *p3 = ctx.alloc_bytes(1500, 10); // Same tag as p1
 
-    size_t tag10 = stats.per_tag_current[10].load();
-    size_t tag20 = stats.per_tag_current[20].load();
+    Cell::MemoryStats stats = ctx.get_stats();
+    size_t tag10 = stats.per_tag_current[10];
+    size_t tag20 = stats.per_tag_current[20];
 
     printf("  Tag 10: %zu bytes\n", tag10);
     printf("  Tag 20: %zu bytes\n", tag20);
@@ -115,26 +122,26 @@ TEST(StatsAllocatorTypes) {
     config.reserve_size = 128 * 1024 * 1024;
 
     Cell::Context ctx(config);
-    const auto &stats = ctx.get_stats();
 
     // Sub-cell allocation
     void *p1 = ctx.alloc_bytes(100, 0);
-    assert(stats.subcell_allocs >= 1);
+    assert(ctx.get_stats().subcell_allocs >= 1);
 
     // Full cell allocation
     void *p2 = ctx.alloc_bytes(10 * 1024, 0); // 10KB -> full cell
-    assert(stats.cell_allocs >= 1);
+    assert(ctx.get_stats().cell_allocs >= 1);
 
     // Buddy allocation
     void *p3 = ctx.alloc_bytes(64 * 1024, 0); // 64KB -> buddy
-    assert(stats.buddy_allocs >= 1);
+    assert(ctx.get_stats().buddy_allocs >= 1);
 
     // Large allocation
     void *p4 = ctx.alloc_bytes(4 * 1024 * 1024, 0); // 4MB -> large
+    Cell::MemoryStats stats = ctx.get_stats();
     assert(stats.large_allocs >= 1);
 
-    printf("  SubCell: %zu, Cell: %zu, Buddy: %zu, Large: %zu\n", stats.subcell_allocs.load(),
-           stats.cell_allocs.load(), stats.buddy_allocs.load(), stats.large_allocs.load());
+    printf("  SubCell: %zu, Cell: %zu, Buddy: %zu, Large: %zu\n", stats.subcell_allocs,
+           stats.cell_allocs, stats.buddy_allocs, stats.large_allocs);
 
     ctx.free_bytes(p1);
     ctx.free_bytes(p2);
@@ -173,17 +180,18 @@ TEST(StatsReset) {
     config.reserve_size = 64 * 1024 * 1024;
 
     Cell::Context ctx(config);
-    const auto &stats = ctx.get_stats();
 
     // Make allocations
     void *p = ctx.alloc_bytes(1000, 0);
-    assert(stats.total_allocated > 0);
+    assert(ctx.get_stats().total_allocated > 0);
 
     ctx.free_bytes(p);
 
     // Reset
     ctx.reset_stats();
 
+    Cell::MemoryStats stats = ctx.get_stats();
+
     assert(stats.total_allocated == 0 && "Total should be reset");
     assert(stats.total_freed == 0 && "Freed should be reset");
     assert(stats.peak_allocated == 0 && "Peak should be reset");
@@ -191,6 +199,196 @@ TEST(StatsReset) {
     printf("  PASSED\n");
 }
 
+// Test 7: Sharded counters sum exactly across threads
+TEST(StatsShardedAcrossThreads) {
+    Cell::Config config;
+    config.reserve_size = 256 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+    const int kThreads = 8;
+    const size_t kBlocks = 2048;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&ctx, t]() {
+            std::vector<void *> ptrs(kBlocks);
+            size_t got = ctx.alloc_batch(64, ptrs.data(), kBlocks, static_cast<uint8_t>(t));
+            assert(got == kBlocks);
+            for (void *p : ptrs) {
+                ctx.free_bytes(p);
+            }
+            ctx.flush_tls_caches();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    Cell::MemoryStats stats = ctx.get_stats();
+    assert(stats.subcell_allocs == kThreads * kBlocks && "Batch counts every block once");
+    assert(stats.subcell_frees == kThreads * kBlocks);
+    assert(stats.total_allocated == kThreads * kBlocks * 64);
+    assert(stats.current_allocated == 0);
+
+    // Each batch of 128KB crosses a peak sample boundary while it is held
+    assert(stats.peak_allocated >= kBlocks * 64);
+    printf("  Peak: %zu bytes\n", stats.peak_allocated);
+    printf("  PASSED\n");
+}
+
+// Test 8: Per size-class counters and OS activity
+TEST(StatsSizeClassCounters) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    Cell::Context ctx(config);
+#ifdef CELL_DEBUG_GUARDS
+    // Guard bytes on both sides move the block up a size class
+    const size_t bin = Cell::get_size_class_fast(48 + 2 * Cell::kGuardSize);
+#else
+    const size_t bin = Cell::get_size_class_fast(48);
+#endif
+
+    std::vector<void *> ptrs;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            ptrs.push_back(ctx.alloc_bytes(48, 0));
+        }
+        for (void *p : ptrs) {
+            ctx.free_bytes(p);
+        }
+        ptrs.clear();
+    }
+
+    Cell::MemoryStats stats = ctx.get_stats();
+    const Cell::BinStats &b = stats.bins[bin];
+    assert(b.allocs == 200 && b.allocs == b.tls_hits + b.tls_misses);
+    assert(b.requested_bytes == 200 * 48);
+    assert(b.rounded_bytes == 200 * Cell::kSizeClasses[bin]);
+#ifndef CELL_DEBUG_GUARDS
+    // Guarded builds bypass the thread cache
+    assert(b.tls_misses >= 1 && "First allocation misses the empty thread cache");
+    assert(b.tls_hits > b.tls_misses && "Second round is served from the thread cache");
+    assert(b.refill_batches >= 1);
+#endif
+    assert(b.cells_carved >= 1);
+    assert(b.lock_contended == 0 && "A single thread never finds the bin lock held");
+    assert(stats.subcell_allocs == 200);
+    assert(stats.superblock_commits >= 1);
+    size_t os_calls = stats.os_calls;
+
+    // Trimming hands the empty cells back and releases their pages
+    ctx.trim(Cell::PressureLevel::kCritical);
+    stats = ctx.get_stats();
+    assert(stats.bins[bin].cells_returned == stats.bins[bin].cells_carved);
+    assert(stats.os_calls > os_calls);
+
+    printf("  hits %zu, misses %zu, refills %zu, carved %zu, OS calls %zu\n",
+           stats.bins[bin].tls_hits, stats.bins[bin].tls_misses, stats.bins[bin].refill_batches,
+           stats.bins[bin].cells_carved, stats.os_calls);
+    printf("  PASSED\n");
+}
+
+// Test 9: JSON and Prometheus serialization
+TEST(StatsSerializers) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+#ifdef CELL_DEBUG_GUARDS
+    const std::string kSmallBlock = "256"; // 100 bytes plus two 16-byte guards
+#else
+    const std::string kSmallBlock = "128";
+#endif
+
+    Cell::Context ctx(config);
+    void *small = ctx.alloc_bytes(100, 7);
+    void *buddy = ctx.alloc_bytes(64 * 1024, 0);
+
+    Cell::MemoryStats stats = ctx.get_stats();
+    assert(stats.reserved_bytes > 0);
+    assert(stats.cell_committed_bytes > 0);
+    assert(stats.buddy_committed_bytes > 0);
+
+    std::string json = stats.to_json();
+    assert(json.front() == '{' && json.back() == '}');
+    assert(json.find("\"current_allocated\":" + std::to_string(stats.current_allocated)) !=
+           std::string::npos);
+    assert(json.find("\"subcell\":{\"allocs\":1,\"frees\":0}") != std::string::npos);
+    assert(json.find("{\"size\":" + kSmallBlock + ",\"allocs\":1,\"requested_bytes\":100") !=
+           std::string::npos);
+    assert(json.find("\"tags\":{\"0\":") != std::string::npos);
+    assert(json.find("\"7\":" + kSmallBlock) != std::string::npos);
+
+    std::string prom = stats.to_prometheus("app_cell");
+    assert(prom.find("# TYPE app_cell_allocated_bytes_total counter\n") != std::string::npos);
+    assert(prom.find("app_cell_allocs_total{tier=\"buddy\"} 1\n") != std::string::npos);
+    assert(prom.find("app_cell_bin_lock_contended_total{size=\"" + kSmallBlock + "\"} 0\n") !=
+           std::string::npos);
+    assert(prom.find("app_cell_bin_requested_bytes_total{size=\"" + kSmallBlock + "\"} 100\n") !=
+           std::string::npos);
+    assert(prom.find("app_cell_tag_current_bytes{tag=\"7\"} " + kSmallBlock + "\n") !=
+           std::string::npos);
+    assert(prom.back() == '\n');
+
+    ctx.free_bytes(small);
+    ctx.free_bytes(buddy);
+    printf("  JSON %zu bytes, Prometheus %zu bytes\n", json.size(), prom.size());
+    printf("  PASSED\n");
+}
+
+// Test 10: StatsExporter writes files and invokes the callback
+TEST(StatsExporterOutput) {
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    Cell::Context ctx(config);
+
+    const char *path = "cell_test_stats_export.prom";
+    size_t callbacks = 0;
+    size_t last_current = 0;
+
+    Cell::StatsExporterConfig exporter_config;
+    exporter_config.path = path;
+    exporter_config.format = Cell::StatsFormat::kPrometheus;
+    exporter_config.interval = std::chrono::milliseconds(2);
+    exporter_config.callback = [&](const Cell::MemoryStats &stats) {
+        ++callbacks;
+        last_current = stats.current_allocated;
+    };
+    Cell::StatsExporter exporter(ctx, exporter_config);
+
+    void *p = ctx.alloc_bytes(256, 0);
+    assert(exporter.export_once());
+    assert(callbacks == 1 && last_current >= 256);
+    assert(last_current == ctx.get_stats().current_allocated);
+
+    std::FILE *file = std::fopen(path, "r");
+    assert(file != nullptr);
+    char text[256] = {};
+    size_t len = std::fread(text, 1, sizeof(text) - 1, file);
+    std::fclose(file);
+    assert(len > 0 && std::strncmp(text, "# HELP cell_allocated_bytes_total", 33) == 0);
+
+    // Background exports run while this thread keeps allocating
+    assert(exporter.start());
+    assert(!exporter.start() && "Second start should be refused");
+    for (int i = 0; i < 20; ++i) {
+        void *q = ctx.alloc_bytes(64, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ctx.free_bytes(q);
+    }
+    while (exporter.export_count() < 3) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    exporter.stop();
+    assert(!exporter.running());
+    assert(callbacks == exporter.export_count());
+
+    ctx.free_bytes(p);
+    std::remove(path);
+    printf("  %zu exports\n", exporter.export_count());
+    printf("  PASSED\n");
+}
+
 #else
 
 // When stats are disabled, just report that
@@ -104,6 +104,31 @@ TEST(AlignmentValidation) {
     printf("  PASSED\n");
 }
 
+// Test 3b: Small aligned requests from the sub-cell and cell tiers
+TEST(SmallAlignedAllocation) {
+    Cell::Context ctx;
+
+    size_t sizes[] = {1, 24, 64, 100, 1000, 4096, 5000, 16000};
+    size_t alignments[] = {16, 32, 64, 128, 256, 1024, 4096};
+
+    std::vector<void *> ptrs;
+    for (size_t size : sizes) {
+        for (size_t align : alignments) {
+            void *p = ctx.alloc_aligned(size, align);
+            assert(p != nullptr && "Small aligned allocation should succeed");
+            assert((reinterpret_cast<uintptr_t>(p) % align) == 0 && "Alignment violated");
+            std::memset(p, 0xCD, size);
+            ptrs.push_back(p);
+        }
+    }
+
+    for (void *p : ptrs) {
+        ctx.free_bytes(p);
+    }
+
+    printf("  PASSED (%zu allocations)\n", ptrs.size());
+}
+
 // Test 4: Buddy tier boundary (around 32KB and 2MB)
 TEST(BuddyBoundaries) {
     Cell::Context ctx;
@@ -1,3 +1,4 @@
+#include "cell/arena.h"
 #include "cell/context.h"
 
 #include <atomic>
@@ -670,6 +671,230 @@ TEST(StlAllocatorRebind) {
     printf("  PASSED\n");
 }
 
+// Test 25: Cache policy comes from Config
+TEST(CachePolicyFromConfig) {
+    auto churn = [](Cell::Context &ctx) {
+        std::vector<void *> ptrs;
+        for (size_t i = 0; i < 300; ++i) {
+            for (size_t size : {64, 4096}) {
+                void *p = ctx.alloc_bytes(size);
+                assert(p != nullptr);
+                std::memset(p, static_cast<int>(i), size);
+                ptrs.push_back(p);
+            }
+        }
+        for (size_t i = 0; i < ptrs.size(); ++i) {
+            assert(static_cast<unsigned char *>(ptrs[i])[0] == static_cast<unsigned char>(i / 2));
+            ctx.free_bytes(ptrs[i]);
+        }
+    };
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    // Defaults: TLS bin caches and warm cells keep cells resident
+    {
+        Cell::Context ctx(config);
+        churn(ctx);
+        ctx.decommit_unused();
+        assert(ctx.committed_bytes() > 0);
+    }
+
+    // No TLS bin caches and no warm cells: every empty cell goes back to the pool
+    config.tls_bin_cache_count = 0;
+    config.warm_cells_per_bin = 0;
+    {
+        Cell::Context ctx(config);
+        churn(ctx);
+        ctx.decommit_unused();
+        assert(ctx.committed_bytes() == 0);
+    }
+
+    // Refill batches larger than the cache are clamped to its capacity
+    config.tls_bin_cache_count = Cell::kTlsBinCacheCount;
+    config.tls_bin_cache_capacity = 4;
+    config.tls_bin_batch_refill = 1000;
+    {
+        Cell::Context ctx(config);
+        churn(ctx);
+        churn(ctx);
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 26: Cell size is selectable per Context
+TEST(ConfigurableCellSize) {
+    auto size_class_of = [](Cell::Context &ctx, void *p) {
+        uintptr_t mask = ~static_cast<uintptr_t>(ctx.cell_size() - 1);
+        return Cell::get_header(p, mask)->size_class;
+    };
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+
+    // 64KB cells: 24KB objects are packed into the 32KB sub-cell bin
+    config.cell_size_log2 = 16;
+    {
+        Cell::Context ctx(config);
+        assert(ctx.cell_size() == 64 * 1024);
+
+        std::vector<void *> ptrs;
+        for (int i = 0; i < 8; ++i) {
+            void *p = ctx.alloc_bytes(24 * 1024);
+            assert(p != nullptr);
+            assert(size_class_of(ctx, p) == Cell::kNumSizeBins - 1);
+            std::memset(p, i, 24 * 1024);
+            ptrs.push_back(p);
+        }
+        for (int i = 0; i < 8; ++i) {
+            assert(static_cast<unsigned char *>(ptrs[i])[24 * 1024 - 1] == i);
+            ctx.free_bytes(ptrs[i]);
+        }
+
+        // Arena cells use the Context's cell size
+        Cell::Arena arena(ctx);
+        void *big = arena.alloc(40 * 1024);
+        assert(big != nullptr);
+        std::memset(big, 0xCD, 40 * 1024);
+        assert(arena.cell_count() == 1);
+    }
+
+    // 4KB cells: anything above 2KB takes a whole cell
+    config.cell_size_log2 = 12;
+    {
+        Cell::Context ctx(config);
+        assert(ctx.cell_size() == 4 * 1024);
+
+        void *small = ctx.alloc_bytes(2048);
+        void *whole = ctx.alloc_bytes(3000);
+        assert(small != nullptr && whole != nullptr);
+        assert(size_class_of(ctx, small) == 7);
+        assert(size_class_of(ctx, whole) == Cell::kFullCellMarker);
+        std::memset(whole, 0xAB, 3000);
+        ctx.free_bytes(small);
+        ctx.free_bytes(whole);
+    }
+
+    // Out-of-range sizes are clamped
+    config.cell_size_log2 = 30;
+    {
+        Cell::Context ctx(config);
+        assert(ctx.cell_size() == (size_t{1} << Cell::kMaxCellSizeLog2));
+    }
+
+    printf("  PASSED\n");
+}
+
+// Test 26b: Contexts with different cell sizes share a thread
+TEST(MixedCellSizesOnOneThread) {
+    auto size_class_of = [](Cell::Context &ctx, void *p) {
+        uintptr_t mask = ~static_cast<uintptr_t>(ctx.cell_size() - 1);
+        return Cell::get_header(p, mask)->size_class;
+    };
+
+    Cell::Config config;
+    config.reserve_size = 64 * 1024 * 1024;
+    config.cell_size_log2 = 16;
+    Cell::Context big(config);
+    config.cell_size_log2 = 12;
+    Cell::Context small(config);
+#ifdef CELL_DEBUG_GUARDS
+    const uint8_t expected_class = Cell::get_size_class_fast(64 + 2 * Cell::kGuardSize);
+#else
+    const uint8_t expected_class = Cell::get_size_class_fast(64);
+#endif
+
+    // Frees leave blocks spanning several 4KB pages in the thread's bin cache
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 200; ++i) {
+        void *p = big.alloc_bytes(64);
+        assert(p != nullptr && size_class_of(big, p) == expected_class);
+        std::memset(p, 0xAA, 64);
+        ptrs.push_back(p);
+    }
+    for (void *p : ptrs) {
+        big.free_bytes(p);
+    }
+
+    // The other Context never sees them, and reads headers with its own cell size
+    ptrs.clear();
+    for (int i = 0; i < 200; ++i) {
+        void *p = small.alloc_fixed<64>();
+        assert(p != nullptr && size_class_of(small, p) == expected_class);
+        std::memset(p, 0xBB, 64);
+        ptrs.push_back(p);
+    }
+    for (void *p : ptrs) {
+        small.free_fixed<64>(p);
+    }
+    void *p = big.alloc_bytes(64);
+    assert(p != nullptr && size_class_of(big, p) == expected_class);
+    big.free_bytes(p);
+
+    printf("  PASSED\n");
+}
+
+// Test 27: alloc_fixed<N> / free_fixed<N> resolve the bin at compile time
+TEST(FixedSizeAllocation) {
+    static_assert(Cell::static_size_class(1) == 0);
+    static_assert(Cell::static_size_class(16) == 0);
+    static_assert(Cell::static_size_class(17) == 1);
+    static_assert(Cell::static_size_class(4096) == 8);
+    static_assert(Cell::static_size_class(Cell::kMaxSizeClass + 1) == Cell::kFullCellMarker);
+
+    Cell::Context ctx;
+#ifdef CELL_DEBUG_GUARDS
+    // Guarded builds route alloc_fixed through alloc_bytes, which pads for guards
+    const uint8_t expected_class = Cell::get_size_class_fast(48 + 2 * Cell::kGuardSize);
+#else
+    const uint8_t expected_class = Cell::get_size_class_fast(48);
+#endif
+
+    // Round trips through the thread's bin cache
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 100; ++i) {
+        void *p = ctx.alloc_fixed<48>();
+        assert(p != nullptr);
+        assert(Cell::get_header(p)->size_class == expected_class);
+        std::memset(p, i, 48);
+        ptrs.push_back(p);
+    }
+    for (int i = 0; i < 100; ++i) {
+        assert(static_cast<unsigned char *>(ptrs[i])[47] == i);
+        ctx.free_fixed<48>(ptrs[i]);
+    }
+
+    // Interchangeable with alloc_bytes / free_bytes of the same size
+    void *a = ctx.alloc_bytes(4096);
+    ctx.free_fixed<4096>(a);
+    void *b = ctx.alloc_fixed<4096>();
+    std::memset(b, 0x5A, 4096);
+    ctx.free_bytes(b);
+
+    // Sizes beyond the cached bins fall back to the out-of-line path
+    void *mid = ctx.alloc_fixed<8192>();
+    void *big = ctx.alloc_fixed<64 * 1024>();
+    assert(mid != nullptr && big != nullptr);
+    std::memset(big, 0x11, 64 * 1024);
+    ctx.free_fixed<8192>(mid);
+    ctx.free_fixed<64 * 1024>(big);
+
+    ctx.free_fixed<64>(nullptr);
+
+    // Typed allocation goes through the same path
+    struct Node {
+        Node *next;
+        int value;
+    };
+    Node *node = ctx.alloc<Node>();
+    assert(node != nullptr);
+    node->value = 42;
+    ctx.free_fixed<sizeof(Node)>(node);
+
+    printf("  PASSED\n");
+}
+
 // =============================================================================
 // Main
 // =============================================================================